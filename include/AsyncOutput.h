@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Output.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * A thread-safe Output which writes all events asynchronously to the underlying output.
+   *
+   * Every thread reporting events appends compact event records to its own single-producer ring buffer without taking
+   * any lock. A single writer thread drains all buffers and replays the events into the underlying output, which
+   * therefore does not need to be thread-safe.
+   *
+   * Semantics:
+   * - The events of a single thread are written in the order they were reported. Since the start and end of a suite
+   *   wait for all previously reported events to be written (see \ref flush), all events of the test-methods of a suite
+   *   are written between the start and the end of the suite.
+   * - Backpressure: A thread reporting an event blocks while its buffer is full, until the writer thread made room.
+   * - Wakeups: The writer thread sleeps until an event is reported to an empty buffer (or a flush is requested), the
+   *   waiting threads until the writer thread wrote the awaited events. The buffer of an exited thread is released
+   *   once all its events are written.
+   * - Flush on exit: The destructor writes all remaining events. If the program is terminated via exit(), all events
+   *   reported so far are written before the program exits. If a test-method is aborted after exceeding its timeout,
+   *   the events are written via \ref flush.
+   * - Crashes: Events not yet written when the program crashes (e.g. on a fatal signal) are lost, use process isolation
+   *   (see ProcessPool) to keep the output of crashing test-methods.
+   * - Exceptions thrown by the underlying output on the writer thread drop the affected event and are rethrown by the
+   *   next call to \ref flush (or the next start or end of a suite).
+   */
+  class AsyncOutput : public Output {
+  public:
+    /*!
+     * \param backingOutput The output to write the events to
+     * \param bufferCapacity The size in bytes of the ring buffer of every thread reporting events
+     */
+    explicit AsyncOutput(Output &backingOutput, std::size_t bufferCapacity = 64 * 1024);
+    AsyncOutput(const AsyncOutput &) = delete;
+    AsyncOutput(AsyncOutput &&) noexcept = delete;
+    ~AsyncOutput() noexcept override;
+
+    AsyncOutput &operator=(const AsyncOutput &) = delete;
+    AsyncOutput &operator=(AsyncOutput &&) noexcept = delete;
+
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    OutputEvents getConsumedEvents() const override;
+    void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+
+    /*!
+     * Waits until all events reported so far (by any thread) are written to the underlying output and flushes it.
+     *
+     * Rethrows the first exception thrown by the underlying output since the last call, if any.
+     */
+    void flush() override;
+    bool isThreadSafe() const override { return true; }
+
+  private:
+    struct Producer;
+
+    Output &realOutput;
+    const std::size_t bufferSize;
+    // distinguishes the instances for the per-thread producer lookup, since addresses can be reused
+    const uint64_t id;
+
+    std::mutex producersMutex;
+    // shared, so threads waiting for the writer can keep using the producers retired meanwhile
+    std::vector<std::shared_ptr<Producer>> producers;
+
+    std::mutex writerMutex;
+    // notifies the writer thread about new events
+    std::condition_variable eventsAvailable;
+    // notifies the threads waiting for free buffer space or a flush about written events
+    std::condition_variable eventsWritten;
+    std::atomic<bool> writerSleeping;
+    std::atomic<unsigned> numWaiting;
+    std::atomic<bool> stopWriter;
+    // flushes of the underlying output requested by and executed for the threads waiting in flush()
+    std::atomic<uint64_t> flushRequests;
+    std::atomic<uint64_t> flushesDone;
+    std::exception_ptr writerError;
+    std::thread writer;
+
+    Producer &getProducer();
+    void write(Producer &producer, const char *data, std::size_t size);
+    void wakeWriter();
+    void waitUntilWritten(Producer &producer, uint64_t position);
+    std::vector<std::shared_ptr<Producer>> getProducers();
+    bool drain(Producer &producer);
+    /*!
+     * Releases the producers of the exited threads whose events are all written
+     */
+    void retireProducers();
+    void runWriter();
+
+    /*!
+     * Waits until all events reported so far are written, without flushing the underlying output
+     */
+    void waitForWriter();
+    void rethrowWriterError();
+
+    static void flushAllAtExit();
+  };
+} // namespace Test
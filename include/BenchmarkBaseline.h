@@ -0,0 +1,136 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * Stores the results of benchmark runs (see BenchmarkSuite) and compares later runs against them.
+   *
+   * For every benchmark, the durations per iteration of all measured repetitions are kept. A new run of the same
+   * benchmark is compared against these samples with a one-sided Mann-Whitney U test, which makes no assumption about
+   * the distribution of the durations and is robust against outliers. A benchmark regressed if its median is more than
+   * the relative threshold slower than the median of the baseline and the slowdown is statistically significant.
+   *
+   * While a baseline is active (see \ref setActive), every benchmark run is compared against it, a regression is
+   * reported as failure of the benchmark. Benchmarks not yet contained in the baseline are added to it, already
+   * contained benchmarks are only replaced if enabled with \ref setUpdateExisting.
+   *
+   * NOTE: Benchmarks run in worker processes (see ProcessPool) are compared, but not recorded into the baseline of the
+   * main process.
+   */
+  class BenchmarkBaseline {
+  public:
+    /*!
+     * The result of comparing a benchmark run against the baseline
+     */
+    struct Comparison {
+      //! The median duration per iteration of the baseline in nanoseconds
+      double baselineMedian;
+      //! The median duration per iteration of the compared run in nanoseconds
+      double currentMedian;
+      //! The change of the median relative to the baseline, positive for slowdowns
+      double relativeChange;
+      //! The probability of a slowdown at least as large as observed if the run is not actually slower
+      double pValue;
+      //! Whether the slowdown exceeds the relative threshold and is statistically significant
+      bool isRegression;
+
+      Comparison() : baselineMedian(0.0), currentMedian(0.0), relativeChange(0.0), pValue(1.0), isRegression(false) {}
+    };
+
+    BenchmarkBaseline() = default;
+    BenchmarkBaseline(const BenchmarkBaseline &) = delete;
+    BenchmarkBaseline(BenchmarkBaseline &&) noexcept = delete;
+    ~BenchmarkBaseline() noexcept = default;
+
+    BenchmarkBaseline &operator=(const BenchmarkBaseline &) = delete;
+    BenchmarkBaseline &operator=(BenchmarkBaseline &&) noexcept = delete;
+
+    /*!
+     * Loads the samples previously saved to the given file, replacing any samples with the same name.
+     *
+     * \return whether the file exists and is a valid benchmark baseline
+     */
+    bool load(const std::string &fileName);
+
+    /*!
+     * Writes all samples to the given file.
+     *
+     * The file is written to a temporary file (unique per process) first and then replaced, so concurrent readers never
+     * see an incomplete baseline and concurrent writers do not corrupt each other's file.
+     */
+    void save(const std::string &fileName) const;
+
+    /*!
+     * Sets the slowdown of the median (e.g. 0.05 for 5%) a benchmark needs to exceed to be reported as regression,
+     * defaults to 5%
+     */
+    void setRelativeThreshold(double threshold);
+    double getRelativeThreshold() const noexcept { return relativeThreshold; }
+
+    /*!
+     * Sets the significance level (the maximum p-value) a slowdown needs to reach to be reported as regression,
+     * defaults to 1%
+     */
+    void setSignificanceLevel(double level);
+    double getSignificanceLevel() const noexcept { return significanceLevel; }
+
+    /*!
+     * Sets whether benchmarks already contained in the baseline are replaced by their latest run, disabled by default
+     */
+    void setUpdateExisting(bool update) noexcept { updateExisting = update; }
+    bool isUpdatingExisting() const noexcept { return updateExisting; }
+
+    /*!
+     * Compares the given samples (the durations per iteration in nanoseconds) of a run of the given benchmark against
+     * the baseline and records them afterwards (see \ref setUpdateExisting). This function is thread-safe.
+     *
+     * \return whether the baseline contains the benchmark, only then the comparison is filled
+     */
+    bool compareAndRecord(const std::string &benchmarkName, const std::vector<double> &samples, Comparison &comparison);
+
+    /*!
+     * Records the samples of a run of the given benchmark, replacing any previous samples. This function is
+     * thread-safe.
+     */
+    void record(const std::string &benchmarkName, const std::vector<double> &samples);
+
+    /*!
+     * Retrieves the samples recorded for the given benchmark.
+     *
+     * \return whether samples are recorded for the benchmark
+     */
+    bool lookup(const std::string &benchmarkName, std::vector<double> &samples) const;
+
+    bool empty() const;
+
+    /*!
+     * Runs a one-sided Mann-Whitney U test whether the current samples tend to be larger than the baseline samples.
+     *
+     * For small samples without ties, the exact distribution of the U statistic is used, otherwise the normal
+     * approximation with tie and continuity correction.
+     *
+     * \return the p-value, the probability to observe the given samples if both are drawn from the same distribution
+     */
+    static double testSlowdown(const std::vector<double> &baselineSamples, const std::vector<double> &currentSamples);
+
+    /*!
+     * Returns the baseline all executed benchmarks are compared against and recorded into, if any
+     */
+    static BenchmarkBaseline *getActive() noexcept;
+    static void setActive(BenchmarkBaseline *baseline) noexcept;
+
+  private:
+    mutable std::mutex baselineMutex;
+    std::unordered_map<std::string, std::vector<double>> benchmarks;
+    double relativeThreshold = 0.05;
+    double significanceLevel = 0.01;
+    bool updateExisting = false;
+
+    Comparison compare(const std::vector<double> &baselineSamples, const std::vector<double> &currentSamples) const;
+  };
+} // namespace Test
@@ -0,0 +1,321 @@
+#pragma once
+
+#include "TestSuite.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Test {
+
+  class WorkerPool;
+
+  namespace Private {
+    /*!
+     * Does nothing, but cannot be inlined, so the compiler has to assume the pointed-to value is read
+     */
+    void escapePointer(const volatile void *pointer);
+
+    /*!
+     * Sorts the measurements of the given result by their size and fits them to every complexity class with a least
+     * squares fit of duration = coefficient * f(n), minimizing the errors relative to the measurements. Sets the
+     * complexity, coefficient and error of the best fit, on an equal error the slower growing class is preferred.
+     */
+    void fitComplexity(ComplexityResult &result);
+  } // namespace Private
+
+  /*!
+   * Prevents the compiler from optimizing away the computation of the given value in a benchmark
+   */
+  template <typename T>
+  inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    Private::escapePointer(&value);
+#endif
+  }
+
+  /*!
+   * Controls the iterations of a single run of a benchmark, see BenchmarkSuite
+   *
+   * Only the loop over the state is measured, so any preparation before the loop is not included:
+   *
+   *   void MyBenchmarks::benchmarkSort(Test::BenchmarkState &state) {
+   *     std::vector<int> input = createInput();
+   *     for (auto _ : state) {
+   *       auto copy = input;
+   *       std::sort(copy.begin(), copy.end());
+   *       Test::doNotOptimize(copy);
+   *     }
+   *     state.setItemsPerIteration(input.size());
+   *   }
+   */
+  class BenchmarkState {
+  public:
+    //! The (empty) value of a single iteration
+    struct Iteration {
+      // not trivially destructible, so the unused loop variable does not trigger any warning
+      ~Iteration() noexcept {}
+    };
+
+    class Iterator {
+    public:
+      Iteration operator*() const noexcept { return Iteration{}; }
+      Iterator &operator++() noexcept {
+        --remaining;
+        return *this;
+      }
+      bool operator!=(const Iterator &) noexcept {
+        if (remaining != 0)
+          return true;
+        state->finishIterations();
+        return false;
+      }
+
+    private:
+      BenchmarkState *state;
+      uint64_t remaining;
+
+      Iterator(BenchmarkState *benchmarkState, uint64_t numIterations)
+          : state(benchmarkState), remaining(numIterations) {}
+
+      friend class BenchmarkState;
+    };
+
+    explicit BenchmarkState(
+        uint64_t numIterations, int64_t size = 0, unsigned index = 0, unsigned threadCount = 1) noexcept;
+    BenchmarkState(const BenchmarkState &) = delete;
+    BenchmarkState(BenchmarkState &&) noexcept = delete;
+    ~BenchmarkState() noexcept = default;
+
+    BenchmarkState &operator=(const BenchmarkState &) = delete;
+    BenchmarkState &operator=(BenchmarkState &&) noexcept = delete;
+
+    Iterator begin() noexcept {
+      startTimer();
+      return Iterator(this, iterations);
+    }
+    Iterator end() noexcept { return Iterator(this, 0); }
+
+    /*!
+     * Alternative to the range-based for-loop, returns whether to run another iteration:
+     *
+     *   while (state.keepRunning()) { ... }
+     */
+    bool keepRunning() noexcept {
+      if (remaining != 0) {
+        if (remaining-- == iterations)
+          startTimer();
+        return true;
+      }
+      finishIterations();
+      return false;
+    }
+
+    /*!
+     * Returns the number of iterations of this run
+     */
+    uint64_t getIterations() const noexcept { return iterations; }
+
+    /*!
+     * Returns the input size of this run for benchmarks registered over a range of sizes (see
+     * \ref TEST_BENCHMARK_RANGE), zero otherwise
+     */
+    int64_t getInputSize() const noexcept { return inputSize; }
+
+    /*!
+     * Returns the index (starting at zero) of the thread running this state for benchmarks registered over a number of
+     * threads (see \ref TEST_BENCHMARK_THREADS), zero otherwise
+     */
+    unsigned getThreadIndex() const noexcept { return threadIndex; }
+
+    /*!
+     * Returns the number of threads running the benchmark concurrently, one for single-threaded benchmarks
+     */
+    unsigned getNumThreads() const noexcept { return numThreads; }
+
+    /*!
+     * Stops measuring the time, e.g. to exclude the preparation of the next iteration
+     */
+    void pauseTiming() noexcept { stopTimer(); }
+
+    /*!
+     * Continues measuring the time after \ref pauseTiming
+     */
+    void resumeTiming() noexcept { startTimer(); }
+
+    /*!
+     * Declares the number of bytes processed by a single iteration, to report the throughput in bytes per second
+     */
+    void setBytesPerIteration(uint64_t bytes) noexcept { bytesPerIteration = bytes; }
+
+    /*!
+     * Declares the number of items processed by a single iteration, to report the throughput in items per second
+     */
+    void setItemsPerIteration(uint64_t items) noexcept { itemsPerIteration = items; }
+
+  private:
+    const uint64_t iterations;
+    const int64_t inputSize;
+    const unsigned threadIndex;
+    const unsigned numThreads;
+    uint64_t remaining;
+    bool running;
+    bool finished;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::duration elapsed;
+    uint64_t bytesPerIteration;
+    uint64_t itemsPerIteration;
+
+    void startTimer() noexcept;
+    void stopTimer() noexcept;
+    void finishIterations() noexcept;
+
+    friend class BenchmarkSuite;
+  };
+
+  /*!
+   * The settings for running the benchmarks of a BenchmarkSuite
+   */
+  struct BenchmarkOptions {
+    //! The minimum duration of a single repetition, the number of iterations per repetition is calibrated to reach it
+    std::chrono::nanoseconds minTime = std::chrono::milliseconds{10};
+    //! The number of repetitions run before measuring, the results of which are discarded
+    unsigned warmupRepetitions = 1;
+    //! The number of measured repetitions the statistics are calculated over
+    unsigned repetitions = 10;
+    //! The maximum number of iterations of a single repetition
+    uint64_t maxIterations = 1000000000;
+    //! The pool running the benchmarks over a number of threads, nullptr for the default WorkerPool
+    WorkerPool *pool = nullptr;
+  };
+
+  /*!
+   * Test Suite for micro-benchmarks
+   *
+   * Every benchmark (registered with \ref TEST_BENCHMARK) is a test-method taking a BenchmarkState and looping over it.
+   * The number of iterations is calibrated until a single repetition takes at least BenchmarkOptions::minTime. After
+   * the warm-up repetitions, the configured number of repetitions are measured and the statistics over the duration of
+   * a single iteration are reported to the output (see Output::printBenchmark).
+   *
+   * Benchmarks registered with \ref TEST_BENCHMARK_RANGE are run once per input size, as one test-method per size.
+   * After the test-method of the last size, the measured medians are fitted to the complexity classes (see Complexity)
+   * and the best fit is reported to the output (see Output::printComplexity). If the fitted class grows faster than the
+   * declared one, the test-method fails. The complexity is only fitted if at least two sizes ran before the last one.
+   *
+   * Benchmarks registered with \ref TEST_BENCHMARK_THREADS are run once per number of threads, as one test-method per
+   * thread count. All threads are taken from the WorkerPool (see BenchmarkOptions::pool) and start their loops
+   * together, each with its own BenchmarkState and the full number of iterations. A repetition lasts until the slowest
+   * thread finished, so the reported durations are the latency of a single iteration on a single thread. The
+   * aggregated throughput over all threads and the scaling efficiency relative to the single-threaded run are reported
+   * too (see BenchmarkResult).
+   * Since the assertions of a test-method are not thread-safe, only the thread with index zero may use them. Only one
+   * such benchmark can run on a pool at a time, a benchmark whose threads cannot all be started (e.g. while another
+   * suite of a parallel suite runs one) fails with an exception, see WorkerPool::runGang.
+   *
+   * If a BenchmarkBaseline is active, the repetitions are compared against the baseline and a significant slowdown is
+   * reported as failure of the benchmark (see Output::printFailure).
+   *
+   * A benchmark fails if any of its assertions fail (no result is reported then) or if it does not loop over the
+   * BenchmarkState. Benchmark suites should not be run in parallel to other suites or with
+   * RegistrationFlags::PARALLEL_METHODS, since benchmarks running concurrently disturb each other's measurements.
+   */
+  class BenchmarkSuite : public Suite {
+  public:
+    //! Benchmark taking the state controlling the iterations
+    using BenchmarkMethod = void (BenchmarkSuite::*)(BenchmarkState &state);
+
+    BenchmarkSuite() = default;
+    explicit BenchmarkSuite(const std::string &name);
+    BenchmarkSuite(const BenchmarkSuite &) = delete;
+    BenchmarkSuite(BenchmarkSuite &&) noexcept = default;
+    ~BenchmarkSuite() noexcept override = default;
+
+    BenchmarkSuite &operator=(const BenchmarkSuite &) = delete;
+    BenchmarkSuite &operator=(BenchmarkSuite &&) = default;
+
+    const BenchmarkOptions &getBenchmarkOptions() const noexcept { return benchmarkOptions; }
+
+  protected:
+    void addBenchmark(BenchmarkMethod method, const std::string &funcName);
+
+    /*!
+     * Registers the benchmark once for every input size of the range: first, first * multiplier, first * multiplier^2,
+     * ... and last.
+     *
+     * \param expected The complexity the benchmark must not exceed, Complexity::NONE to only report the fitted one
+     */
+    void addBenchmarkRange(BenchmarkMethod method, const std::string &funcName, int64_t first, int64_t last,
+        int64_t multiplier = 2, Complexity expected = Complexity::NONE);
+
+    /*!
+     * Registers the benchmark once for every number of threads: 1, 2, 4, ... and maxThreads.
+     *
+     * \param maxThreads The maximum number of threads, at most the number of workers of the pool running the benchmarks
+     * (see BenchmarkOptions::pool). Zero to use all workers.
+     */
+    void addBenchmarkThreads(BenchmarkMethod method, const std::string &funcName, unsigned maxThreads = 0);
+
+    /*!
+     * Sets the options used to run all benchmarks of this suite
+     */
+    void setBenchmarkOptions(const BenchmarkOptions &options);
+
+  private:
+    // the measurements of the current run of a benchmark registered over a range of input sizes
+    struct BenchmarkRange {
+      int64_t lastSize;
+      Complexity expected;
+      std::vector<ComplexityResult::Measurement> measurements;
+    };
+
+    // a single run of the measured loop on all threads
+    struct Repetition {
+      // the duration of the slowest thread
+      std::chrono::steady_clock::duration elapsed;
+      uint64_t bytesPerIteration;
+      uint64_t itemsPerIteration;
+    };
+
+    BenchmarkOptions benchmarkOptions;
+    std::vector<BenchmarkRange> ranges;
+    // the iterations per second of the single-threaded run of every benchmark registered over a number of threads
+    std::vector<double> singleThreadRates;
+
+    // stores the rate of a single-threaded run into singleThreadRate or sets the scaling efficiency relative to it
+    BenchmarkResult runBenchmark(
+        BenchmarkMethod method, int64_t size, unsigned numThreads = 1, double *singleThreadRate = nullptr);
+    void runRangeBenchmark(BenchmarkMethod method, int64_t size, std::size_t rangeIndex);
+    void runThreadsBenchmark(BenchmarkMethod method, unsigned numThreads, std::size_t rateIndex);
+    void fitComplexity(BenchmarkRange &range);
+    Repetition runRepetition(BenchmarkMethod method, uint64_t iterations, int64_t size, unsigned numThreads);
+  };
+
+  /*!
+   * Registers a benchmark, a member function taking a Test::BenchmarkState
+   */
+#define TEST_BENCHMARK(func)                                                                                           \
+  this->setSuiteName(__FILE__);                                                                                        \
+  this->addBenchmark(static_cast<Test::BenchmarkSuite::BenchmarkMethod>((&func)), #func)
+
+  /*!
+   * Registers a benchmark over a range of input sizes, see BenchmarkSuite::addBenchmarkRange for the arguments, e.g.
+   *
+   *   TEST_BENCHMARK_RANGE(MyBenchmarks::benchmarkSort, 1 << 10, 1 << 26, 2, Test::Complexity::LINEARITHMIC);
+   */
+#define TEST_BENCHMARK_RANGE(func, ...)                                                                                \
+  this->setSuiteName(__FILE__);                                                                                        \
+  this->addBenchmarkRange(static_cast<Test::BenchmarkSuite::BenchmarkMethod>((&func)), #func, __VA_ARGS__)
+
+  /*!
+   * Registers a benchmark over the number of threads 1, 2, 4, ... and maxThreads (zero for all workers), see
+   * BenchmarkSuite::addBenchmarkThreads, e.g.
+   *
+   *   TEST_BENCHMARK_THREADS(MyBenchmarks::benchmarkQueue, 8);
+   */
+#define TEST_BENCHMARK_THREADS(func, maxThreads)                                                                       \
+  this->setSuiteName(__FILE__);                                                                                        \
+  this->addBenchmarkThreads(static_cast<Test::BenchmarkSuite::BenchmarkMethod>((&func)), #func, maxThreads)
+} // namespace Test
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Output.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace Test {
+
+  /*!
+   * Writes all events into a compact, append-only binary log, which can be replayed into any other Output afterwards
+   * (see \ref replayBinaryLog), e.g. to render expensive reports offline from the logs of multiple shards.
+   *
+   * The log starts with a header (magic string and format version), followed by the length-prefixed event records.
+   * The names of suites, test-methods, arguments and source files are written once into a string table and referenced
+   * by their index afterwards, all counters are varint-encoded.
+   *
+   * The records are buffered and written in blocks, the log is complete once the output is flushed or destroyed. This
+   * output is not thread-safe.
+   */
+  class BinaryLogOutput : public Output {
+  public:
+    explicit BinaryLogOutput(std::ostream &stream);
+    explicit BinaryLogOutput(const std::string &fileName);
+    BinaryLogOutput(const BinaryLogOutput &) = delete;
+    BinaryLogOutput(BinaryLogOutput &&) noexcept = delete;
+    ~BinaryLogOutput() noexcept override;
+
+    BinaryLogOutput &operator=(const BinaryLogOutput &) = delete;
+    BinaryLogOutput &operator=(BinaryLogOutput &&) noexcept = delete;
+
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override;
+
+  private:
+    class LogEncoder;
+
+    std::unique_ptr<std::ostream> fileStream;
+    std::ostream &output;
+    std::unique_ptr<LogEncoder> encoder;
+  };
+
+  /*!
+   * Replays all events of the binary log written by a BinaryLogOutput into the given output.
+   *
+   * \throws std::runtime_error if the stream does not contain a binary log or the log is truncated (e.g. the writing
+   * process crashed), all complete events are replayed before
+   */
+  void replayBinaryLog(std::istream &stream, Output &output);
+  void replayBinaryLog(const std::string &fileName, Output &output);
+} // namespace Test
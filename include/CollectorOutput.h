@@ -2,22 +2,48 @@
 
 #include "Output.h"
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace Test {
 
   /*!
    * A collector-output collects all information to be processed after all tests have run
+   *
+   * The events are collected into one shard per writing thread, so parallel suites do not contend on a global lock. The
+   * suites and test-methods of a run are identified by the order in which they were started, not by their names, which
+   * are not unique. The shards are merged once all tests ran, see \ref visitSuites.
+   *
+   * Failed assertions are always stored. Successful assertions can either be stored or only be counted, so the memory
+   * used scales with the number of failures instead of the number of assertions. The test-methods are stored compactly
+   * (interned names, only the file and line of the assertions, the rarely reported benchmark results and performance
+   * counters in a separately allocated record), the full TestMethodInfo is only created while visiting the suites.
+   *
+   * To bound the memory used for huge test runs, a memory budget can be given. Once the collected information exceeds
+   * the budget, all completed suites are moved into a temporary file, which is streamed through when visiting the
+   * suites. While a budget is set, every shard is guarded by its own (usually uncontended) lock, so it can be spilled.
    */
   class CollectorOutput : public Output {
   public:
-    CollectorOutput() = default;
+    /*!
+     * \param keepPassedAssertions Whether to store the successful assertions or only count them
+     * \param memoryBudget The approximate number of bytes of collected information to keep in memory before moving the
+     * completed suites to a temporary file, zero for no limit
+     */
+    explicit CollectorOutput(bool keepPassedAssertions = true, std::size_t memoryBudget = 0);
     CollectorOutput(const CollectorOutput &) = delete;
-    CollectorOutput(CollectorOutput &&) = default; // RPi cross-compiler throws on noexcept here
-    ~CollectorOutput() noexcept override = default;
+    CollectorOutput(CollectorOutput &&) noexcept;
+    ~CollectorOutput() noexcept override;
 
     CollectorOutput &operator=(const CollectorOutput &) = delete;
-    CollectorOutput &operator=(CollectorOutput &&) = default; // RPi cross-compiler throws on noexcept here
+    CollectorOutput &operator=(CollectorOutput &&) noexcept;
 
     void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
     void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
@@ -26,30 +52,59 @@ namespace Test {
     void initializeTestMethod(
         const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
     void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        bool withSuccess) override;
+        bool withSuccess, std::chrono::nanoseconds duration) override;
 
     void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        const std::exception &ex) override;
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
     void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
     void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    bool isThreadSafe() const override { return true; }
 
   protected:
+    /*!
+     * The rarely reported results of a test-method, see BenchmarkSuite and PerfCounters
+     */
+    struct MethodResults {
+      // the results of the benchmarks run by the test-method (without the names of the test-method)
+      std::vector<BenchmarkResult> benchmarks;
+      // the complexities fitted by the test-method (without the names of the test-method)
+      std::vector<ComplexityResult> complexities;
+      // the performance counters measured for the test-method, see PerfCounterResult
+      uint32_t availableCounters = 0;
+      std::array<uint64_t, PerfCounterResult::NUM_COUNTERS> counterValues = {{}};
+
+      /*!
+       * Returns the measured performance counters (without the names of the test-method)
+       */
+      PerfCounterResult getPerfCounters() const;
+    };
+
     struct TestMethodInfo {
       const std::string methodName;
       const std::string argString;
       std::vector<Assertion> failedAssertions;
+      // only filled if the successful assertions are kept
       std::vector<Assertion> passedAssertions;
       std::string exceptionMessage;
       bool withSuccess;
+      std::chrono::nanoseconds duration;
+      uint64_t numPassedAssertions;
+      // only set if the test-method reported any benchmark results, complexities or performance counters
+      std::shared_ptr<const MethodResults> results;
 
       TestMethodInfo(const std::string &name, const std::string &args)
           : methodName(name), argString(args), failedAssertions({}), passedAssertions({}), exceptionMessage(""),
-            withSuccess(false) {}
+            withSuccess(false), duration(std::chrono::nanoseconds::zero()), numPassedAssertions(0), results() {}
     };
 
     struct SuiteInfo {
       const std::string suiteName;
       std::chrono::microseconds suiteDuration;
+      // the test-methods in the order they were started
       std::vector<TestMethodInfo> methods;
       const unsigned int numTests;
       unsigned int numPositiveTests;
@@ -59,9 +114,119 @@ namespace Test {
             numPositiveTests(0) {}
     };
 
-    std::vector<SuiteInfo> suites;
-    // we need pointers to the current suite/test-method, because their name is not unique
-    SuiteInfo *currentSuite = nullptr;
-    TestMethodInfo *currentMethod = nullptr;
+    /*!
+     * Merges the information collected by all threads and calls the visitor for every suite in the order they were
+     * started. The information of a single suite is created at a time, the given suite and its test-methods are only
+     * valid during the call.
+     *
+     * Every test-method is assigned to the innermost suite of the same name running on the same thread or, if there is
+     * none (e.g. the test-methods of a suite run in parallel), to the innermost suite of the same name running on any
+     * thread at the time the test-method was started. Test-methods run outside of any suite are dropped. Must not be
+     * called while tests are running.
+     */
+    void visitSuites(const std::function<void(const SuiteInfo &)> &visitor) const;
+
+    /*!
+     * Returns the number of suites moved to the temporary file
+     */
+    std::size_t getNumSpilledSuites() const;
+
+  private:
+    struct SuiteRun {
+      std::string suiteName;
+      unsigned int numTests;
+      unsigned int numPositiveTests;
+      std::chrono::microseconds duration;
+      uint64_t startSequence;
+      uint64_t finishSequence;
+    };
+
+    struct FailedAssertion {
+      // interned, see Shard::fileNames
+      const char *file;
+      uint32_t lineNumber;
+      std::string errorMessage;
+      std::string userMessage;
+    };
+
+    struct PassedAssertion {
+      // interned, see Shard::fileNames
+      const char *file;
+      uint32_t lineNumber;
+    };
+
+    struct MethodRun {
+      // the interned names of the test-method
+      const TestName *name;
+      TestId test;
+      bool withSuccess;
+      uint64_t sequence;
+      // the suite the test-method was started in, if the suite runs on the same thread
+      const SuiteRun *suite;
+      std::chrono::nanoseconds duration;
+      uint64_t numPassedAssertions;
+      std::vector<FailedAssertion> failedAssertions;
+      // only filled if the successful assertions are kept
+      std::vector<PassedAssertion> passedAssertions;
+      std::string exceptionMessage;
+      // allocated on the first benchmark result, complexity or performance counters reported
+      std::shared_ptr<MethodResults> results;
+    };
+
+    // the suites and their test-methods in the order they were started
+    struct MergedSuite {
+      const SuiteRun *suite;
+      std::vector<const MethodRun *> methods;
+    };
+
+    // the events written by a single thread, only accessed by this thread while the tests are running. The deques keep
+    // the entries at stable addresses.
+    struct Shard {
+      // only locked if a memory budget is set
+      std::mutex shardMutex;
+      std::thread::id thread;
+      // the approximate size of the completed suites and test-methods
+      std::size_t memoryUsage;
+      std::deque<SuiteRun> suites;
+      std::deque<MethodRun> methods;
+      std::vector<SuiteRun *> runningSuites;
+      std::vector<MethodRun *> runningMethods;
+      // the source files of the assertions reported as strings, the elements are never moved
+      std::unordered_set<std::string> fileNames;
+    };
+
+    class SpillFile;
+
+    // the information collected from all threads, kept at a stable address, so the collector can be moved
+    struct Collection {
+      // orders the suites and test-methods over all threads
+      std::atomic<uint64_t> nextSequence{0};
+      std::mutex shardsMutex;
+      std::vector<std::unique_ptr<Shard>> shards;
+      // the completed suites moved out of memory
+      std::unique_ptr<SpillFile> spillFile;
+      std::size_t numSpilledSuites{0};
+    };
+
+    // distinguishes the collectors for the per-thread cache of the current shard
+    uint64_t collectorId;
+    bool keepPassed;
+    std::size_t memoryLimit;
+    std::unique_ptr<Collection> collection;
+
+    Shard &getShard();
+    std::unique_lock<std::mutex> lockShard(Shard &shard);
+    // merges the suites started and test-methods run before the given sequence number
+    std::vector<MergedSuite> mergeShards(uint64_t endSequence) const;
+    static TestMethodInfo toMethodInfo(const MethodRun &method);
+    void spillCompletedSuites();
+    static std::size_t estimateSize(const SuiteRun &suite);
+    static std::size_t estimateSize(const MethodRun &method);
+    MethodRun &startMethod(
+        Shard &shard, const std::string &suiteName, const std::string &methodName, const std::string &argString);
+    MethodRun &findRunningMethod(
+        Shard &shard, const std::string &suiteName, const std::string &methodName, const std::string &argString);
+    static const char *internFileName(Shard &shard, const std::string &file);
+    static MethodResults &getResults(MethodRun &method);
   };
 } // namespace Test
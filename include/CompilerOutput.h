@@ -30,9 +30,11 @@ namespace Test {
     CompilerOutput &operator=(CompilerOutput &&) = delete;
 
     void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        const std::exception &ex) override;
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
 
+    OutputEvents getConsumedEvents() const override { return OutputEvents::EXCEPTION | OutputEvents::FAILURE; }
     void printFailure(const Assertion &assertion) override;
+    void flush() override { stream.flush(); }
 
   private:
     const std::string format;
@@ -19,12 +19,12 @@ namespace Test {
         std::chrono::microseconds totalDuration) override;
 
     void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        bool withSuccess) override;
+        bool withSuccess, std::chrono::nanoseconds duration) override;
 
     void printSuccess(const Assertion &assertion) override;
     void printFailure(const Assertion &assertion) override;
     void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        const std::exception &ex) override;
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
 
   private:
     static const std::string errorColor;
@@ -12,7 +12,11 @@ namespace Test {
    */
   class HTMLOutput : public CollectorOutput {
   public:
-    HTMLOutput() = default;
+    /*!
+     * \param memoryBudget The approximate number of bytes of test results to keep in memory before moving completed
+     * suites to a temporary file, zero for no limit
+     */
+    explicit HTMLOutput(std::size_t memoryBudget = 0) : CollectorOutput(false, memoryBudget) {}
     HTMLOutput(const HTMLOutput &) = delete;
     HTMLOutput(HTMLOutput &&) = default; // RPi cross-compiler throws on noexcept here
     ~HTMLOutput() noexcept override = default;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Output.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace Test {
+
+  /*!
+   * Outputs every event as a single JSON object on its own line (newline-delimited JSON), to be consumed by log
+   * collectors while the tests run
+   *
+   * Every line is written and flushed as soon as the event occurs, nothing is accumulated. The "event" member is one of
+   * "suite_start", "suite_finish", "test_start", "test_finish", "failure", "exception", "benchmark", "complexity" and
+   * "perf_counters". Successful assertions are not written.
+   */
+  class NDJSONOutput : public Output {
+  public:
+    explicit NDJSONOutput(std::ostream &stream);
+    explicit NDJSONOutput(const std::string &outputFile);
+    NDJSONOutput(const NDJSONOutput &) = delete;
+    NDJSONOutput(NDJSONOutput &&) noexcept = delete;
+    ~NDJSONOutput() noexcept override;
+
+    NDJSONOutput &operator=(const NDJSONOutput &) = delete;
+    NDJSONOutput &operator=(NDJSONOutput &&) noexcept = delete;
+
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    OutputEvents getConsumedEvents() const override { return ~OutputEvents::SUCCESS; }
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override;
+
+  private:
+    std::unique_ptr<std::ostream> fileStream;
+    std::ostream &output;
+    // the line currently written, reused to not allocate for every event
+    std::string line;
+
+    void beginEvent(const char *event, const std::string &suiteName);
+    void writeTest(const std::string &methodName, const std::string &argString);
+    void writeString(const char *key, const std::string &value);
+    void writeNumber(const char *key, int64_t value);
+    void writeDecimal(const char *key, double value, int precision = 3);
+    void writeLine();
+  };
+
+  namespace Private {
+    /*!
+     * Appends the given text as JSON string (including the quotes) to the given string
+     */
+    void appendJSONString(std::string &out, const char *text, std::size_t length);
+  } // namespace Private
+} // namespace Test
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Output.h"
+#include "TestSuite.h"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * A thread-safe Output writing the events of every test-method as one block, so the output of test-methods running
+   * in parallel does not interleave.
+   *
+   * All events of a test-method (identified by suite, method name and arguments) are buffered while it runs and are
+   * written to the underlying output when the test-method finishes. In the grouped order, only the events of the
+   * running test-methods are buffered. Events of a suite outside of any test-method are written immediately.
+   *
+   * In the canonical order, the suites and test-methods announced via \ref expectSuite are written in the order of
+   * their registration, regardless of which test-method finished first. The start and end of a suite are written
+   * before the first and after the last of its test-methods, so running the same suites twice produces the same output
+   * (except for the measured durations). Multiple instances of suites with the same name (e.g. added to a parallel
+   * suite multiple times) are written as one suite.
+   *
+   * Finished test-methods are kept until all test-methods before them are written, so the buffered events grow with
+   * the number of test-methods finishing while an earlier one still runs. Since the parallel executors start the
+   * slowest test-methods first, this is the usual case. Once the events of the finished test-methods exceed the memory
+   * budget, they are moved to a temporary file and read back when it is their turn. The memory used is thereby bounded
+   * by the events of the running test-methods plus the memory budget.
+   */
+  class OrderedOutput : public Output {
+  public:
+    enum class Order {
+      //! Writes every test-method as one block once it finished
+      GROUPED,
+      //! Additionally writes the suites and test-methods in the order announced via \ref expectSuite
+      CANONICAL
+    };
+
+    /*!
+     * \param memoryBudget The number of bytes of encoded events of finished test-methods to keep in memory in the
+     * canonical order before moving them to a temporary file, zero for no limit
+     */
+    explicit OrderedOutput(
+        Output &backingOutput, Order order = Order::GROUPED, std::size_t memoryBudget = 16 * 1024 * 1024);
+    OrderedOutput(const OrderedOutput &) = delete;
+    OrderedOutput(OrderedOutput &&) noexcept = delete;
+    ~OrderedOutput() noexcept override;
+
+    OrderedOutput &operator=(const OrderedOutput &) = delete;
+    OrderedOutput &operator=(OrderedOutput &&) noexcept = delete;
+
+    /*!
+     * Announces the suite (including its sub-suites) about to run with the given selected test-methods, so their
+     * events can be written in the order of registration.
+     *
+     * Writes all still buffered events of the previously announced suite. Has no effect for the grouped order.
+     */
+    void expectSuite(const Suite &suite, const std::vector<TestMethodInfo> &selectedMethods);
+
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    OutputEvents getConsumedEvents() const override;
+    void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+
+    /*!
+     * Writes all buffered events (including the events of still running test-methods) and flushes the underlying
+     * output. This breaks the grouping and ordering and is meant for aborting the program.
+     */
+    void flush() override;
+    bool isThreadSafe() const override { return true; }
+
+  private:
+    struct Group;
+    struct SuiteState;
+    class SpillFile;
+
+    struct Entry {
+      std::string suiteName;
+      // the buffered events, once the test-method finished
+      std::unique_ptr<Group> result;
+      // whether there is nothing to wait for, since the entry marks the start of a suite or the test-method is not run
+      // (e.g. the setup of its suite failed)
+      bool skipped;
+    };
+
+    Output &realOutput;
+    const OutputEvents realEvents;
+    const Order order;
+    const std::size_t memoryLimit;
+
+    std::mutex outputMutex;
+    // the same test-method can run concurrently on multiple threads, e.g. if its suite is added to a parallel suite
+    // multiple times
+    std::map<std::pair<std::thread::id, TestId>, std::unique_ptr<Group>> runningTests;
+
+    // the announced suites and test-methods, only for the canonical order
+    std::vector<Entry> entries;
+    std::size_t nextEntry;
+    // the positions of the not yet finished entries per suite and test-method
+    std::unordered_map<std::string, std::vector<std::size_t>> openPositions;
+    std::unordered_map<std::string, std::unique_ptr<SuiteState>> suites;
+    SuiteState *currentSuite;
+    // the size of the events of the finished test-methods kept in memory
+    std::size_t bufferedSize;
+    // the events of the finished test-methods exceeding the memory budget
+    std::unique_ptr<SpillFile> spillFile;
+
+    void addExpectedSuite(const Suite &suite, const std::unordered_set<std::uintptr_t> &selectedMethods);
+    Group *findGroup(TestId test);
+    void finishGroup(std::unique_ptr<Group> &&group);
+    void reportSuiteEvent(const std::string &suiteName, bool isFinish, OutputEvents event,
+        const std::function<void(Output &)> &report);
+    void writeReadyEntries();
+    void writeEntry(Entry &entry);
+    void spillFinishedEntries();
+    bool leaveCurrentSuite();
+    void writeAll();
+  };
+} // namespace Test
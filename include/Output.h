@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <exception>
 #include <string>
+#include <vector>
 
 namespace Test {
   namespace Private {
@@ -11,6 +14,209 @@ namespace Test {
      * Returns the file-name without any folders extracted from the given file-path
      */
     std::string getFileName(const std::string &file);
+
+    /*!
+     * Converts the duration into a human-readable string with the largest fitting unit, e.g. "1.234 ms"
+     */
+    std::string formatDuration(std::chrono::nanoseconds duration);
+  } // namespace Private
+
+  /*!
+   * The measurements of a single benchmark, see BenchmarkSuite
+   *
+   * The statistics are calculated over the mean durations of a single iteration of all repetitions.
+   */
+  struct BenchmarkResult {
+    std::string suite;
+    std::string method;
+    std::string args;
+    //! The number of iterations run per repetition (and thread), as calibrated to reach the minimum duration of a
+    //! repetition
+    uint64_t iterations;
+    //! The number of measured repetitions, not including the warm-up
+    uint32_t repetitions;
+    //! The durations of a single iteration in nanoseconds, for multiple threads the latency within a single thread
+    double minimum;
+    double median;
+    double mean;
+    double standardDeviation;
+    //! The 99th percentile of the durations of a single iteration in nanoseconds
+    double percentile99;
+    //! The number of bytes processed per iteration as declared by the benchmark, zero if not declared
+    uint64_t bytesPerIteration;
+    //! The number of items processed per iteration as declared by the benchmark, zero if not declared
+    uint64_t itemsPerIteration;
+    //! The number of threads running the iterations concurrently
+    uint32_t threads = 1;
+    //! The aggregate throughput relative to the single-thread throughput times the number of threads, zero if unknown
+    double scalingEfficiency = 0.0;
+
+    /*!
+     * Returns the number of iterations of all threads per second (based on the mean duration)
+     */
+    double getIterationsPerSecond() const noexcept {
+      return mean > 0.0 ? static_cast<double>(threads) * 1e9 / mean : 0.0;
+    }
+
+    /*!
+     * Returns the number of bytes processed per second by all threads (based on the mean duration), zero if not
+     * declared
+     */
+    double getBytesPerSecond() const noexcept {
+      return static_cast<double>(bytesPerIteration) * getIterationsPerSecond();
+    }
+
+    /*!
+     * Returns the number of items processed per second by all threads (based on the mean duration), zero if not
+     * declared
+     */
+    double getItemsPerSecond() const noexcept {
+      return static_cast<double>(itemsPerIteration) * getIterationsPerSecond();
+    }
+  };
+
+  /*!
+   * The complexity classes a benchmark can scale with, ordered by their growth
+   */
+  enum class Complexity : uint8_t {
+    //! No complexity declared
+    NONE = 0,
+    CONSTANT = 1,
+    LOGARITHMIC = 2,
+    LINEAR = 3,
+    LINEARITHMIC = 4,
+    QUADRATIC = 5
+  };
+
+  /*!
+   * Returns the big O notation of the given complexity class, e.g. "O(n log n)"
+   */
+  const char *toString(Complexity complexity) noexcept;
+
+  /*!
+   * The complexity class fitted to the results of a benchmark run over a range of input sizes, see BenchmarkSuite
+   */
+  struct ComplexityResult {
+    //! The median duration of a single iteration in nanoseconds for a single input size
+    struct Measurement {
+      int64_t size;
+      double median;
+    };
+
+    std::string suite;
+    //! The name of the benchmark (without the input size)
+    std::string method;
+    //! The arguments of the test-method the complexity is fitted in, the last input size of the range
+    std::string args;
+    //! The measurements the complexity is fitted to, ordered by input size
+    std::vector<Measurement> measurements;
+    //! The best-fitting complexity class
+    Complexity complexity;
+    //! The factor of the complexity function, e.g. the duration in nanoseconds per element for O(n)
+    double coefficient;
+    //! The root mean square of the errors of the fit relative to the measurements
+    double rms;
+    //! The complexity declared for the benchmark, Complexity::NONE if not declared
+    Complexity expected;
+  };
+
+  /*!
+   * The hardware and software performance counters measured per test-method, see PerfCounters
+   */
+  enum class PerfCounter : uint8_t {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    BRANCHES = 2,
+    BRANCH_MISSES = 3,
+    //! Reads from the level 1 data cache
+    L1D_READS = 4,
+    L1D_READ_MISSES = 5,
+    //! Accesses of the last level cache
+    LLC_REFERENCES = 6,
+    LLC_MISSES = 7,
+    CONTEXT_SWITCHES = 8
+  };
+
+  /*!
+   * The performance counters measured while running a single test-method, see PerfCounters
+   */
+  struct PerfCounterResult {
+    static constexpr std::size_t NUM_COUNTERS = 9;
+
+    std::string suite;
+    std::string method;
+    std::string args;
+    //! The bit mask of the measured counters (bit i for PerfCounter i), counters which could not be measured are zero
+    uint32_t available = 0;
+    //! The number of counted events indexed by PerfCounter, scaled up if the kernel multiplexed the counters
+    std::array<uint64_t, NUM_COUNTERS> values = {{}};
+
+    bool has(PerfCounter counter) const noexcept { return (available & (1u << static_cast<unsigned>(counter))) != 0; }
+    uint64_t get(PerfCounter counter) const noexcept { return values[static_cast<std::size_t>(counter)]; }
+    void set(PerfCounter counter, uint64_t value) noexcept {
+      values[static_cast<std::size_t>(counter)] = value;
+      available |= 1u << static_cast<unsigned>(counter);
+    }
+
+    /*!
+     * Returns the number of instructions retired per CPU cycle, zero if not measured
+     */
+    double getInstructionsPerCycle() const noexcept {
+      return getRatio(PerfCounter::INSTRUCTIONS, PerfCounter::CYCLES);
+    }
+
+    /*!
+     * Returns the ratio of mispredicted to all branches, zero if not measured
+     */
+    double getBranchMissRate() const noexcept { return getRatio(PerfCounter::BRANCH_MISSES, PerfCounter::BRANCHES); }
+
+    /*!
+     * Returns the ratio of missed to all reads of the level 1 data cache, zero if not measured
+     */
+    double getL1DMissRate() const noexcept { return getRatio(PerfCounter::L1D_READ_MISSES, PerfCounter::L1D_READS); }
+
+    /*!
+     * Returns the ratio of missed to all accesses of the last level cache, zero if not measured
+     */
+    double getLLCMissRate() const noexcept { return getRatio(PerfCounter::LLC_MISSES, PerfCounter::LLC_REFERENCES); }
+
+  private:
+    double getRatio(PerfCounter part, PerfCounter whole) const noexcept {
+      return has(part) && has(whole) && get(whole) != 0
+                 ? static_cast<double>(get(part)) / static_cast<double>(get(whole))
+                 : 0.0;
+    }
+  };
+
+  namespace Private {
+    /*!
+     * Formats the statistics and throughput of the benchmark into a single human-readable line, e.g.
+     * "12.345 ns/iteration (min 12.100 ns, median 12.300 ns, stddev 0.200 ns, p99 12.900 ns, 10 x 1048576 iterations)"
+     *
+     * For multiple threads, the aggregate throughput and scaling efficiency are appended, e.g.
+     * ", 4 threads, 300.000 M ops/s, 92.5% scaling efficiency"
+     */
+    std::string formatBenchmark(const BenchmarkResult &result);
+
+    /*!
+     * Formats the fitted complexity into a single human-readable line, e.g.
+     * "O(n log n), 1.234 ns * n log n (rms 2.3%, 16 input sizes)"
+     */
+    std::string formatComplexity(const ComplexityResult &result);
+
+    /*!
+     * Formats the median duration per iteration of every input size as a table with one row per size, every line
+     * starts with the given prefix
+     */
+    std::string formatComplexityTable(const ComplexityResult &result, const std::string &linePrefix);
+
+    /*!
+     * Formats the ratios of the measured performance counters into a single human-readable line, e.g.
+     * "IPC 2.15 (1.234 G instructions), 0.52% branch misses, 3.10% L1D misses, 12.40% LLC misses, 3 context switches"
+     *
+     * Counters which were not measured are omitted.
+     */
+    std::string formatPerfCounters(const PerfCounterResult &result);
   } // namespace Private
 
   struct Assertion {
@@ -29,6 +235,91 @@ namespace Test {
     Assertion(const char *fileName, uint32_t lineNum);
   };
 
+  /*!
+   * Identifies a single test-method (suite name, method name and arguments) for the lifetime of the program, see
+   * \ref internTest
+   */
+  using TestId = uint32_t;
+
+  struct TestName {
+    std::string suite;
+    std::string method;
+    std::string args;
+  };
+
+  /*!
+   * Returns the id of the given test-method, the same test-method is always assigned the same id. This function is
+   * thread-safe.
+   */
+  TestId internTest(const std::string &suite, const std::string &method, const std::string &args);
+
+  /*!
+   * Returns the names of the test-method with the given id. This function is thread-safe.
+   */
+  const TestName &getTestName(TestId id);
+
+  /*!
+   * Lightweight information about a successful assertion, which can be created without allocating any memory
+   */
+  struct AssertionEvent {
+    //! The source file of the assertion, must be a string literal (e.g. __FILE__)
+    const char *file;
+    uint32_t lineNumber;
+    TestId test;
+
+    /*!
+     * Creates the full information about the assertion
+     */
+    Assertion toAssertion() const;
+  };
+
+  /*!
+   * The kinds of events reported to an Output, one flag per hook, see Output::getConsumedEvents
+   */
+  enum class OutputEvents : uint32_t {
+    NONE = 0x00,
+    //! \ref Output::initializeSuite
+    INITIALIZE_SUITE = 0x01,
+    //! \ref Output::finishSuite
+    FINISH_SUITE = 0x02,
+    //! \ref Output::initializeTestMethod
+    INITIALIZE_TEST_METHOD = 0x04,
+    //! \ref Output::finishTestMethod
+    FINISH_TEST_METHOD = 0x08,
+    //! \ref Output::printException
+    EXCEPTION = 0x10,
+    //! \ref Output::printSuccess and \ref Output::printSuccessEvent
+    SUCCESS = 0x20,
+    //! \ref Output::printFailure
+    FAILURE = 0x40,
+    //! \ref Output::printBenchmark
+    BENCHMARK = 0x80,
+    //! \ref Output::printComplexity
+    COMPLEXITY = 0x100,
+    //! \ref Output::printPerfCounters
+    PERF_COUNTERS = 0x200,
+    ALL = 0x3FF
+  };
+
+  constexpr OutputEvents operator|(OutputEvents one, OutputEvents other) noexcept {
+    return static_cast<OutputEvents>(static_cast<uint32_t>(one) | static_cast<uint32_t>(other));
+  }
+
+  constexpr OutputEvents operator&(OutputEvents one, OutputEvents other) noexcept {
+    return static_cast<OutputEvents>(static_cast<uint32_t>(one) & static_cast<uint32_t>(other));
+  }
+
+  constexpr OutputEvents operator~(OutputEvents events) noexcept {
+    return static_cast<OutputEvents>(~static_cast<uint32_t>(events)) & OutputEvents::ALL;
+  }
+
+  /*!
+   * Returns whether any of the given events is contained in the given set of events
+   */
+  constexpr bool hasAny(OutputEvents events, OutputEvents any) noexcept {
+    return (events & any) != OutputEvents::NONE;
+  }
+
   /*!
    * Base class for all kinds of Outputs
    */
@@ -85,10 +376,25 @@ namespace Test {
     /*!
      * Finished the output for a single test-method
      *
+     * The default implementation calls the overload without the duration, so outputs overriding only that one keep
+     * working.
+     *
      * \param suiteName The name of the suite
      * \param methodName The name of the test-method
      * \param argString The argument-string for the test-method
      * \param withSuccess Whether the test-method was finished with success
+     * \param duration The duration the test-method took to execute, not including the setup and tear-down of the suite
+     */
+    virtual void finishTestMethod(const std::string &suiteName, const std::string &methodName,
+        const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+      (void)duration;
+      finishTestMethod(suiteName, methodName, argString, withSuccess);
+    }
+
+    /*!
+     * Finished the output for a single test-method, without the duration.
+     *
+     * Only called by the default implementation of the overload with the duration, which is called by the runner.
      */
     virtual void finishTestMethod(
         const std::string &suiteName, const std::string &methodName, const std::string &argString, bool withSuccess) {
@@ -103,10 +409,25 @@ namespace Test {
      *
      * NOTE: when this method is called, \ref finishTestMethod is skipped for this test-method
      *
+     * The default implementation calls the overload without the duration, so outputs overriding only that one keep
+     * working.
+     *
      * \param suiteName The name of the suite
      * \param methodName The name of the test-method
      * \param argString The argument-string for the test-method
      * \param ex The exception, that was thrown
+     * \param duration The duration the test-method ran until the exception was thrown, zero if unknown
+     */
+    virtual void printException(const std::string &suiteName, const std::string &methodName,
+        const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+      (void)duration;
+      printException(suiteName, methodName, argString, ex);
+    }
+
+    /*!
+     * Finished the output for a single test-method that threw an error, without the duration.
+     *
+     * Only called by the default implementation of the overload with the duration, which is called by the runner.
      */
     virtual void printException(const std::string &suiteName, const std::string &methodName,
         const std::string &argString, const std::exception &ex) {
@@ -116,15 +437,40 @@ namespace Test {
       (void)ex;
     }
 
+    /*!
+     * Returns the kinds of events this output consumes.
+     *
+     * The hooks of events not contained are never called, so e.g. for an output not consuming successful assertions,
+     * a successful assertion only increments a counter. The value must not change while a suite is running.
+     */
+    virtual OutputEvents getConsumedEvents() const { return OutputEvents::ALL; }
+
+    /*!
+     * Returns whether this output consumes any of the given events, see \ref getConsumedEvents
+     */
+    bool consumes(OutputEvents events) const { return hasAny(getConsumedEvents(), events); }
+
     /*!
      * Prints a successful test
      *
-     * NOTE: this method is only called, if the macro CPPTEST_LITE_LOG_SUCCESS is set
+     * NOTE: this method is only called, if \ref getConsumedEvents contains OutputEvents::SUCCESS
      *
      * \param assertion Information about the successful assertion
      */
     virtual void printSuccess(const Assertion &assertion) { (void)assertion; }
 
+    /*!
+     * Prints a successful test given its lightweight information.
+     *
+     * By default creates the full information about the assertion and calls \ref printSuccess. Outputs not requiring
+     * all information can override this method to avoid allocating memory for every successful assertion.
+     *
+     * NOTE: this method is only called, if \ref getConsumedEvents contains OutputEvents::SUCCESS
+     *
+     * \param event Information about the successful assertion
+     */
+    virtual void printSuccessEvent(const AssertionEvent &event) { printSuccess(event.toAssertion()); }
+
     /*!
      * Prints a failed test
      *
@@ -132,6 +478,41 @@ namespace Test {
      */
     virtual void printFailure(const Assertion &assertion) { (void)assertion; }
 
+    /*!
+     * Prints the measurements of a benchmark, called before the benchmark's test-method finishes
+     *
+     * \param result The statistics of the benchmark
+     */
+    virtual void printBenchmark(const BenchmarkResult &result) { (void)result; }
+
+    /*!
+     * Prints the complexity fitted to a benchmark run over a range of input sizes, called before the test-method of
+     * the last input size finishes
+     *
+     * \param result The fitted complexity and the measurements it is fitted to
+     */
+    virtual void printComplexity(const ComplexityResult &result) { (void)result; }
+
+    /*!
+     * Prints the performance counters measured while running a test-method (see PerfCounters), called before the
+     * test-method finishes. Not called for test-methods throwing an exception.
+     *
+     * \param result The values of the measured counters
+     */
+    virtual void printPerfCounters(const PerfCounterResult &result) { (void)result; }
+
+    /*!
+     * Writes all buffered output. Called before the program is aborted, e.g. for a test-method which could not be
+     * cancelled after exceeding its timeout
+     */
+    virtual void flush() {}
+
+    /*!
+     * Returns whether all hooks of this output can be called concurrently from multiple threads. Outputs which are not
+     * thread-safe are wrapped in a SynchronizedOutput when running test-methods in parallel.
+     */
+    virtual bool isThreadSafe() const { return false; }
+
   protected:
     Output() = default;
 
@@ -2,13 +2,13 @@
 
 #include "SynchronizedOutput.h"
 #include "TestSuite.h"
+#include "WorkerPool.h"
 
-#include <future>
-#include <thread>
+#include <memory>
 
 namespace Test {
   /*!
-   * A suite which calls every sub-suite in an own thread and therefore in parallel.
+   * A suite which runs every sub-suite as a task on the default WorkerPool and therefore in parallel.
    * ParallelSuite does not support adding test-methods directly to the suite.
    * All test-methods must be added via a sub-suite
    */
@@ -23,9 +23,33 @@ namespace Test {
     ParallelSuite &operator=(const ParallelSuite &) = delete;
     ParallelSuite &operator=(ParallelSuite &&) = default;
 
+    /*!
+     * Runs all sub-suites in parallel. The sub-suites with the longest recorded durations are started first.
+     *
+     * \return whether no test-methods are directly added to this suite. As with \ref Suite::run, the results of the
+     * sub-suites are only reported to the output and not included in the return value
+     */
     bool run(Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError) override;
 
   private:
+    std::unique_ptr<SynchronizedOutput> synchronizedOutput;
+
+    /*!
+     * Runs the setup and tear-down of this suite itself and reports any test-methods directly added to this suite as
+     * failure, since they are not executed
+     *
+     * \return whether no test-methods are directly added
+     */
+    bool runOwnTestMethods(Output &out);
+
     bool runSuite(unsigned int suiteIndex, const std::vector<TestMethodInfo> &selectedMethods);
+    /*!
+     * Returns the indices of the sub-suites ordered by their expected duration (longest first), if a TimingHistory is
+     * active
+     */
+    std::vector<unsigned int> orderLongestFirst(const std::vector<TestMethodInfo> &selectedMethods) const;
+
+    // ProcessPool runs the sub-suites in parallel in its worker processes
+    friend class ProcessPool;
   };
 } // namespace Test
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Output.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * Measures the hardware and software performance counters (see PerfCounter) of the calling thread via the Linux
+   * perf_event_open interface.
+   *
+   * The counters are opened as separate groups (cycles, instructions and branches; the level 1 data cache; the last
+   * level cache; context switches), so every group fits into the hardware counters of the CPU and the ratios within a
+   * group are measured over the same time. If the kernel has to multiplex the groups, the values are scaled up to the
+   * whole measured time.
+   *
+   * Counters which cannot be opened (e.g. not supported by the CPU or virtual machine, forbidden by
+   * /proc/sys/kernel/perf_event_paranoid or on other operating systems) are skipped, see \ref getAvailable.
+   *
+   * While enabled (see \ref setEnabled), every test-method is measured on the thread running it and the counters are
+   * reported via Output::printPerfCounters. Only the thread running the test-method is counted, not any thread started
+   * by it (e.g. the additional threads of a benchmark registered with TEST_BENCHMARK_THREADS).
+   */
+  class PerfCounters {
+  public:
+    /*!
+     * Opens all available counters for the calling thread, the counters are stopped initially
+     */
+    PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters(PerfCounters &&) noexcept = delete;
+    ~PerfCounters() noexcept;
+
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    PerfCounters &operator=(PerfCounters &&) noexcept = delete;
+
+    /*!
+     * Returns the bit mask of the counters which could be opened (bit i for PerfCounter i)
+     */
+    uint32_t getAvailable() const noexcept { return available; }
+
+    /*!
+     * Resets and starts all counters
+     */
+    void start() noexcept;
+
+    /*!
+     * Stops all counters and sets their values in the given result. Counters which could not be read are not set.
+     */
+    void stop(PerfCounterResult &result) noexcept;
+
+    /*!
+     * Returns the counters of the calling thread, opened on first use by this thread (and process)
+     */
+    static PerfCounters &getCurrentThread();
+
+    /*!
+     * Returns whether performance counters can be measured on this platform at all
+     */
+    static bool isSupported() noexcept;
+
+    /*!
+     * Returns whether the test-methods are measured, disabled by default
+     */
+    static bool isEnabled() noexcept;
+    static void setEnabled(bool enabled) noexcept;
+
+  private:
+    struct Group {
+      // the file descriptor of the group leader, which controls the whole group
+      int leader;
+      // the file descriptors of all opened counters in the order their values are read
+      std::vector<int> descriptors;
+      std::vector<PerfCounter> counters;
+    };
+
+    std::vector<Group> groups;
+    uint32_t available;
+  };
+} // namespace Test
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "TestSuite.h"
+
+#include <chrono>
+#include <cstddef>
+
+namespace Test {
+  class ParallelSuite;
+
+  /*!
+   * Runs the test-methods of a suite crash-isolated in a pool of pre-forked worker processes.
+   *
+   * The suite (and all its sub-suites) are constructed and set up (see Suite::setup) once in the parent process. Then
+   * the worker processes are forked, sharing the already loaded fixtures copy-on-write. The workers pull the indices of
+   * the test-methods to run from the parent and stream the results back over pipes.
+   *
+   * A worker terminating while running a test-method (e.g. by a signal, an exit call or exceeding its resource limits)
+   * is reported as exception of that test-method via Output::printException and replaced by a new worker.
+   *
+   * All sub-suites of a ParallelSuite (including their nested sub-suites) are set up together and their test-methods
+   * are distributed across the same worker processes, so they run in parallel. As when running in-process, test-methods
+   * added directly to a ParallelSuite are not executed and fail the suite.
+   *
+   * Only the thread calling \ref run exists in the forked worker processes. The worker processes therefore do not
+   * record any durations (the parent process does) and create an own default WorkerPool on first use. Any other thread
+   * of the parent process must not hold a lock or unflushed output the test-methods need while the workers are forked,
+   * which is why an AsyncOutput must not be used together with a ProcessPool.
+   *
+   * NOTE: Only supported on POSIX systems, see \ref isSupported
+   */
+  class ProcessPool {
+  public:
+    /*!
+     * Resource limits applied to every worker process, a value of zero disables the limit
+     */
+    struct Limits {
+      //! Maximum size of the virtual memory of a worker process in bytes
+      std::size_t maxMemory;
+      //! Maximum CPU time of a worker process
+      std::chrono::seconds maxCpuTime;
+
+      Limits() : maxMemory(0), maxCpuTime(std::chrono::seconds::zero()) {}
+    };
+
+    explicit ProcessPool(unsigned numWorkers, const Limits &workerLimits = Limits{});
+    ProcessPool(const ProcessPool &) = delete;
+    ProcessPool(ProcessPool &&) noexcept = delete;
+    ~ProcessPool() noexcept = default;
+
+    ProcessPool &operator=(const ProcessPool &) = delete;
+    ProcessPool &operator=(ProcessPool &&) noexcept = delete;
+
+    /*!
+     * Runs the selected test-methods of the given suite and all its sub-suites in the worker processes
+     *
+     * \param suite The suite to run
+     * \param out The output to print the results to
+     * \param selectedMethods The test-methods to run
+     * \param continueOnError whether to continue running after a test failed
+     *
+     * \return whether all selected test-methods succeeded
+     */
+    bool run(
+        Suite &suite, Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError = true);
+
+    /*!
+     * Returns whether running test-methods in separate processes is supported on this platform
+     */
+    static bool isSupported() noexcept;
+
+  private:
+    // a suite whose test-methods are run in the worker processes
+    struct SuiteRun {
+      Suite *suite;
+      // the indices of the selected test-methods of the suite
+      std::vector<std::size_t> methodIndices;
+      std::size_t numFinishedMethods;
+      bool setupSucceeded;
+      std::chrono::steady_clock::time_point startTime;
+    };
+
+    const unsigned numWorkers;
+    const Limits limits;
+
+    bool runSuite(Suite &suite, Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError);
+    // collects the sub-suites to run together and runs the own part of all contained parallel suites
+    bool collectParallelSuites(Suite &suite, Output &out, bool continueOnError, std::vector<Suite *> &suites);
+    // runs the test-methods of all given suites at the same time, name is the suite reported as parallel run
+    bool runSuites(const std::string &name, const std::vector<Suite *> &suites, Output &out,
+        const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError);
+    void runMethods(const std::string &name, std::vector<SuiteRun> &runs, Output &out);
+    void finishSuite(SuiteRun &run, Output &out);
+  };
+} // namespace Test
@@ -26,12 +26,19 @@ namespace Test {
     void initializeTestMethod(
         const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
     void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        bool withSuccess) override;
+        bool withSuccess, std::chrono::nanoseconds duration) override;
 
     void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        const std::exception &ex) override;
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    OutputEvents getConsumedEvents() const override;
     void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
     void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override;
+    bool isThreadSafe() const override { return true; }
 
   private:
     Output &realOutput;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Output.h"
+
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * An Output forwarding all events to multiple underlying outputs.
+   *
+   * Every event is only forwarded to the outputs consuming it (see Output::getConsumedEvents), the tee itself consumes
+   * all events consumed by any of its outputs.
+   *
+   * NOTE: The underlying outputs need to be added before running any suite
+   */
+  class TeeOutput : public Output {
+  public:
+    TeeOutput() = default;
+    TeeOutput(Output &first, Output &second);
+    TeeOutput(const TeeOutput &) = delete;
+    TeeOutput(TeeOutput &&) noexcept = delete;
+    ~TeeOutput() override = default;
+
+    TeeOutput &operator=(const TeeOutput &) = delete;
+    TeeOutput &operator=(TeeOutput &&) noexcept = delete;
+
+    /*!
+     * Adds another output to forward the events to
+     */
+    void addOutput(Output &output);
+
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    OutputEvents getConsumedEvents() const override;
+    void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override;
+
+  private:
+    struct Target {
+      Output *output;
+      // cached Output::getConsumedEvents of the output
+      OutputEvents events;
+    };
+
+    std::vector<Target> targets;
+  };
+} // namespace Test
@@ -4,6 +4,7 @@
 #include "comparisons.h"
 #include "formatting.h"
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -23,12 +24,28 @@ namespace Test {
   struct TestMethodInfo {
     std::uintptr_t reference;
     std::string fullName;
+    //! The name of the suite the test-method is registered in
+    std::string suiteName;
   };
 
+  class Suite;
+
+  /*!
+   * Creates a new instance of a test-suite, e.g. its constructor
+   */
+  using SuiteSupplier = std::function<Test::Suite *(void)>;
+
   struct AssertionFailedException : public std::runtime_error {
     AssertionFailedException() : std::runtime_error{"Test assertion failed"} {}
   };
 
+  /*!
+   * Thrown by any assertion of a test-method which exceeded its timeout, to cancel the test-method
+   */
+  struct TestTimeoutException : public std::runtime_error {
+    explicit TestTimeoutException(const std::string &message) : std::runtime_error{message} {}
+  };
+
   /*!
    * Any test-class must extend this class
    */
@@ -50,14 +67,34 @@ namespace Test {
     void add(const std::shared_ptr<Test::Suite> &suite);
 
     /*!
-     * Runs all the registered test-methods in this suite
+     * Runs all the registered test-methods in this suite, followed by all sub-suites
      *
      * \param out The output to print the results to
      * \param continueOnError whether to continue running after a test failed
+     *
+     * \return whether all selected test-methods of this suite itself succeeded. The results of the sub-suites are only
+     * reported to the output and not included in the return value
      */
     virtual bool run(Output &out, bool continueOnError = true);
     virtual bool run(Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError = true);
 
+    /*!
+     * Runs the selected test-methods of this suite distributed across the workers of the default WorkerPool.
+     *
+     * Every worker runs its share of the test-methods on an own instance of this suite created by the given supplier,
+     * so all per-test state (e.g. the current test-method and the output) is per-worker. \ref setup and
+     * \ref tear_down are executed once per worker instance. Sub-suites are run afterwards as with \ref run.
+     *
+     * Falls back to \ref run if no supplier is given or there are not enough workers or test-methods.
+     *
+     * \param out The output to print the results to
+     * \param selectedMethods The test-methods to run
+     * \param supplier The supplier creating new instances of this suite, e.g. the supplier used to create this suite
+     * \param continueOnError whether to continue running after a test failed
+     */
+    bool runInParallel(Output &out, const std::vector<TestMethodInfo> &selectedMethods, const SuiteSupplier &supplier,
+        bool continueOnError = true);
+
     /*!
      * Lists all test-methods to be run in this suite
      */
@@ -65,6 +102,13 @@ namespace Test {
 
     std::string getName() const { return suiteName; }
 
+    /*!
+     * Returns the number of successful assertions of the last run of this suite (excluding any sub-suites).
+     *
+     * NOTE: Assertions executed in worker processes (see ProcessPool) are not counted
+     */
+    uint64_t getNumPassedAssertions() const noexcept { return passedAssertions; }
+
   protected:
     //! Test-method without any parameter
     using SimpleTestMethod = void (Suite::*)();
@@ -102,6 +146,18 @@ namespace Test {
 #endif
 
     void testSucceeded(Assertion &&assertion);
+
+    /*!
+     * Reports a successful assertion. If no output consumes successful assertions (see Output::getConsumedEvents),
+     * this only increments a counter.
+     */
+    inline void testSucceeded(const char *fileName, uint32_t lineNumber) {
+      if (currentTimeoutExpired != nullptr)
+        checkTimeout();
+      ++passedAssertions;
+      if (hasAny(consumedEvents, OutputEvents::SUCCESS))
+        output->printSuccessEvent(AssertionEvent{fileName, lineNumber, currentTest});
+    }
     void testFailed(Assertion &&assertion);
     void testFailed(
         const char *fileName, uint32_t lineNumber, std::string &&errorMessage, const std::string &userMessage = "");
@@ -114,10 +170,21 @@ namespace Test {
       testRun(success, fileName, lineNumber, std::string{errorMessage ? errorMessage : ""}, userMessage);
     }
 
-    template <typename Func>
+    /*!
+     * Reports the result of an assertion. The error message is only generated and the user message only converted to
+     * a string if the assertion failed and an output consumes failures, so successful assertions do not allocate any
+     * memory.
+     */
+    template <typename Func, typename Message,
+        typename = typename std::enable_if<!std::is_convertible<Func, std::string>::value>::type>
     void testRun(
-        bool success, const char *fileName, uint32_t lineNumber, Func &&generateError, const std::string &userMessage) {
-      testRun(success, fileName, lineNumber, !success ? generateError() : std::string{}, userMessage);
+        bool success, const char *fileName, uint32_t lineNumber, Func &&generateError, const Message &userMessage) {
+      if (success)
+        testSucceeded(fileName, lineNumber);
+      else if (hasAny(consumedEvents, OutputEvents::FAILURE))
+        testFailed(fileName, lineNumber, generateError(), toMessage(userMessage));
+      else
+        testFailed(fileName, lineNumber, std::string{}, std::string{});
     }
 
     const std::string &toMessage(const std::string &msg) const { return msg; }
@@ -125,6 +192,25 @@ namespace Test {
 
     inline bool continueAfterFailure() { return continueAfterFail; }
 
+    /*!
+     * Sets the timeout of the last added test-method, overriding the timeout of the suite, see \ref TEST_TIMEOUT
+     */
+    void setTestTimeout(std::chrono::milliseconds timeout);
+
+    /*!
+     * Sets the timeout of all test-methods of this suite without an explicit timeout, overriding the default timeout
+     * (see Watchdog::setDefaultTimeout). A timeout of zero uses the default timeout.
+     *
+     * A test-method exceeding its timeout is reported as failed with a TestTimeoutException, right on expiry if the
+     * output is thread-safe (see Output::isThreadSafe), otherwise once the test-method returns. The test-method is
+     * cancelled by throwing the exception on its next assertion. If it does not return within the same duration again,
+     * the test program is aborted: the output is flushed and the abort handler is executed (see
+     * Watchdog::setAbortHandler, the test runner saves the timing history and the benchmark baseline), but the
+     * remaining test-methods are not run and outputs requiring closing elements (e.g. JUnit XML) stay incomplete. In
+     * process isolation mode (see ProcessPool), only the worker process running the test-method is killed instead.
+     */
+    void setSuiteTimeout(std::chrono::milliseconds timeout) noexcept { suiteTimeout = timeout; }
+
     /*!
      * This method can be overridden to execute code before the test-methods in this class are run
      *
@@ -232,7 +318,7 @@ namespace Test {
         testFailed(loc.file_name(), loc.line(), "Expected exception of type " + EXCEPTION_NAME + " was not thrown",
             std::string{msg});
       } catch (const Exception &) {
-        testSucceeded(Test::Assertion(loc.file_name(), loc.line()));
+        testSucceeded(loc.file_name(), loc.line());
       } catch (std::exception &ex) {
         /*If we get here, wrong exception was thrown*/
         testFailed(loc.file_name(), loc.line(),
@@ -252,7 +338,7 @@ namespace Test {
         /*If we get here, no exception was thrown*/
         testFailed(loc.file_name(), loc.line(), "Expected exception was not thrown", std::string{msg});
       } catch (std::exception &ex) {
-        testSucceeded(Test::Assertion(loc.file_name(), loc.line()));
+        testSucceeded(loc.file_name(), loc.line());
       } catch (...) {
         /* Any other type than an exception was thrown*/
         testFailed(loc.file_name(), loc.line(), "A non-exception-type was thrown");
@@ -309,11 +395,16 @@ namespace Test {
       const std::string name;
       const std::function<void(Suite *)> functor;
       const std::string argString;
+      //! The explicit timeout of this test-method, zero to use the timeout of the suite
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::zero();
 
       TestMethod() : name("") {}
 
       TestMethod(const std::string &methodName, SimpleTestMethod method) : name(methodName), functor(method), argString({}) {}
 
+      TestMethod(const std::string &methodName, std::function<void(Suite *)> &&method, const std::string &args = "")
+          : name(methodName), functor(std::move(method)), argString(args) {}
+
 #if defined(__clang__) || (defined(__GNUC__) && __GNUC__ < 5)
       template <typename T>
       TestMethod(const std::string &methodName, ParameterizedTestMethod<T> method, const T arg0)
@@ -339,6 +430,9 @@ namespace Test {
 
       inline void operator()(Suite *suite) const { functor(suite); }
 
+      //! The name as listed in TestMethodInfo::fullName
+      inline std::string fullName() const { return name + "(" + argString + ")"; }
+
       template <typename T, typename... R>
       static inline std::string joinStrings(const T &t, const R &...remainder) {
         if (sizeof...(R) == 0)
@@ -371,18 +465,65 @@ namespace Test {
     uint32_t positiveTestMethods;
     bool continueAfterFail;
     bool currentTestSucceeded;
+    // cached Output::getConsumedEvents of the output
+    OutputEvents consumedEvents;
+    // the interned name of the running test-method, only if successful assertions are consumed
+    TestId currentTest;
+    uint64_t passedAssertions;
+    std::chrono::milliseconds suiteTimeout;
+    // whether to watch the timeouts of the test-methods, the watchdog is not available in forked worker processes
+    bool watchTimeouts;
+    // the timeout state of the running test-method, if it has a timeout
+    std::chrono::milliseconds currentTimeout;
+    std::chrono::steady_clock::time_point currentTestStart;
+    const std::atomic<bool> *currentTimeoutExpired;
 
     std::pair<bool, std::chrono::microseconds> runTestMethod(const TestMethod &method);
 
+    /*!
+     * Run \ref setup and \ref tear_down, recording their durations into the active TimingReport, if any
+     */
+    bool runSetup();
+    void runTearDown();
+
+    void setOutput(Output &out);
+
+    /*!
+     * Returns the effective timeout of the given test-method, zero if the test-method has no timeout
+     */
+    std::chrono::milliseconds getTimeout(const TestMethod &method) const noexcept;
+
+    /*!
+     * Cancels the running test-method by throwing a TestTimeoutException, if it exceeded its timeout
+     */
+    void checkTimeout() const;
+
     std::vector<std::reference_wrapper<const TestMethod>> filterTests(
         const std::vector<TestMethodInfo> &selectedMethods);
 
+    /*!
+     * Reorders the given indices of test-methods to start the historically slowest test-methods first, if a
+     * TimingHistory is active
+     */
+    void sortLongestFirst(std::vector<std::size_t> &methodIndices) const;
+
     static std::string toPrettyTypeName(const std::type_info &type);
 
     // ParallelSuite needs access to subSuites
     friend class ParallelSuite;
+    // ProcessPool runs the single test-methods in the worker processes
+    friend class ProcessPool;
+    // OrderedOutput announces the suites and test-methods in the order they are run
+    friend class OrderedOutput;
+    // BenchmarkSuite registers its benchmarks as test-methods and reports their results
+    friend class BenchmarkSuite;
   };
 
+  /*!
+   * Sets the timeout in milliseconds of the last test-method registered with any of the TEST_ADD_XXX macros
+   */
+#define TEST_TIMEOUT(timeoutMs) this->setTestTimeout(std::chrono::milliseconds{timeoutMs})
+
   /*!
    * Registers a simple test-method
    */
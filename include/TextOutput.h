@@ -2,6 +2,8 @@
 
 #include "Output.h"
 
+#include <ostream>
+
 namespace Test {
 
   class TextOutput : public Output {
@@ -26,12 +28,17 @@ namespace Test {
     void initializeTestMethod(
         const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
     void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        bool withSuccess) override;
+        bool withSuccess, std::chrono::nanoseconds duration) override;
 
+    OutputEvents getConsumedEvents() const override;
     void printSuccess(const Assertion &assertion) override;
     void printFailure(const Assertion &assertion) override;
     void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
-        const std::exception &ex) override;
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override { stream.flush(); }
 
   protected:
     std::ostream &stream;
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * Records the durations of the executed test-methods and persists them across test runs.
+   *
+   * For every test-method, an exponential moving average and variance of its durations is kept, so the history adapts
+   * to changed test-methods while smoothing out outliers.
+   *
+   * The recorded durations are used to distribute the test-methods evenly across multiple shards (see
+   * \ref assignShards) and to start the slowest test-methods and suites first when running in parallel (see
+   * \ref orderLongestFirst). While a history is active (see \ref setActive), every test-method run records its
+   * duration under the name of its suite and its full name (see \ref getTestKey) into that history.
+   */
+  class TimingHistory {
+  public:
+    /*!
+     * The recorded durations of a single test-method
+     */
+    struct Statistics {
+      //! The exponential moving average of the durations in microseconds
+      double mean;
+      //! The exponential moving variance of the durations in square microseconds
+      double variance;
+      //! The number of recorded runs
+      uint32_t numRuns;
+
+      Statistics() : mean(0.0), variance(0.0), numRuns(0) {}
+    };
+
+    /*!
+     * The weight of the newest duration for the moving average and variance
+     */
+    static constexpr double SMOOTHING_FACTOR = 0.25;
+
+    TimingHistory() = default;
+    TimingHistory(const TimingHistory &) = delete;
+    TimingHistory(TimingHistory &&) noexcept = delete;
+    ~TimingHistory() noexcept = default;
+
+    TimingHistory &operator=(const TimingHistory &) = delete;
+    TimingHistory &operator=(TimingHistory &&) noexcept = delete;
+
+    /*!
+     * Returns the name the durations of the given test-method are recorded under, e.g. "Suite::Suite::method()".
+     *
+     * The full name of a test-method (see TestMethodInfo::fullName) contains the class it is declared in, which is not
+     * unique, since the same class can be registered as multiple suites.
+     */
+    static std::string getTestKey(const std::string &suiteName, const std::string &fullName) {
+      return suiteName + "::" + fullName;
+    }
+
+    /*!
+     * Loads the durations previously saved to the given file, replacing any durations with the same name.
+     *
+     * \return whether the file exists and is a valid timing history
+     */
+    bool load(const std::string &fileName);
+
+    /*!
+     * Writes all durations to the given file.
+     *
+     * The file is written to a temporary file (unique per process) first and then replaced, so concurrent readers never
+     * see an incomplete history and concurrent writers do not corrupt each other's file.
+     */
+    void save(const std::string &fileName) const;
+
+    /*!
+     * Records the duration of a single run of the given test-method. This function is thread-safe.
+     */
+    void record(const std::string &testName, std::chrono::microseconds duration);
+
+    /*!
+     * Retrieves the average duration recorded for the given test-method.
+     *
+     * \return whether a duration is recorded for the test-method
+     */
+    bool lookup(const std::string &testName, std::chrono::microseconds &duration) const;
+    bool lookup(const std::string &testName, Statistics &statistics) const;
+
+    bool empty() const;
+
+    /*!
+     * Returns the expected duration of every given test-method.
+     *
+     * Test-methods without recorded duration are estimated with the mean duration of all recorded test-methods.
+     */
+    std::vector<std::chrono::microseconds> estimateDurations(const std::vector<std::string> &testNames) const;
+
+    /*!
+     * Returns the indices of the given test-methods ordered by their expected duration, longest first. Test-methods
+     * with the same expected duration keep their relative order.
+     */
+    std::vector<std::size_t> orderLongestFirst(const std::vector<std::string> &testNames) const;
+
+    /*!
+     * Assigns the given test-methods to the given number of shards.
+     *
+     * The test-methods are distributed with a longest-processing-time-first bin packing: ordered by their recorded
+     * duration (longest first), every test-method is assigned to the shard with the lowest total duration so far.
+     * Test-methods without recorded duration are estimated with the mean recorded duration.
+     *
+     * If no duration is recorded for any of the test-methods, the shard is selected by a stable hash of the name, so
+     * adding or removing test-methods does not move any other test-method to another shard.
+     *
+     * \param testNames The full names of the test-methods to distribute
+     * \param numShards The number of shards, must not be zero
+     *
+     * \return the (zero-based) index of the shard for every test-method
+     */
+    std::vector<unsigned> assignShards(const std::vector<std::string> &testNames, unsigned numShards) const;
+
+    /*!
+     * Returns the history the durations of all executed test-methods are recorded into, if any
+     */
+    static TimingHistory *getActive() noexcept;
+    static void setActive(TimingHistory *history) noexcept;
+
+  private:
+    mutable std::mutex historyMutex;
+    std::unordered_map<std::string, Statistics> durations;
+  };
+} // namespace Test
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * Collects where the time of a test run went, to be printed as summary after all suites finished.
+   *
+   * While a report is active (see \ref setActive), the durations of all test-methods, suites and fixture hooks are
+   * recorded into it:
+   * - the slowest test-methods (see TestMethodInfo::fullName) and suites, only the configured number of slowest entries
+   *   is kept
+   * - the total time spent in Suite::setup() and Suite::tear_down(), Suite::before() and Suite::after() and the
+   *   test-method bodies, summed over all threads
+   * - the parallel efficiency of every ParallelSuite and every suite running its test-methods in parallel (including
+   *   ProcessPool), which is the time the workers were busy divided by the wall time times the number of workers
+   *
+   * The fixture hooks run in the worker processes of a ProcessPool are not recorded.
+   */
+  class TimingReport {
+  public:
+    /*!
+     * The parts of a suite run the time is accounted to
+     */
+    enum class Phase : uint8_t {
+      //! Suite::setup() and Suite::tear_down()
+      SUITE_FIXTURE,
+      //! Suite::before() and Suite::after()
+      METHOD_FIXTURE,
+      //! The bodies of the test-methods
+      TEST_METHOD
+    };
+
+    struct Entry {
+      //! The full name of the test-method or the name of the suite
+      std::string name;
+      std::chrono::nanoseconds duration;
+    };
+
+    struct ParallelRun {
+      std::string suiteName;
+      //! The summed time all workers were busy running the suite
+      std::chrono::nanoseconds busyTime;
+      std::chrono::nanoseconds wallTime;
+      unsigned numWorkers;
+
+      /*!
+       * Returns the busy time divided by the wall time times the number of workers, 1 for perfect parallelization
+       */
+      double getEfficiency() const noexcept;
+    };
+
+    /*!
+     * \param slowestCount The number of slowest test-methods and suites to keep
+     */
+    explicit TimingReport(std::size_t slowestCount);
+    TimingReport(const TimingReport &) = delete;
+    TimingReport(TimingReport &&) noexcept = delete;
+    ~TimingReport() noexcept = default;
+
+    TimingReport &operator=(const TimingReport &) = delete;
+    TimingReport &operator=(TimingReport &&) noexcept = delete;
+
+    /*!
+     * Records the duration of the body of a single test-method run and adds it to Phase::TEST_METHOD. This function is
+     * thread-safe.
+     */
+    void recordTestMethod(const std::string &testName, std::chrono::nanoseconds duration);
+
+    /*!
+     * Records the duration of a single suite run, including its fixture hooks but not its sub-suites. This function is
+     * thread-safe.
+     */
+    void recordSuite(const std::string &suiteName, std::chrono::nanoseconds duration);
+
+    /*!
+     * Adds the given duration to the total time spent in the given phase. This function is thread-safe.
+     */
+    void recordPhase(Phase phase, std::chrono::nanoseconds duration) noexcept;
+
+    /*!
+     * Records a run of a suite whose test-methods or sub-suites ran on multiple workers. This function is thread-safe.
+     */
+    void recordParallelRun(const std::string &suiteName, std::chrono::nanoseconds busyTime,
+        std::chrono::nanoseconds wallTime, unsigned numWorkers);
+
+    /*!
+     * Returns the slowest test-method runs, slowest first
+     */
+    std::vector<Entry> getSlowestTestMethods() const;
+
+    /*!
+     * Returns the slowest suite runs, slowest first
+     */
+    std::vector<Entry> getSlowestSuites() const;
+
+    std::chrono::nanoseconds getPhaseDuration(Phase phase) const noexcept;
+    std::vector<ParallelRun> getParallelRuns() const;
+
+    /*!
+     * Prints the summary of all recorded durations to the given stream
+     */
+    void print(std::ostream &stream) const;
+
+    /*!
+     * Returns the report the durations of all executed test-methods, suites and fixture hooks are recorded into, if any
+     */
+    static TimingReport *getActive() noexcept;
+    static void setActive(TimingReport *report) noexcept;
+
+  private:
+    const std::size_t numSlowest;
+    mutable std::mutex reportMutex;
+    // min-heaps of the slowest entries, so the fastest of them is replaced first
+    std::vector<Entry> slowestTestMethods;
+    std::vector<Entry> slowestSuites;
+    // the duration of the fastest kept test-method once the heap is full, shorter runs are skipped without locking
+    std::atomic<std::chrono::nanoseconds::rep> testMethodThreshold;
+    std::array<std::atomic<std::chrono::nanoseconds::rep>, 3> phaseDurations;
+    std::vector<ParallelRun> parallelRuns;
+
+    void insertSlowest(std::vector<Entry> &heap, const std::string &name, std::chrono::nanoseconds duration);
+  };
+
+  namespace Private {
+    /*!
+     * Runs the given fixture hook and adds its duration to the given phase of the active TimingReport, if any
+     */
+    template <typename Hook>
+    bool runFixture(TimingReport::Phase phase, const Hook &hook) {
+      TimingReport *report = TimingReport::getActive();
+      if (report == nullptr)
+        return hook();
+      const auto start = std::chrono::steady_clock::now();
+      const bool result = hook();
+      report->recordPhase(phase, std::chrono::steady_clock::now() - start);
+      return result;
+    }
+  } // namespace Private
+} // namespace Test
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace Test {
+
+  /*!
+   * A single background thread tracking the deadlines of the running test-methods.
+   *
+   * Every watched deadline is associated with a callback, which is executed on the watchdog thread when the deadline
+   * expires before the deadline is cancelled. The thread is only started when the first deadline is watched and sleeps
+   * until the next deadline expires, so watching a test-method costs only a single insertion and removal.
+   */
+  class Watchdog {
+  public:
+    using Callback = std::function<void()>;
+    using Handle = uint64_t;
+
+    Watchdog();
+    Watchdog(const Watchdog &) = delete;
+    Watchdog(Watchdog &&) noexcept = delete;
+    ~Watchdog() noexcept;
+
+    Watchdog &operator=(const Watchdog &) = delete;
+    Watchdog &operator=(Watchdog &&) noexcept = delete;
+
+    /*!
+     * Executes the given callback on the watchdog thread once the given deadline expires
+     *
+     * \return the handle to cancel the deadline with
+     */
+    Handle watch(std::chrono::steady_clock::time_point deadline, Callback &&onExpiry);
+
+    /*!
+     * Cancels the deadline with the given handle.
+     *
+     * If the callback of the deadline is currently being executed, waits for it to finish, so any state referenced by
+     * the callback can be safely destroyed afterwards.
+     */
+    void cancel(Handle handle);
+
+    /*!
+     * Returns the watchdog used to enforce the test-method timeouts
+     */
+    static Watchdog &getDefault();
+
+    /*!
+     * Sets the timeout applied to all test-methods without explicit timeout, zero disables the default timeout
+     */
+    static void setDefaultTimeout(std::chrono::milliseconds timeout) noexcept;
+    static std::chrono::milliseconds getDefaultTimeout() noexcept;
+
+    /*!
+     * Sets the function executed before the test program is aborted, since a test-method did not return within the
+     * grace period after its timeout (see Suite::setSuiteTimeout), an empty function removes the handler.
+     *
+     * The handler is executed on the watchdog thread while other test-methods might still be running, e.g. to save the
+     * state recorded so far.
+     */
+    static void setAbortHandler(Callback &&handler);
+
+    /*!
+     * Executes the abort handler and terminates the test program with EXIT_FAILURE without running any destructors,
+     * since a hung test-method cannot be joined
+     */
+    [[noreturn]] static void abortProgram() noexcept;
+
+  private:
+    struct Entry {
+      Handle handle;
+      Callback callback;
+    };
+
+    std::mutex watchdogMutex;
+    std::condition_variable changed;
+    std::condition_variable callbackDone;
+    std::multimap<std::chrono::steady_clock::time_point, Entry> deadlines;
+    Handle nextHandle;
+    // the handle of the deadline whose callback is currently executed, 0 if none
+    Handle runningHandle;
+    bool shutdown;
+    std::thread thread;
+
+    void runWatchdog();
+  };
+} // namespace Test
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Test {
+
+  /*!
+   * A bounded pool of worker threads executing tasks with work-stealing.
+   *
+   * Every worker owns a task queue. Tasks submitted from within a worker are added to the queue of that worker, tasks
+   * submitted from any other thread are distributed round-robin across all queues. A worker takes the tasks from the
+   * front of its own queue (in order of submission) and steals from the back of the other queues when its own queue
+   * runs empty.
+   *
+   * Waiting for tasks from within a worker (e.g. for nested parallel suites) executes the pending tasks of the awaited
+   * group instead of blocking the worker, so nested task groups cannot dead-lock the pool. Unrelated tasks are never
+   * run while waiting, since they would be nested within the waiting task and could delay the completion of the group.
+   */
+  class WorkerPool {
+  public:
+    using Task = std::function<void()>;
+
+    /*!
+     * A group of tasks which can be waited on together
+     */
+    class TaskGroup {
+    public:
+      TaskGroup() : pendingTasks(0), queuedTasks(0) {}
+      TaskGroup(const TaskGroup &) = delete;
+      TaskGroup(TaskGroup &&) noexcept = delete;
+      ~TaskGroup() noexcept = default;
+
+      TaskGroup &operator=(const TaskGroup &) = delete;
+      TaskGroup &operator=(TaskGroup &&) noexcept = delete;
+
+    private:
+      std::atomic<std::size_t> pendingTasks;
+      // the tasks of the group which are not yet taken by any worker
+      std::atomic<std::size_t> queuedTasks;
+      std::mutex groupMutex;
+      std::condition_variable groupDone;
+      std::exception_ptr firstError;
+
+      friend class WorkerPool;
+    };
+
+    /*!
+     * Creates a new pool with the given number of worker threads
+     *
+     * \param numWorkers The number of workers, 0 to use the number of hardware threads
+     */
+    explicit WorkerPool(unsigned numWorkers = 0);
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool(WorkerPool &&) noexcept = delete;
+    ~WorkerPool() noexcept;
+
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    WorkerPool &operator=(WorkerPool &&) noexcept = delete;
+
+    /*!
+     * Schedules the given task for execution as part of the given group
+     */
+    void submit(TaskGroup &group, Task &&task);
+
+    /*!
+     * Waits for all tasks of the given group to finish.
+     *
+     * If any task of the group threw an exception, the first exception is re-thrown.
+     */
+    void wait(TaskGroup &group);
+
+    /*!
+     * Runs the given function on the given number of workers at the same time and waits for all of them to finish.
+     *
+     * Every invocation is passed its index (0 to numThreads - 1). All invocations wait at a barrier until every one of
+     * them runs on a worker, so they start together, e.g. to measure the throughput of a concurrent data structure.
+     * If called from a worker, that worker takes part in the gang.
+     *
+     * The other members are reserved at once (idle workers first), busy workers join once their current task finished.
+     * Since a gang which cannot get enough workers would wait forever, a std::runtime_error is thrown if another gang
+     * is running on the pool (gangs waiting for each other's workers cannot start) or if fewer workers than requested
+     * can take part. Workers waiting for another task group (e.g. the suites of a nested parallel suite) only run the
+     * tasks of that group, so they cannot take part. If a reserved worker starts waiting for a task group before it
+     * joined, the gang is cancelled: the members already waiting at the barrier return without running the function
+     * and a std::runtime_error is thrown.
+     *
+     * If any invocation threw an exception, the first exception is re-thrown.
+     *
+     * \param numThreads The number of concurrent invocations, must not exceed the number of workers
+     */
+    void runGang(unsigned numThreads, const std::function<void(unsigned index)> &function);
+
+    unsigned getNumWorkers() const noexcept { return static_cast<unsigned>(workers.size()); }
+
+    /*!
+     * Returns the number of workers currently waiting for a task group, which cannot take part in a gang
+     */
+    unsigned getNumWaitingWorkers() const noexcept { return numWaitingWorkers; }
+
+    /*!
+     * Returns whether the calling thread is a worker of this pool
+     */
+    bool isWorkerThread() const noexcept;
+
+    /*!
+     * Returns the process-wide pool used by the parallel suites, created on first use
+     */
+    static WorkerPool &getDefault();
+
+    /*!
+     * Sets the number of workers for the default pool, 0 to use the number of hardware threads.
+     *
+     * NOTE: Has no effect once the default pool is created
+     */
+    static void setDefaultConcurrency(unsigned numWorkers);
+    static unsigned getDefaultConcurrency() noexcept;
+
+    /*!
+     * Abandons the default pool in a forked child process, whose worker threads only exist in the parent process. The
+     * next call to \ref getDefault creates a new pool for the child process.
+     *
+     * NOTE: Must only be called in a child process right after fork()
+     */
+    static void abandonDefault() noexcept;
+
+  private:
+    struct QueuedTask {
+      Task task;
+      TaskGroup *group;
+    };
+
+    struct WorkQueue {
+      std::mutex queueMutex;
+      std::deque<QueuedTask> tasks;
+    };
+
+    struct Gang;
+
+    // the state of a worker regarding gangs, guarded by the sleepMutex
+    struct WorkerState {
+      // whether the worker sleeps waiting for tasks
+      bool idle;
+      // whether the worker waits for a task group
+      bool waiting;
+      // whether the worker is reserved for the running gang and has not joined yet
+      bool reserved;
+      // the index in the gang the worker is reserved for
+      unsigned gangIndex;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<std::size_t> queuedTasks;
+    std::atomic<unsigned> nextQueue;
+    std::atomic<bool> shutdown;
+    std::vector<WorkerState> workerStates;
+    // the gang currently running, guarded by the sleepMutex
+    Gang *activeGang;
+    // the number of reserved workers which have not joined the gang yet
+    std::atomic<unsigned> numReservedWorkers;
+    std::atomic<unsigned> numWaitingWorkers;
+
+    void runWorker(unsigned index);
+    bool tryRunTask(unsigned preferredQueue, const TaskGroup *awaitedGroup = nullptr);
+    bool takeTask(unsigned preferredQueue, const TaskGroup *awaitedGroup, QueuedTask &task);
+    bool takeGroupTask(const TaskGroup &group, unsigned preferredQueue, QueuedTask &task);
+    void finishTask(TaskGroup &group, std::exception_ptr error);
+    void setWaiting(unsigned worker, bool waiting);
+    bool joinReservedGang(unsigned worker);
+    void runGangMember(Gang &gang, unsigned index);
+  };
+} // namespace Test
@@ -1,16 +1,35 @@
 #pragma once
 
-#include "CollectorOutput.h"
+#include "Output.h"
 
+#include <ctime>
+#include <map>
 #include <memory>
 #include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace Test {
 
   /*!
    * Outputs the test results in JUnit XML format supported by most tools
+   *
+   * The output is written while the tests run: every <testcase> element is written once its test-method finished and
+   * only counters are kept for the suites, so the memory usage does not depend on the number of assertions. The
+   * attributes of the <testsuite> element are patched in once the suite finished, if the output opened the file
+   * itself. A given stream is never seeked, since it might share its file with other writers or append to it, so the
+   * <testcase> elements of every suite are kept until the suite finished.
+   *
+   * Suites running concurrently (e.g. the sub-suites of a ParallelSuite) are written one after the other, only the
+   * suite started first is written while running. The same suite can run multiple times concurrently, a test-method is
+   * attributed to the run of its suite started on the same thread (or else the run started last).
+   *
+   * Benchmark results, fitted complexities and performance counters are written as <properties> of the <testcase>
+   * element, a benchmark without any assertions is not reported as skipped.
    */
-  class XMLOutput : public CollectorOutput {
+  class XMLOutput : public Output {
   public:
     XMLOutput(std::ostream &stream);
     XMLOutput(const std::string &outputFile);
@@ -21,11 +40,69 @@ namespace Test {
     XMLOutput &operator=(const XMLOutput &) = delete;
     XMLOutput &operator=(XMLOutput &&) = delete; // RPi cross-compiler throws on noexcept here
 
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
     void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
         std::chrono::microseconds totalDuration) override;
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override;
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override;
+    void printSuccess(const Assertion &assertion) override;
+    void printSuccessEvent(const AssertionEvent &event) override;
+    void printFailure(const Assertion &assertion) override;
+    void printBenchmark(const BenchmarkResult &result) override;
+    void printComplexity(const ComplexityResult &result) override;
+    void printPerfCounters(const PerfCounterResult &result) override;
+    void flush() override;
 
   private:
+    struct MethodInfo {
+      // the run of the suite the test-method belongs to
+      uint64_t suiteId;
+      std::string name;
+      // the <failure> elements
+      std::string failures;
+      // the <property> elements of the benchmark results
+      std::string properties;
+      // the <property> elements of the performance counters, which do not make a test case a benchmark
+      std::string counterProperties;
+      std::string exceptionMessage;
+      uint64_t numAssertions;
+      std::chrono::nanoseconds duration;
+    };
+
+    struct SuiteInfo {
+      uint64_t id;
+      std::string suiteName;
+      // the thread which started the suite
+      std::thread::id thread;
+      std::time_t startTime;
+      unsigned numErrors;
+      // the position of the placeholder for the <testsuite> element, if the suite is written while running
+      std::streamoff headerPosition;
+      // the <testcase> elements, if the suite is not written while running
+      std::string testCases;
+    };
+
     std::unique_ptr<std::ostream> fileStream;
     std::ostream &output;
+    // whether the positions in the stream are known, i.e. the output opened the file itself
+    bool seekable;
+    // the same test-method can run concurrently on multiple threads, e.g. if its suite is added to a parallel suite
+    // twice
+    std::map<std::pair<std::thread::id, TestId>, MethodInfo> runningMethods;
+    std::vector<SuiteInfo> runningSuites;
+    uint64_t nextSuiteId;
+    // the suite written while running, if any
+    SuiteInfo *streamingSuite;
+    // the complete suites waiting for the suite written while running to finish
+    std::string pendingSuites;
+
+    SuiteInfo *findSuite(const std::string &suiteName);
+    MethodInfo *findMethod(TestId test);
+    void writeTestCase(const std::string &suiteName, const MethodInfo &method);
   };
 } // namespace Test
@@ -15,12 +15,14 @@
 #define TEST_FAIL(msg) testFailed(__FILE__, __LINE__, "", toMessage(msg));
 
 #define TEST_ASSERT(condition)                                                                                         \
-  testRun(static_cast<bool>(condition), __FILE__, __LINE__,                                                            \
-      std::string("Assertion '") + #condition + std::string("' failed"), "");
+  testRun(                                                                                                             \
+      static_cast<bool>(condition), __FILE__, __LINE__,                                                                \
+      [] { return std::string{"Assertion '" #condition "' failed"}; }, "");
 
 #define TEST_ASSERT_MSG(condition, msg)                                                                                \
-  testRun(static_cast<bool>(condition), __FILE__, __LINE__,                                                            \
-      std::string("Assertion '") + #condition + std::string("' failed"), toMessage(msg));
+  testRun(                                                                                                             \
+      static_cast<bool>(condition), __FILE__, __LINE__,                                                                \
+      [] { return std::string{"Assertion '" #condition "' failed"}; }, msg);
 
 #define TEST_ASSERT_EQUALS(expected, value)                                                                            \
   testRun(                                                                                                             \
@@ -32,7 +34,7 @@
   testRun(                                                                                                             \
       Test::Comparisons::isSame(expected, value), __FILE__, __LINE__,                                                  \
       [&] { return "Got " + Test::Formats::to_string(value) + ", expected " + Test::Formats::to_string(expected); },   \
-      toMessage(msg));
+      msg);
 
 #define TEST_ASSERT_EQUALS_OBJ(expected, value)                                                                        \
   { static_assert(false, "This macro is deprecated, use TEST_ASSERT_EQUALS instead"); }
@@ -54,7 +56,7 @@
         return "Got " + Test::Formats::to_string(value) + ", expected " + Test::Formats::to_string(expected) +         \
                " +/- " + Test::Formats::to_string(delta);                                                              \
       },                                                                                                               \
-      toMessage(msg));
+      msg);
 
 #define TEST_ASSERT_ULP(expected, value, numULP)                                                                       \
   {                                                                                                                    \
@@ -79,7 +81,7 @@
           return "Got " + Test::Formats::to_string(value) + ", expected " + Test::Formats::to_string(expected) +       \
                  " +/- " + (Test::Formats::to_string(delta) + " (") + (Test::Formats::to_string(numULP) + " ULP)");    \
         },                                                                                                             \
-        toMessage(msg));                                                                                               \
+        msg);                                                                                                          \
   }
 
 #define TEST_THROWS(expression, except)                                                                                \
@@ -90,7 +92,7 @@
       testFailed(__FILE__, __LINE__,                                                                                   \
           std::string("Expected exception of type '") + #except + std::string("' was not thrown!"), "");               \
     } catch (except &) {                                                                                               \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (std::exception & ex) {                                                                                    \
       /*If we get here, wrong exception was thrown*/                                                                   \
       testFailed(__FILE__, __LINE__, std::string("Wrong Exception was thrown: ") + ex.what(), "");                     \
@@ -109,7 +111,7 @@
       testFailed(__FILE__, __LINE__,                                                                                   \
           std::string("Expected exception of type '") + #except + std::string("' was not thrown!"), toMessage(msg));   \
     } catch (except &) {                                                                                               \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (std::exception & ex) {                                                                                    \
       /*If we get here, wrong exception was thrown*/                                                                   \
       testFailed(__FILE__, __LINE__, std::string("Wrong Exception was thrown: ") + ex.what(), toMessage(msg));         \
@@ -127,7 +129,7 @@
       /*If we get here, no exception was thrown*/                                                                      \
       testFailed(__FILE__, __LINE__, "Expected exception, nothing was thrown!", "");                                   \
     } catch (std::exception &) {                                                                                       \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (...) {                                                                                                    \
       /* Any other type than an exception was thrown*/                                                                 \
       testFailed(__FILE__, __LINE__, "A non-exception-type was thrown!", "");                                          \
@@ -141,7 +143,7 @@
       /*If we get here, no exception was thrown*/                                                                      \
       testFailed(__FILE__, __LINE__, "Expected exception, nothing was thrown!", toMessage(msg));                       \
     } catch (std::exception &) {                                                                                       \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (...) {                                                                                                    \
       /* Any other type than an exception was thrown*/                                                                 \
       testFailed(__FILE__, __LINE__, "A non-exception-type was thrown!", toMessage(msg));                              \
@@ -153,7 +155,7 @@
     try {                                                                                                              \
       expression;                                                                                                      \
       /*If we get here, no exception was thrown*/                                                                      \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (std::exception & ex) {                                                                                    \
       testFailed(__FILE__, __LINE__, std::string("Exception thrown: ") + ex.what(), "");                               \
     } catch (...) {                                                                                                    \
@@ -167,7 +169,7 @@
     try {                                                                                                              \
       expression;                                                                                                      \
       /*If we get here, no exception was thrown*/                                                                      \
-      testSucceeded(Test::Assertion(__FILE__, __LINE__));                                                              \
+      testSucceeded(__FILE__, __LINE__);                                                                               \
     } catch (std::exception & ex) {                                                                                    \
       testFailed(__FILE__, __LINE__, std::string("Exception thrown: ") + ex.what(), toMessage(msg));                   \
     } catch (...) {                                                                                                    \
@@ -189,7 +191,7 @@
   testRun(                                                                                                             \
       predicate(value), __FILE__, __LINE__,                                                                            \
       [&] { return "Value '" + Test::Formats::to_string(value) + "' did not match the predicate: " + #predicate; },    \
-      toMessage(msg));
+      msg);
 
 #define TEST_BIPREDICATE(bipredicate, value0, value1)                                                                  \
   testRun(                                                                                                             \
@@ -207,7 +209,7 @@
         return "Values '" + Test::Formats::to_string(value0) + "' and '" + Test::Formats::to_string(value1) +          \
                "' did not match the bi-predicate: " + #bipredicate;                                                    \
       },                                                                                                               \
-      toMessage(msg));
+      msg);
 
 #define TEST_ABORT(msg)                                                                                                \
   {                                                                                                                    \
@@ -217,14 +219,14 @@
 
 #define TEST_STRING_EQUALS(expected, value)                                                                            \
   testRun(                                                                                                             \
-      std::string(expected) == (value), __FILE__, __LINE__,                                                            \
+      Test::Comparisons::isSameString(expected, value), __FILE__, __LINE__,                                            \
       [&] { return "Got \"" + std::string(value) + "\", expected \"" + std::string(expected) + "\""; }, "");
 
 #define TEST_STRING_EQUALS_MSG(expected, value, msg)                                                                   \
   testRun(                                                                                                             \
-      std::string(expected) == (value), __FILE__, __LINE__,                                                            \
+      Test::Comparisons::isSameString(expected, value), __FILE__, __LINE__,                                            \
       [&] { return "Got \"" + std::string(value) + "\", expected \"" + std::string(expected) + "\""; },                \
-      toMessage(msg));
+      msg);
 
 #define TEST_ASSERT_NOT_EQUALS(expected, value)                                                                        \
   testRun(                                                                                                             \
@@ -242,12 +244,14 @@
         return "Expected " + Test::Formats::to_string(value) + " to differ from " +                                    \
                Test::Formats::to_string(expected);                                                                     \
       },                                                                                                               \
-      toMessage(msg));
+      msg);
 
 #define TEST_ASSERT_FALSE(condition)                                                                                   \
-  testRun(!static_cast<bool>(condition), __FILE__, __LINE__,                                                           \
-      std::string("Assertion '") + #condition + std::string("' passed unexpectedly"), "");
+  testRun(                                                                                                             \
+      !static_cast<bool>(condition), __FILE__, __LINE__,                                                               \
+      [] { return std::string{"Assertion '" #condition "' passed unexpectedly"}; }, "");
 
 #define TEST_ASSERT_FALSE_MSG(condition, msg)                                                                          \
-  testRun(!static_cast<bool>(condition), __FILE__, __LINE__,                                                           \
-      std::string("Assertion '") + #condition + std::string("' passed unexpectedly"), toMessage(msg));
+  testRun(                                                                                                             \
+      !static_cast<bool>(condition), __FILE__, __LINE__,                                                               \
+      [] { return std::string{"Assertion '" #condition "' passed unexpectedly"}; }, msg);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <string>
+#include <utility>
 #include <type_traits>
 #ifdef __has_include
 #if __has_include(<span>)
@@ -118,5 +119,65 @@ namespace Test {
       return val1 == static_cast<T1>(val2);
     }
 #endif
+
+    ////
+    // Strings
+    ////
+
+    namespace internal {
+      inline std::pair<const char *, std::size_t> toCharacters(const char *str) {
+        return str != nullptr ? std::make_pair(str, std::char_traits<char>::length(str))
+                              : std::make_pair("", std::size_t{0});
+      }
+
+      // std::string, std::string_view and similar
+      template <typename T>
+      inline auto toCharacters(const T &str) -> decltype(std::make_pair(str.data(), str.size())) {
+        return std::make_pair(str.data(), str.size());
+      }
+
+      template <typename T, typename = void>
+      struct HasCharacters : std::false_type {};
+
+      template <typename T>
+      struct HasCharacters<T, decltype(static_cast<void>(toCharacters(std::declval<const T &>())))>
+          : std::true_type {};
+
+      template <typename T>
+      inline typename std::enable_if<HasCharacters<T>::value, std::string>::type toString(const T &str) {
+        auto chars = toCharacters(str);
+        return std::string(chars.first, chars.second);
+      }
+
+      // other types convertible to std::string
+      template <typename T>
+      inline typename std::enable_if<!HasCharacters<T>::value, std::string>::type toString(const T &str) {
+        return std::string(str);
+      }
+    } // namespace internal
+
+    /*!
+     * Compares the contents of two strings (C-strings, std::string or std::string_view) without creating any
+     * temporary string object
+     */
+    template <typename T1, typename T2>
+    inline typename std::enable_if<internal::HasCharacters<T1>::value && internal::HasCharacters<T2>::value,
+        bool>::type
+    isSameString(const T1 &val1, const T2 &val2) {
+      auto chars1 = internal::toCharacters(val1);
+      auto chars2 = internal::toCharacters(val2);
+      return chars1.second == chars2.second &&
+             std::char_traits<char>::compare(chars1.first, chars2.first, chars1.second) == 0;
+    }
+
+    /*!
+     * Compares the contents of two strings, where at least one is of a type only convertible to std::string
+     */
+    template <typename T1, typename T2>
+    inline typename std::enable_if<!internal::HasCharacters<T1>::value || !internal::HasCharacters<T2>::value,
+        bool>::type
+    isSameString(const T1 &val1, const T2 &val2) {
+      return internal::toString(val1) == internal::toString(val2);
+    }
   } // namespace Comparisons
 } // namespace Test
@@ -6,8 +6,6 @@
 #include <string>
 
 namespace Test {
-  using SuiteSupplier = std::function<Test::Suite *(void)>;
-
   void setContinueAfterFail(bool continueAfterFail);
   void ignoreArgument(const std::string &arg);
 
@@ -33,6 +31,10 @@ namespace Test {
     /*! Do not include this test-suite when listing tests by invoking this suite's TestSuite#listTests member function
      */
     OMIT_LIST_TESTS = 0x02,
+    /*! Run the test-methods of this test-suite in parallel, each worker thread on an own instance of the suite created
+     * by the registered supplier. The number of workers can be set with the --jobs command-line option
+     */
+    PARALLEL_METHODS = 0x04,
   };
 
   constexpr RegistrationFlags operator|(RegistrationFlags one, RegistrationFlags other) noexcept {
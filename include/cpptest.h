@@ -1,12 +1,24 @@
 #pragma once
 
+#include "BenchmarkBaseline.h"
+#include "BenchmarkSuite.h"
 #include "ParallelSuite.h"
+#include "PerfCounters.h"
+#include "ProcessPool.h"
 #include "TestSuite.h"
+#include "TimingHistory.h"
+#include "TimingReport.h"
+#include "Watchdog.h"
 #include "asserts.h"
 
 // Outputs
+#include "AsyncOutput.h"
+#include "BinaryLog.h"
 #include "CompilerOutput.h"
 #include "ConsoleOutput.h"
 #include "HTMLOutput.h"
+#include "NDJSONOutput.h"
+#include "OrderedOutput.h"
+#include "TeeOutput.h"
 #include "TextOutput.h"
 #include "XMLOutput.h"
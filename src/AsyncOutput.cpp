@@ -0,0 +1,346 @@
+#include "AsyncOutput.h"
+
+#include "EventStream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+using namespace Test;
+
+static std::atomic<uint64_t> nextOutputId{1};
+
+namespace {
+  // the instances to flush when the program is terminated via exit()
+  struct Registry {
+    std::mutex mutex;
+    std::set<AsyncOutput *> outputs;
+  };
+
+  Registry &getRegistry() {
+    static Registry registry;
+    return registry;
+  }
+
+  // identifies the current thread (unlike std::thread::id, which is reused) and is set when the thread exits
+  struct ThreadExit {
+    std::shared_ptr<std::atomic<bool>> exited{std::make_shared<std::atomic<bool>>(false)};
+
+    ~ThreadExit() noexcept { *exited = true; }
+  };
+} // namespace
+
+struct AsyncOutput::Producer {
+  class RingEncoder : public Private::EventEncoder {
+  public:
+    RingEncoder(AsyncOutput &output, Producer &producer) : owner(output), ring(producer) {}
+
+  protected:
+    void finishRecord() override {
+      owner.write(ring, getBuffer().data(), getBuffer().size());
+      clear();
+    }
+
+  private:
+    AsyncOutput &owner;
+    Producer &ring;
+  };
+
+  Producer(AsyncOutput &owner, std::size_t size, std::shared_ptr<std::atomic<bool>> exitFlag)
+      : threadExited(std::move(exitFlag)), buffer(size), head(0), tail(0), encoder(owner, *this),
+        decoder(owner.realOutput) {}
+
+  // set once all events of the producer thread are written to the buffer
+  const std::shared_ptr<std::atomic<bool>> threadExited;
+  std::vector<char> buffer;
+  // the total number of bytes written by the producer thread
+  std::atomic<uint64_t> head;
+  // the total number of bytes consumed by the writer thread
+  std::atomic<uint64_t> tail;
+  // only used by the producer thread
+  RingEncoder encoder;
+  // only used by the writer thread
+  Private::EventDecoder decoder;
+};
+
+AsyncOutput::AsyncOutput(Output &backingOutput, std::size_t bufferCapacity)
+    : realOutput(backingOutput), bufferSize(bufferCapacity), id(nextOutputId++), writerSleeping(false), numWaiting(0),
+      stopWriter(false), flushRequests(0), flushesDone(0) {
+  if (bufferSize == 0)
+    throw std::invalid_argument("Buffer size of asynchronous output cannot be zero");
+  static std::once_flag atExitFlag;
+  std::call_once(atExitFlag, []() {
+    // construct the registry before registering the handler, so it is destroyed after the handler ran
+    getRegistry();
+    std::atexit(&AsyncOutput::flushAllAtExit);
+  });
+  writer = std::thread(&AsyncOutput::runWriter, this);
+  std::lock_guard<std::mutex> guard(getRegistry().mutex);
+  getRegistry().outputs.insert(this);
+}
+
+AsyncOutput::~AsyncOutput() noexcept {
+  {
+    std::lock_guard<std::mutex> guard(getRegistry().mutex);
+    getRegistry().outputs.erase(this);
+  }
+  {
+    std::lock_guard<std::mutex> guard(writerMutex);
+    stopWriter = true;
+  }
+  eventsAvailable.notify_all();
+  // the writer thread writes all remaining events before stopping
+  writer.join();
+  try {
+    realOutput.flush();
+  } catch (...) {
+    // nobody to report the error to
+  }
+}
+
+void AsyncOutput::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  rethrowWriterError();
+  Producer &producer = getProducer();
+  producer.encoder.initializeSuite(suiteName, numTests);
+  // the test-methods of the suite might report their events from other threads, which must not overtake this event
+  waitUntilWritten(producer, producer.head);
+}
+
+void AsyncOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  // the events of the test-methods of the suite might have been reported from other threads, write them first
+  waitForWriter();
+  rethrowWriterError();
+  getProducer().encoder.finishSuite(suiteName, numTests, numPositiveTests, totalDuration);
+}
+
+void AsyncOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  getProducer().encoder.initializeTestMethod(suiteName, methodName, argString);
+}
+
+void AsyncOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  getProducer().encoder.finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+}
+
+void AsyncOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  getProducer().encoder.printException(suiteName, methodName, argString, ex, duration);
+}
+
+OutputEvents AsyncOutput::getConsumedEvents() const {
+  // not synchronized, the value does not change while running
+  return realOutput.getConsumedEvents();
+}
+
+void AsyncOutput::printSuccess(const Assertion &assertion) { getProducer().encoder.printSuccess(assertion); }
+
+void AsyncOutput::printSuccessEvent(const AssertionEvent &event) { getProducer().encoder.printSuccessEvent(event); }
+
+void AsyncOutput::printFailure(const Assertion &assertion) { getProducer().encoder.printFailure(assertion); }
+
+void AsyncOutput::printBenchmark(const BenchmarkResult &result) { getProducer().encoder.printBenchmark(result); }
+
+void AsyncOutput::printComplexity(const ComplexityResult &result) { getProducer().encoder.printComplexity(result); }
+
+void AsyncOutput::printPerfCounters(const PerfCounterResult &result) {
+  getProducer().encoder.printPerfCounters(result);
+}
+
+void AsyncOutput::flush() {
+  waitForWriter();
+  // the underlying output may only be accessed by the writer thread
+  const uint64_t request = ++flushRequests;
+  ++numWaiting;
+  {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    eventsAvailable.notify_one();
+    eventsWritten.wait(lock, [this, request]() { return flushesDone >= request; });
+  }
+  --numWaiting;
+  rethrowWriterError();
+}
+
+AsyncOutput::Producer &AsyncOutput::getProducer() {
+  struct Cache {
+    uint64_t outputId;
+    Producer *producer;
+  };
+  static thread_local Cache cache{0, nullptr};
+  if (cache.outputId == id)
+    return *cache.producer;
+
+  static thread_local ThreadExit threadExit;
+  std::lock_guard<std::mutex> guard(producersMutex);
+  auto it = std::find_if(producers.begin(), producers.end(),
+      [](const std::shared_ptr<Producer> &producer) { return producer->threadExited == threadExit.exited; });
+  if (it == producers.end()) {
+    producers.emplace_back(std::make_shared<Producer>(*this, bufferSize, threadExit.exited));
+    it = producers.end() - 1;
+  }
+  cache = Cache{id, it->get()};
+  return **it;
+}
+
+void AsyncOutput::write(Producer &producer, const char *data, std::size_t size) {
+  const uint64_t capacity = producer.buffer.size();
+  while (size > 0) {
+    const uint64_t head = producer.head.load(std::memory_order_relaxed);
+    const uint64_t freeSpace = capacity - (head - producer.tail.load(std::memory_order_acquire));
+    if (freeSpace == 0) {
+      // backpressure, wait for the writer thread to make room
+      waitUntilWritten(producer, head - capacity + 1);
+      continue;
+    }
+    const auto offset = static_cast<std::size_t>(head % capacity);
+    const auto chunk =
+        static_cast<std::size_t>(std::min<uint64_t>(std::min<uint64_t>(size, freeSpace), capacity - offset));
+    std::memcpy(producer.buffer.data() + offset, data, chunk);
+    // sequentially consistent, so either we see the writer thread going to sleep or it sees the new data
+    producer.head.store(head + chunk);
+    data += chunk;
+    size -= chunk;
+  }
+  wakeWriter();
+}
+
+void AsyncOutput::wakeWriter() {
+  if (writerSleeping) {
+    std::lock_guard<std::mutex> guard(writerMutex);
+    eventsAvailable.notify_one();
+  }
+}
+
+void AsyncOutput::waitUntilWritten(Producer &producer, uint64_t position) {
+  if (producer.tail >= position)
+    return;
+  ++numWaiting;
+  {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    eventsAvailable.notify_one();
+    // the writer thread notifies after writing, if it sees any thread waiting
+    eventsWritten.wait(lock, [&producer, position]() { return producer.tail >= position; });
+  }
+  --numWaiting;
+}
+
+std::vector<std::shared_ptr<AsyncOutput::Producer>> AsyncOutput::getProducers() {
+  std::lock_guard<std::mutex> guard(producersMutex);
+  return producers;
+}
+
+void AsyncOutput::retireProducers() {
+  std::lock_guard<std::mutex> guard(producersMutex);
+  producers.erase(std::remove_if(producers.begin(), producers.end(),
+                      [](const std::shared_ptr<Producer> &producer) {
+                        // checked before the buffer, so the last events of the thread are seen
+                        return *producer->threadExited && producer->head == producer->tail;
+                      }),
+      producers.end());
+}
+
+bool AsyncOutput::drain(Producer &producer) {
+  const uint64_t head = producer.head;
+  uint64_t tail = producer.tail.load(std::memory_order_relaxed);
+  if (tail == head)
+    return false;
+  const uint64_t capacity = producer.buffer.size();
+  while (tail != head) {
+    const auto offset = static_cast<std::size_t>(tail % capacity);
+    const auto chunk = static_cast<std::size_t>(std::min<uint64_t>(head - tail, capacity - offset));
+    const char *data = producer.buffer.data() + offset;
+    std::size_t size = chunk;
+    while (true) {
+      try {
+        // the decoder copies the data, so the buffer can be reused afterwards
+        producer.decoder.feed(data, size);
+        break;
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        if (!writerError)
+          writerError = std::current_exception();
+      }
+      // the failed event is dropped, replay the remaining events
+      size = 0;
+    }
+    tail += chunk;
+    producer.tail = tail;
+  }
+  return true;
+}
+
+void AsyncOutput::runWriter() {
+  while (true) {
+    const bool stopping = stopWriter;
+    bool written = false;
+    for (const auto &producer : getProducers())
+      written = drain(*producer) || written;
+    const uint64_t requestedFlushes = flushRequests;
+    if (flushesDone != requestedFlushes) {
+      try {
+        realOutput.flush();
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        if (!writerError)
+          writerError = std::current_exception();
+      }
+      flushesDone = requestedFlushes;
+      written = true;
+    }
+    if (written) {
+      if (numWaiting != 0) {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        eventsWritten.notify_all();
+      }
+      continue;
+    }
+    if (stopping)
+      // all events reported before the stop are written
+      break;
+    retireProducers();
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    writerSleeping = true;
+    // re-check after announcing to sleep, so no producer can miss waking us up
+    auto currentProducers = getProducers();
+    bool pending = stopWriter || flushesDone != flushRequests ||
+                   std::any_of(currentProducers.begin(), currentProducers.end(),
+                       [](const std::shared_ptr<Producer> &producer) { return producer->head != producer->tail; });
+    if (!pending)
+      eventsAvailable.wait(lock);
+    writerSleeping = false;
+  }
+}
+
+void AsyncOutput::waitForWriter() {
+  for (const auto &producer : getProducers())
+    waitUntilWritten(*producer, producer->head);
+}
+
+void AsyncOutput::rethrowWriterError() {
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> guard(writerMutex);
+    std::swap(error, writerError);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void AsyncOutput::flushAllAtExit() {
+  Registry &registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  for (AsyncOutput *output : registry.outputs) {
+    if (std::this_thread::get_id() == output->writer.get_id())
+      // exit() called by the underlying output, cannot wait for ourselves
+      continue;
+    try {
+      output->flush();
+    } catch (...) {
+      // the program is exiting anyway
+    }
+  }
+}
@@ -0,0 +1,222 @@
+#include "BenchmarkBaseline.h"
+
+#include "EventStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+using namespace Test;
+
+static std::atomic<BenchmarkBaseline *> activeBaseline{nullptr};
+
+// "CPBB" followed by the format version
+static const std::string FILE_HEADER{"CPBB\x01", 5};
+
+// the maximum product of the sample sizes to calculate the exact distribution of the U statistic for
+static const std::size_t MAX_EXACT_PAIRS = 1024;
+
+bool BenchmarkBaseline::load(const std::string &fileName) {
+  std::ifstream in(fileName, std::ios_base::in | std::ios_base::binary);
+  if (!in)
+    return false;
+  std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  if (content.compare(0, FILE_HEADER.size(), FILE_HEADER) != 0)
+    return false;
+
+  // every entry consists of the length-prefixed name and the varint-encoded number of samples followed by the samples
+  std::unordered_map<std::string, std::vector<double>> entries;
+  const char *data = content.data() + FILE_HEADER.size();
+  const char *end = content.data() + content.size();
+  while (data != end) {
+    uint64_t length = 0;
+    if (!Private::readVarint(data, end, length) || static_cast<uint64_t>(end - data) < length)
+      return false;
+    std::string name(data, static_cast<std::size_t>(length));
+    data += length;
+    uint64_t numSamples = 0;
+    // every sample takes 8 bytes, this also guards against allocating huge vectors for corrupted files
+    if (!Private::readVarint(data, end, numSamples) || static_cast<uint64_t>(end - data) / 8 < numSamples)
+      return false;
+    std::vector<double> samples(static_cast<std::size_t>(numSamples));
+    for (auto &sample : samples) {
+      if (!Private::readDouble(data, end, sample))
+        return false;
+    }
+    entries[std::move(name)] = std::move(samples);
+  }
+
+  std::lock_guard<std::mutex> guard(baselineMutex);
+  for (auto &entry : entries)
+    benchmarks[entry.first] = std::move(entry.second);
+  return true;
+}
+
+void BenchmarkBaseline::save(const std::string &fileName) const {
+  std::string content = FILE_HEADER;
+  {
+    std::lock_guard<std::mutex> guard(baselineMutex);
+    for (const auto &entry : benchmarks) {
+      Private::appendVarint(content, entry.first.size());
+      content.append(entry.first);
+      Private::appendVarint(content, entry.second.size());
+      for (double sample : entry.second)
+        Private::appendDouble(content, sample);
+    }
+  }
+  Private::replaceFile(fileName, content, "benchmark baseline file");
+}
+
+void BenchmarkBaseline::setRelativeThreshold(double threshold) {
+  if (!(threshold >= 0.0) || std::isinf(threshold))
+    throw std::invalid_argument("Relative threshold needs to be a non-negative number");
+  relativeThreshold = threshold;
+}
+
+void BenchmarkBaseline::setSignificanceLevel(double level) {
+  if (!(level > 0.0 && level <= 1.0))
+    throw std::invalid_argument("Significance level needs to be in the range (0, 1]");
+  significanceLevel = level;
+}
+
+bool BenchmarkBaseline::compareAndRecord(
+    const std::string &benchmarkName, const std::vector<double> &samples, Comparison &comparison) {
+  std::vector<double> baselineSamples;
+  {
+    std::lock_guard<std::mutex> guard(baselineMutex);
+    auto it = benchmarks.find(benchmarkName);
+    if (it == benchmarks.end() || it->second.empty()) {
+      benchmarks[benchmarkName] = samples;
+      return false;
+    }
+    baselineSamples = it->second;
+    if (updateExisting)
+      it->second = samples;
+  }
+  comparison = compare(baselineSamples, samples);
+  return true;
+}
+
+void BenchmarkBaseline::record(const std::string &benchmarkName, const std::vector<double> &samples) {
+  std::lock_guard<std::mutex> guard(baselineMutex);
+  benchmarks[benchmarkName] = samples;
+}
+
+bool BenchmarkBaseline::lookup(const std::string &benchmarkName, std::vector<double> &samples) const {
+  std::lock_guard<std::mutex> guard(baselineMutex);
+  auto it = benchmarks.find(benchmarkName);
+  if (it == benchmarks.end())
+    return false;
+  samples = it->second;
+  return true;
+}
+
+bool BenchmarkBaseline::empty() const {
+  std::lock_guard<std::mutex> guard(baselineMutex);
+  return benchmarks.empty();
+}
+
+static double getMedian(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  const std::size_t middle = samples.size() / 2;
+  return samples.size() % 2 == 1 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2.0;
+}
+
+BenchmarkBaseline::Comparison BenchmarkBaseline::compare(
+    const std::vector<double> &baselineSamples, const std::vector<double> &currentSamples) const {
+  Comparison comparison;
+  if (baselineSamples.empty() || currentSamples.empty())
+    return comparison;
+  comparison.baselineMedian = getMedian(baselineSamples);
+  comparison.currentMedian = getMedian(currentSamples);
+  if (comparison.baselineMedian > 0.0)
+    comparison.relativeChange = comparison.currentMedian / comparison.baselineMedian - 1.0;
+  comparison.pValue = testSlowdown(baselineSamples, currentSamples);
+  comparison.isRegression = comparison.relativeChange > relativeThreshold && comparison.pValue <= significanceLevel;
+  return comparison;
+}
+
+// the probability of a U statistic of at least the given value for the given sample sizes without ties
+static double getExactUpperTail(std::size_t numBaseline, std::size_t numCurrent, std::size_t minU) {
+  // counts[j][u] is the number of orderings of i baseline and j current samples with the U statistic u. The largest of
+  // the samples either is a baseline sample (not changing U) or a current sample (larger than all i baseline samples).
+  std::vector<std::vector<double>> counts(numCurrent + 1);
+  for (std::size_t j = 0; j <= numCurrent; ++j)
+    counts[j].assign(1, 1.0);
+  for (std::size_t i = 1; i <= numBaseline; ++i) {
+    std::vector<std::vector<double>> next(numCurrent + 1);
+    next[0].assign(1, 1.0);
+    for (std::size_t j = 1; j <= numCurrent; ++j) {
+      next[j].assign(i * j + 1, 0.0);
+      for (std::size_t u = 0; u < counts[j].size(); ++u)
+        next[j][u] += counts[j][u];
+      for (std::size_t u = 0; u < next[j - 1].size(); ++u)
+        next[j][u + i] += next[j - 1][u];
+    }
+    counts = std::move(next);
+  }
+  const auto &distribution = counts[numCurrent];
+  double total = 0.0;
+  double tail = 0.0;
+  for (std::size_t u = 0; u < distribution.size(); ++u) {
+    total += distribution[u];
+    if (u >= minU)
+      tail += distribution[u];
+  }
+  return tail / total;
+}
+
+double BenchmarkBaseline::testSlowdown(
+    const std::vector<double> &baselineSamples, const std::vector<double> &currentSamples) {
+  const std::size_t numBaseline = baselineSamples.size();
+  const std::size_t numCurrent = currentSamples.size();
+  if (numBaseline == 0 || numCurrent == 0)
+    return 1.0;
+
+  // rank all samples, tied samples get the average of their ranks
+  std::vector<std::pair<double, bool>> samples;
+  samples.reserve(numBaseline + numCurrent);
+  for (double sample : baselineSamples)
+    samples.emplace_back(sample, false);
+  for (double sample : currentSamples)
+    samples.emplace_back(sample, true);
+  std::sort(samples.begin(), samples.end());
+  const auto total = static_cast<double>(samples.size());
+  double currentRankSum = 0.0;
+  double tieCorrection = 0.0;
+  for (std::size_t start = 0; start < samples.size();) {
+    std::size_t stop = start + 1;
+    while (stop < samples.size() && samples[stop].first == samples[start].first)
+      ++stop;
+    const auto numTied = static_cast<double>(stop - start);
+    const double rank = (static_cast<double>(start + 1) + static_cast<double>(stop)) / 2.0;
+    for (std::size_t i = start; i < stop; ++i) {
+      if (samples[i].second)
+        currentRankSum += rank;
+    }
+    tieCorrection += numTied * numTied * numTied - numTied;
+    start = stop;
+  }
+
+  // the number of pairs where the current sample is slower than the baseline sample, ties count half
+  const auto n1 = static_cast<double>(numBaseline);
+  const auto n2 = static_cast<double>(numCurrent);
+  const double u = currentRankSum - n2 * (n2 + 1.0) / 2.0;
+  if (tieCorrection == 0.0 && numBaseline * numCurrent <= MAX_EXACT_PAIRS)
+    return getExactUpperTail(numBaseline, numCurrent, static_cast<std::size_t>(std::llround(u)));
+
+  const double variance = n1 * n2 / 12.0 * ((total + 1.0) - tieCorrection / (total * (total - 1.0)));
+  if (variance <= 0.0)
+    // all samples are equal
+    return 1.0;
+  const double z = (u - n1 * n2 / 2.0 - 0.5) / std::sqrt(variance);
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+BenchmarkBaseline *BenchmarkBaseline::getActive() noexcept { return activeBaseline; }
+
+void BenchmarkBaseline::setActive(BenchmarkBaseline *baseline) noexcept { activeBaseline = baseline; }
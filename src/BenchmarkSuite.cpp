@@ -0,0 +1,307 @@
+#include "BenchmarkSuite.h"
+
+#include "BenchmarkBaseline.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace Test;
+
+void Private::escapePointer(const volatile void *pointer) { (void)pointer; }
+
+BenchmarkState::BenchmarkState(uint64_t numIterations, int64_t size, unsigned index, unsigned threadCount) noexcept
+    : iterations(numIterations), inputSize(size), threadIndex(index), numThreads(threadCount),
+      remaining(numIterations), running(false), finished(false), elapsed(std::chrono::steady_clock::duration::zero()),
+      bytesPerIteration(0), itemsPerIteration(0) {}
+
+void BenchmarkState::startTimer() noexcept {
+  if (running)
+    return;
+  running = true;
+  startTime = std::chrono::steady_clock::now();
+}
+
+void BenchmarkState::stopTimer() noexcept {
+  if (!running)
+    return;
+  elapsed += std::chrono::steady_clock::now() - startTime;
+  running = false;
+}
+
+void BenchmarkState::finishIterations() noexcept {
+  stopTimer();
+  finished = true;
+}
+
+BenchmarkSuite::BenchmarkSuite(const std::string &name) : Suite(name) {}
+
+void BenchmarkSuite::addBenchmark(BenchmarkMethod method, const std::string &funcName) {
+  testMethods.emplace_back(
+      funcName, [method](Suite *suite) { static_cast<BenchmarkSuite *>(suite)->runBenchmark(method, 0); });
+}
+
+void BenchmarkSuite::addBenchmarkRange(BenchmarkMethod method, const std::string &funcName, int64_t first,
+    int64_t last, int64_t multiplier, Complexity expected) {
+  if (first < 1 || last < first || multiplier < 2)
+    throw std::invalid_argument("Invalid range of input sizes for benchmark: " + funcName);
+  const std::size_t rangeIndex = ranges.size();
+  ranges.push_back(BenchmarkRange{last, expected, {}});
+  int64_t size = first;
+  while (true) {
+    testMethods.emplace_back(funcName,
+        [method, size, rangeIndex](
+            Suite *suite) { static_cast<BenchmarkSuite *>(suite)->runRangeBenchmark(method, size, rangeIndex); },
+        std::to_string(size));
+    if (size == last)
+      break;
+    // the last size is always included, even if it is not a power of the multiplier
+    size = size > last / multiplier ? last : size * multiplier;
+  }
+}
+
+void BenchmarkSuite::addBenchmarkThreads(BenchmarkMethod method, const std::string &funcName, unsigned maxThreads) {
+  if (maxThreads == 0)
+    maxThreads =
+        benchmarkOptions.pool ? benchmarkOptions.pool->getNumWorkers() : WorkerPool::getDefaultConcurrency();
+  const std::size_t rateIndex = singleThreadRates.size();
+  singleThreadRates.push_back(0.0);
+  unsigned numThreads = 1;
+  while (true) {
+    testMethods.emplace_back(funcName,
+        [method, numThreads, rateIndex](Suite *suite) {
+          static_cast<BenchmarkSuite *>(suite)->runThreadsBenchmark(method, numThreads, rateIndex);
+        },
+        std::to_string(numThreads) + (numThreads == 1 ? " thread" : " threads"));
+    if (numThreads == maxThreads)
+      break;
+    // the maximum number of threads is always included, even if it is not a power of two
+    numThreads = numThreads > maxThreads / 2 ? maxThreads : numThreads * 2;
+  }
+}
+
+void BenchmarkSuite::setBenchmarkOptions(const BenchmarkOptions &options) {
+  if (options.repetitions == 0 || options.maxIterations == 0)
+    throw std::invalid_argument("Benchmarks need at least one repetition and iteration: " + suiteName);
+  benchmarkOptions = options;
+}
+
+// linear interpolation between the closest ranks of the sorted samples
+static double getPercentile(const std::vector<double> &sortedSamples, double percentile) {
+  const double rank = percentile / 100.0 * static_cast<double>(sortedSamples.size() - 1);
+  const auto lower = static_cast<std::size_t>(rank);
+  if (lower + 1 >= sortedSamples.size())
+    return sortedSamples.back();
+  return sortedSamples[lower] + (rank - static_cast<double>(lower)) * (sortedSamples[lower + 1] - sortedSamples[lower]);
+}
+
+BenchmarkResult BenchmarkSuite::runBenchmark(
+    BenchmarkMethod method, int64_t size, unsigned numThreads, double *singleThreadRate) {
+  const auto minTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(benchmarkOptions.minTime);
+  // calibrate the number of iterations, the calibration runs also warm up the caches
+  uint64_t iterations = 1;
+  while (true) {
+    const auto elapsed = runRepetition(method, iterations, size, numThreads).elapsed;
+    if (elapsed >= minTime || iterations >= benchmarkOptions.maxIterations)
+      break;
+    double multiplier = 10.0;
+    if (elapsed * 10 >= minTime)
+      // close to the target, overshoot a bit to not need another calibration run
+      multiplier = 1.4 * static_cast<double>(minTime.count()) / static_cast<double>(elapsed.count());
+    const auto next = static_cast<double>(iterations) * multiplier;
+    iterations = next >= static_cast<double>(benchmarkOptions.maxIterations)
+                     ? benchmarkOptions.maxIterations
+                     : std::max(iterations + 1, static_cast<uint64_t>(next));
+  }
+
+  for (unsigned i = 0; i < benchmarkOptions.warmupRepetitions; ++i)
+    runRepetition(method, iterations, size, numThreads);
+
+  std::vector<double> samples;
+  samples.reserve(benchmarkOptions.repetitions);
+  uint64_t bytesPerIteration = 0;
+  uint64_t itemsPerIteration = 0;
+  for (unsigned i = 0; i < benchmarkOptions.repetitions; ++i) {
+    const Repetition repetition = runRepetition(method, iterations, size, numThreads);
+    samples.push_back(
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(repetition.elapsed).count()) /
+        static_cast<double>(iterations));
+    bytesPerIteration = repetition.bytesPerIteration;
+    itemsPerIteration = repetition.itemsPerIteration;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  BenchmarkResult result;
+  result.suite = suiteName;
+  result.method = currentTestMethodName;
+  result.args = currentTestMethodArgs;
+  result.iterations = iterations;
+  result.threads = numThreads;
+  result.repetitions = static_cast<uint32_t>(samples.size());
+  result.minimum = samples.front();
+  result.median = getPercentile(samples, 50.0);
+  result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+  double squaredDeviations = 0.0;
+  for (double sample : samples)
+    squaredDeviations += (sample - result.mean) * (sample - result.mean);
+  result.standardDeviation =
+      samples.size() > 1 ? std::sqrt(squaredDeviations / static_cast<double>(samples.size() - 1)) : 0.0;
+  result.percentile99 = getPercentile(samples, 99.0);
+  result.bytesPerIteration = bytesPerIteration;
+  result.itemsPerIteration = itemsPerIteration;
+  if (singleThreadRate) {
+    if (numThreads == 1)
+      *singleThreadRate = result.getIterationsPerSecond();
+    else if (*singleThreadRate > 0.0)
+      // the single-threaded run is not known if only this test-method is run
+      result.scalingEfficiency = result.getIterationsPerSecond() / (numThreads * *singleThreadRate);
+  }
+  if (hasAny(consumedEvents, OutputEvents::BENCHMARK))
+    output->printBenchmark(result);
+
+  BenchmarkBaseline::Comparison comparison;
+  BenchmarkBaseline *baseline = BenchmarkBaseline::getActive();
+  if (baseline && baseline->compareAndRecord(currentTestMethodName + "(" + currentTestMethodArgs + ")", samples,
+                      comparison) &&
+      comparison.isRegression) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1) << "Benchmark is " << comparison.relativeChange * 100.0
+       << "% slower than the baseline (median " << std::setprecision(3) << comparison.currentMedian << " ns instead of "
+       << comparison.baselineMedian << " ns per iteration, p = " << std::setprecision(4) << comparison.pValue << ")";
+    testFailed(Assertion(suiteName.c_str(), 0, ss.str(), std::string{}));
+  }
+  return result;
+}
+
+void BenchmarkSuite::runThreadsBenchmark(BenchmarkMethod method, unsigned numThreads, std::size_t rateIndex) {
+  runBenchmark(method, 0, numThreads, &singleThreadRates[rateIndex]);
+}
+
+void BenchmarkSuite::runRangeBenchmark(BenchmarkMethod method, int64_t size, std::size_t rangeIndex) {
+  const BenchmarkResult result = runBenchmark(method, size);
+  BenchmarkRange &range = ranges[rangeIndex];
+  auto it = std::find_if(range.measurements.begin(), range.measurements.end(),
+      [size](const ComplexityResult::Measurement &measurement) { return measurement.size == size; });
+  if (it != range.measurements.end())
+    it->median = result.median;
+  else
+    range.measurements.push_back(ComplexityResult::Measurement{size, result.median});
+  if (size == range.lastSize) {
+    fitComplexity(range);
+    // the next run of the suite starts over
+    range.measurements.clear();
+  }
+}
+
+static double getComplexityFactor(Complexity complexity, double size) {
+  switch (complexity) {
+  case Complexity::LOGARITHMIC:
+    return std::log2(size);
+  case Complexity::LINEAR:
+    return size;
+  case Complexity::LINEARITHMIC:
+    return size * std::log2(size);
+  case Complexity::QUADRATIC:
+    return size * size;
+  default:
+    return 1.0;
+  }
+}
+
+void Private::fitComplexity(ComplexityResult &result) {
+  std::sort(result.measurements.begin(), result.measurements.end(),
+      [](const ComplexityResult::Measurement &one, const ComplexityResult::Measurement &other) {
+        return one.size < other.size;
+      });
+  result.complexity = Complexity::NONE;
+  result.coefficient = 0.0;
+  result.rms = std::numeric_limits<double>::infinity();
+  if (result.measurements.empty())
+    return;
+
+  // least squares fit of duration = coefficient * f(size) for every class, the class with the lowest error wins. On an
+  // equal error, the slower growing class is preferred. The errors are relative to the measured durations, otherwise
+  // the largest sizes dominate the fit and e.g. cache effects make linear benchmarks look linearithmic.
+  for (auto complexity : {Complexity::CONSTANT, Complexity::LOGARITHMIC, Complexity::LINEAR, Complexity::LINEARITHMIC,
+           Complexity::QUADRATIC}) {
+    // the ratios of the complexity function to the measured durations, the fit minimizes sum((1 - c * ratio)^2)
+    std::vector<double> ratios;
+    ratios.reserve(result.measurements.size());
+    double sumRatios = 0.0;
+    double sumSquares = 0.0;
+    for (const auto &measurement : result.measurements) {
+      // guards against durations too short to be measured
+      const double duration = std::max(measurement.median, 1e-3);
+      ratios.push_back(getComplexityFactor(complexity, static_cast<double>(measurement.size)) / duration);
+      sumRatios += ratios.back();
+      sumSquares += ratios.back() * ratios.back();
+    }
+    if (sumSquares == 0.0)
+      continue;
+    const double coefficient = sumRatios / sumSquares;
+    double squaredErrors = 0.0;
+    for (double ratio : ratios)
+      squaredErrors += (1.0 - coefficient * ratio) * (1.0 - coefficient * ratio);
+    const double rms = std::sqrt(squaredErrors / static_cast<double>(ratios.size()));
+    if (rms < result.rms) {
+      result.complexity = complexity;
+      result.coefficient = coefficient;
+      result.rms = rms;
+    }
+  }
+}
+
+void BenchmarkSuite::fitComplexity(BenchmarkRange &range) {
+  if (range.measurements.size() < 3)
+    return;
+  ComplexityResult result;
+  result.suite = suiteName;
+  result.method = currentTestMethodName;
+  result.args = currentTestMethodArgs;
+  result.measurements = range.measurements;
+  result.expected = range.expected;
+  Private::fitComplexity(result);
+
+  if (hasAny(consumedEvents, OutputEvents::COMPLEXITY))
+    output->printComplexity(result);
+  if (range.expected != Complexity::NONE && result.complexity > range.expected)
+    testFailed(Assertion(suiteName.c_str(), 0,
+        std::string("Benchmark scales with ") + toString(result.complexity) + ", expected at most " +
+            toString(range.expected),
+        std::string{}));
+}
+
+BenchmarkSuite::Repetition BenchmarkSuite::runRepetition(
+    BenchmarkMethod method, uint64_t iterations, int64_t size, unsigned numThreads) {
+  std::vector<std::unique_ptr<BenchmarkState>> states;
+  states.reserve(numThreads);
+  for (unsigned index = 0; index < numThreads; ++index)
+    states.emplace_back(new BenchmarkState(iterations, size, index, numThreads));
+  if (numThreads == 1)
+    (this->*method)(*states.front());
+  else
+    (benchmarkOptions.pool ? *benchmarkOptions.pool : WorkerPool::getDefault())
+        .runGang(numThreads, [&](unsigned index) { (this->*method)(*states[index]); });
+
+  Repetition repetition{std::chrono::steady_clock::duration::zero(), states.front()->bytesPerIteration,
+      states.front()->itemsPerIteration};
+  for (const auto &state : states) {
+    if (!state->finished)
+      throw std::logic_error("Benchmark did not run all iterations, it needs to loop over the Test::BenchmarkState");
+    // the threads start together, so the slowest one determines the duration of the repetition
+    repetition.elapsed = std::max(repetition.elapsed, state->elapsed);
+  }
+  if (hasFailed())
+    // the results of a failed benchmark are meaningless, skip the remaining repetitions
+    throw AssertionFailedException{};
+  // the benchmark might run without any assertion, which would otherwise check the timeout
+  checkTimeout();
+  return repetition;
+}
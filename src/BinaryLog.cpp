@@ -0,0 +1,116 @@
+#include "BinaryLog.h"
+
+#include "EventStream.h"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+using namespace Test;
+
+// the magic string and the format version
+static const std::string LOG_HEADER("cpptest-lite-log\x01", 17);
+// the size of the buffered records written at once
+static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+class BinaryLogOutput::LogEncoder : public Private::EventEncoder {
+public:
+  explicit LogEncoder(std::ostream &stream) : EventEncoder(OutputEvents::ALL, true), output(stream) {}
+
+  void writeBuffer() {
+    output.write(getBuffer().data(), static_cast<std::streamsize>(getBuffer().size()));
+    clear();
+  }
+
+protected:
+  void finishRecord() override {
+    if (getBuffer().size() >= BLOCK_SIZE)
+      writeBuffer();
+  }
+
+private:
+  std::ostream &output;
+};
+
+BinaryLogOutput::BinaryLogOutput(std::ostream &stream) : output(stream), encoder(new LogEncoder(stream)) {
+  output << LOG_HEADER;
+}
+
+BinaryLogOutput::BinaryLogOutput(const std::string &fileName)
+    : fileStream(new std::ofstream(fileName, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)),
+      output(*fileStream), encoder(new LogEncoder(*fileStream)) {
+  if (!*fileStream)
+    throw std::runtime_error("Failed to open binary log: " + fileName);
+  output << LOG_HEADER;
+}
+
+BinaryLogOutput::~BinaryLogOutput() noexcept {
+  try {
+    flush();
+  } catch (...) {
+    // nobody to report the error to
+  }
+}
+
+void BinaryLogOutput::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  encoder->initializeSuite(suiteName, numTests);
+}
+
+void BinaryLogOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  encoder->finishSuite(suiteName, numTests, numPositiveTests, totalDuration);
+}
+
+void BinaryLogOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  encoder->initializeTestMethod(suiteName, methodName, argString);
+}
+
+void BinaryLogOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  encoder->finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+}
+
+void BinaryLogOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  encoder->printException(suiteName, methodName, argString, ex, duration);
+}
+
+void BinaryLogOutput::printSuccess(const Assertion &assertion) { encoder->printSuccess(assertion); }
+
+void BinaryLogOutput::printSuccessEvent(const AssertionEvent &event) { encoder->printSuccessEvent(event); }
+
+void BinaryLogOutput::printFailure(const Assertion &assertion) { encoder->printFailure(assertion); }
+
+void BinaryLogOutput::printBenchmark(const BenchmarkResult &result) { encoder->printBenchmark(result); }
+
+void BinaryLogOutput::printComplexity(const ComplexityResult &result) { encoder->printComplexity(result); }
+
+void BinaryLogOutput::printPerfCounters(const PerfCounterResult &result) { encoder->printPerfCounters(result); }
+
+void BinaryLogOutput::flush() {
+  encoder->writeBuffer();
+  output.flush();
+}
+
+void Test::replayBinaryLog(std::istream &stream, Output &output) {
+  std::string header(LOG_HEADER.size(), '\0');
+  if (!stream.read(&header[0], static_cast<std::streamsize>(header.size())) || header != LOG_HEADER)
+    throw std::runtime_error("Not a binary log of a supported version");
+  Private::EventDecoder decoder(output);
+  std::array<char, BLOCK_SIZE> buffer{};
+  while (stream) {
+    stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (stream.gcount() > 0)
+      decoder.feed(buffer.data(), static_cast<std::size_t>(stream.gcount()));
+  }
+  if (decoder.hasPendingData())
+    throw std::runtime_error("Binary log is truncated");
+}
+
+void Test::replayBinaryLog(const std::string &fileName, Output &output) {
+  std::ifstream stream(fileName, std::ios_base::in | std::ios_base::binary);
+  if (!stream)
+    throw std::runtime_error("Failed to open binary log: " + fileName);
+  replayBinaryLog(stream, output);
+}
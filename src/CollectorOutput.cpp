@@ -1,55 +1,690 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
 #include <stdexcept>
+#include <unordered_map>
 
 #include "CollectorOutput.h"
+#include "EventStream.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 using namespace Test;
 
+static std::atomic<uint64_t> nextCollectorId{1};
+
+/*!
+ * Temporary file the completed suites are appended to as length-prefixed records, removed once closed
+ */
+class CollectorOutput::SpillFile {
+public:
+  SpillFile() : file(std::tmpfile()) {
+    if (file == nullptr)
+      throw std::runtime_error("Failed to create temporary file for collected test results");
+  }
+  SpillFile(const SpillFile &) = delete;
+  SpillFile(SpillFile &&) noexcept = delete;
+  ~SpillFile() noexcept { std::fclose(file); }
+
+  SpillFile &operator=(const SpillFile &) = delete;
+  SpillFile &operator=(SpillFile &&) noexcept = delete;
+
+  void appendRecord(const std::string &record) {
+    std::string header;
+    Private::appendVarint(header, record.size());
+    if (std::fwrite(header.data(), 1, header.size(), file) != header.size() ||
+        std::fwrite(record.data(), 1, record.size(), file) != record.size())
+      throw std::runtime_error("Failed to write collected test results to temporary file");
+  }
+
+  /*!
+   * Calls the consumer with every record in the order they were appended
+   */
+  void forEachRecord(const std::function<void(const char *, std::size_t)> &consumer) {
+    if (std::fflush(file) != 0)
+      throw std::runtime_error("Failed to write collected test results to temporary file");
+#ifndef _WIN32
+    // map the whole file, only the pages currently read are resident
+    struct stat status {};
+    if (fstat(fileno(file), &status) != 0)
+      throw std::runtime_error("Failed to read collected test results from temporary file");
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size == 0)
+      return;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (mapping == MAP_FAILED)
+      throw std::runtime_error("Failed to map collected test results from temporary file");
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    try {
+      const char *data = static_cast<const char *>(mapping);
+      const char *end = data + size;
+      uint64_t length = 0;
+      while (data != end) {
+        if (!Private::readVarint(data, end, length) || static_cast<uint64_t>(end - data) < length)
+          throw std::runtime_error("Malformed collected test results in temporary file");
+        consumer(data, static_cast<std::size_t>(length));
+        data += length;
+      }
+    } catch (...) {
+      munmap(mapping, size);
+      throw;
+    }
+    munmap(mapping, size);
+#else
+    // read one record at a time
+    std::rewind(file);
+    std::string record;
+    int c = 0;
+    while ((c = std::fgetc(file)) != EOF) {
+      uint64_t length = 0;
+      unsigned shift = 0;
+      while (true) {
+        length |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+          break;
+        shift += 7;
+        if ((c = std::fgetc(file)) == EOF)
+          throw std::runtime_error("Malformed collected test results in temporary file");
+      }
+      record.resize(static_cast<std::size_t>(length));
+      if (std::fread(&record[0], 1, record.size(), file) != record.size())
+        throw std::runtime_error("Malformed collected test results in temporary file");
+      consumer(record.data(), record.size());
+    }
+    std::fseek(file, 0, SEEK_END);
+#endif
+  }
+
+private:
+  std::FILE *file;
+};
+
+namespace {
+  struct SpillReader {
+    const char *data;
+    const char *end;
+
+    uint64_t readNumber() {
+      uint64_t value = 0;
+      if (!Private::readVarint(data, end, value))
+        throw std::runtime_error("Malformed collected test results in temporary file");
+      return value;
+    }
+
+    std::string readString() {
+      auto length = readNumber();
+      if (static_cast<uint64_t>(end - data) < length)
+        throw std::runtime_error("Malformed collected test results in temporary file");
+      std::string result(data, static_cast<std::size_t>(length));
+      data += length;
+      return result;
+    }
+
+    Assertion readFailedAssertion(const std::string &suite, const std::string &method, const std::string &args) {
+      auto file = readString();
+      auto errorMessage = readString();
+      auto userMessage = readString();
+      Assertion assertion(file.data(), static_cast<uint32_t>(readNumber()), errorMessage, userMessage);
+      assertion.suite = suite;
+      assertion.method = method;
+      assertion.args = args;
+      return assertion;
+    }
+
+    Assertion readPassedAssertion(const std::string &suite, const std::string &method, const std::string &args) {
+      auto file = readString();
+      Assertion assertion(file.data(), static_cast<uint32_t>(readNumber()));
+      assertion.suite = suite;
+      assertion.method = method;
+      assertion.args = args;
+      return assertion;
+    }
+
+    BenchmarkResult readBenchmark() {
+      BenchmarkResult result;
+      result.suite = readString();
+      result.method = readString();
+      result.args = readString();
+      result.iterations = readNumber();
+      result.repetitions = static_cast<uint32_t>(readNumber());
+      for (double *value : {&result.minimum, &result.median, &result.mean, &result.standardDeviation,
+               &result.percentile99}) {
+        if (!Private::readDouble(data, end, *value))
+          throw std::runtime_error("Malformed collected test results in temporary file");
+      }
+      result.bytesPerIteration = readNumber();
+      result.itemsPerIteration = readNumber();
+      result.threads = static_cast<uint32_t>(readNumber());
+      result.scalingEfficiency = readDecimal();
+      return result;
+    }
+
+    double readDecimal() {
+      double value = 0.0;
+      if (!Private::readDouble(data, end, value))
+        throw std::runtime_error("Malformed collected test results in temporary file");
+      return value;
+    }
+
+    ComplexityResult readComplexity() {
+      ComplexityResult result;
+      result.suite = readString();
+      result.method = readString();
+      result.args = readString();
+      for (auto numMeasurements = readNumber(); numMeasurements > 0; --numMeasurements) {
+        ComplexityResult::Measurement measurement;
+        measurement.size = static_cast<int64_t>(readNumber());
+        measurement.median = readDecimal();
+        result.measurements.push_back(measurement);
+      }
+      result.complexity = static_cast<Complexity>(readNumber());
+      result.coefficient = readDecimal();
+      result.rms = readDecimal();
+      result.expected = static_cast<Complexity>(readNumber());
+      return result;
+    }
+  };
+} // namespace
+
+static void appendString(std::string &out, const std::string &string) {
+  Private::appendVarint(out, string.size());
+  out.append(string);
+}
+
+static void appendString(std::string &out, const char *string) {
+  const std::size_t length = std::strlen(string);
+  Private::appendVarint(out, length);
+  out.append(string, length);
+}
+
+static void appendBenchmark(std::string &out, const BenchmarkResult &result) {
+  appendString(out, result.suite);
+  appendString(out, result.method);
+  appendString(out, result.args);
+  Private::appendVarint(out, result.iterations);
+  Private::appendVarint(out, result.repetitions);
+  for (double value : {result.minimum, result.median, result.mean, result.standardDeviation, result.percentile99})
+    Private::appendDouble(out, value);
+  Private::appendVarint(out, result.bytesPerIteration);
+  Private::appendVarint(out, result.itemsPerIteration);
+  Private::appendVarint(out, result.threads);
+  Private::appendDouble(out, result.scalingEfficiency);
+}
+
+static void appendComplexity(std::string &out, const ComplexityResult &result) {
+  appendString(out, result.suite);
+  appendString(out, result.method);
+  appendString(out, result.args);
+  Private::appendVarint(out, result.measurements.size());
+  for (const auto &measurement : result.measurements) {
+    Private::appendVarint(out, static_cast<uint64_t>(measurement.size));
+    Private::appendDouble(out, measurement.median);
+  }
+  Private::appendVarint(out, static_cast<uint64_t>(result.complexity));
+  Private::appendDouble(out, result.coefficient);
+  Private::appendDouble(out, result.rms);
+  Private::appendVarint(out, static_cast<uint64_t>(result.expected));
+}
+
+PerfCounterResult CollectorOutput::MethodResults::getPerfCounters() const {
+  PerfCounterResult result;
+  result.available = availableCounters;
+  result.values = counterValues;
+  return result;
+}
+
+CollectorOutput::CollectorOutput(bool keepPassedAssertions, std::size_t memoryBudget)
+    : collectorId(nextCollectorId++), keepPassed(keepPassedAssertions), memoryLimit(memoryBudget),
+      collection(new Collection()) {}
+
+CollectorOutput::CollectorOutput(CollectorOutput &&) noexcept = default;
+
+CollectorOutput::~CollectorOutput() noexcept = default;
+
+CollectorOutput &CollectorOutput::operator=(CollectorOutput &&) noexcept = default;
+
 void CollectorOutput::initializeSuite(const std::string &suiteName, const unsigned int numTests) {
-  suites.emplace_back(suiteName, numTests);
-  // get pointer to last suite
-  currentSuite = &suites.back();
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  shard.suites.emplace_back(SuiteRun{suiteName, numTests, 0, std::chrono::microseconds::zero(),
+      collection->nextSequence++, std::numeric_limits<uint64_t>::max()});
+  shard.runningSuites.push_back(&shard.suites.back());
 }
 
 void CollectorOutput::finishSuite(const std::string &suiteName, const unsigned int numTests,
     const unsigned int numPositiveTests, const std::chrono::microseconds totalDuration) {
-  if (currentSuite == nullptr)
-    throw std::runtime_error("Invalid Suite!");
-  currentSuite->numPositiveTests = numPositiveTests;
-  currentSuite->suiteDuration = totalDuration;
+  Shard &shard = getShard();
+  {
+    auto lock = lockShard(shard);
+    // the innermost running suite with the given name
+    auto it = std::find_if(shard.runningSuites.rbegin(), shard.runningSuites.rend(),
+        [&suiteName](const SuiteRun *suite) { return suite->suiteName == suiteName; });
+    if (it == shard.runningSuites.rend())
+      throw std::runtime_error("Invalid Suite!");
+    SuiteRun &suite = **it;
+    suite.numPositiveTests = numPositiveTests;
+    suite.duration = totalDuration;
+    suite.finishSequence = collection->nextSequence++;
+    shard.memoryUsage += estimateSize(suite);
+    shard.runningSuites.erase(std::next(it).base());
+  }
+  // the runningSuites are only modified by this thread
+  if (memoryLimit != 0 && shard.runningSuites.empty())
+    spillCompletedSuites();
 }
 
 void CollectorOutput::initializeTestMethod(
     const std::string &suiteName, const std::string &methodName, const std::string &argString) {
-  if (currentSuite == nullptr)
-    throw std::runtime_error("Invalid Suite!");
-  currentSuite->methods.emplace_back(methodName, argString);
-  // get pointer to last method
-  currentMethod = &(currentSuite->methods.back());
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  shard.runningMethods.push_back(&startMethod(shard, suiteName, methodName, argString));
 }
 
-void CollectorOutput::finishTestMethod(
-    const std::string &suiteName, const std::string &methodName, const std::string &argString, const bool withSuccess) {
-  if (currentMethod == nullptr)
-    throw std::runtime_error("Invalid Test-Method!");
-  currentMethod->withSuccess = withSuccess;
+void CollectorOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const bool withSuccess, std::chrono::nanoseconds duration) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, suiteName, methodName, argString);
+  method.withSuccess = withSuccess;
+  method.duration = duration;
+  shard.memoryUsage += estimateSize(method);
+  shard.runningMethods.erase(std::find(shard.runningMethods.begin(), shard.runningMethods.end(), &method));
 }
 
 void CollectorOutput::printException(const std::string &suiteName, const std::string &methodName,
-    const std::string &argString, const std::exception &ex) {
-  if (currentMethod == nullptr)
-    throw std::runtime_error("Invalid Test-Method!");
-  currentMethod->withSuccess = false;
-  currentMethod->exceptionMessage = std::string(ex.what());
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  auto it = std::find_if(shard.runningMethods.rbegin(), shard.runningMethods.rend(), [&](const MethodRun *method) {
+    return method->name->method == methodName && method->name->args == argString && method->name->suite == suiteName;
+  });
+  MethodRun *method = nullptr;
+  if (it != shard.runningMethods.rend()) {
+    method = *it;
+    shard.runningMethods.erase(std::next(it).base());
+  } else {
+    // reported from another thread, e.g. by the Watchdog aborting the test-method
+    method = &startMethod(shard, suiteName, methodName, argString);
+  }
+  method->withSuccess = false;
+  method->exceptionMessage = std::string(ex.what());
+  method->duration = duration;
+  shard.memoryUsage += estimateSize(*method);
 }
 
 void CollectorOutput::printSuccess(const Assertion &assertion) {
-  if (currentMethod == nullptr)
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, assertion.suite, assertion.method, assertion.args);
+  ++method.numPassedAssertions;
+  if (keepPassed)
+    method.passedAssertions.push_back(PassedAssertion{internFileName(shard, assertion.file), assertion.lineNumber});
+}
+
+void CollectorOutput::printSuccessEvent(const AssertionEvent &event) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  auto it = std::find_if(shard.runningMethods.rbegin(), shard.runningMethods.rend(),
+      [&event](const MethodRun *method) { return method->test == event.test; });
+  if (it == shard.runningMethods.rend())
     throw std::runtime_error("Invalid Test-Method!");
-  currentMethod->passedAssertions.push_back(assertion);
+  ++(*it)->numPassedAssertions;
+  // the file of an event is a string literal, so it does not need to be interned
+  if (keepPassed)
+    (*it)->passedAssertions.push_back(PassedAssertion{event.file, event.lineNumber});
 }
 
 void CollectorOutput::printFailure(const Assertion &assertion) {
-  if (currentMethod == nullptr)
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, assertion.suite, assertion.method, assertion.args);
+  method.failedAssertions.push_back(FailedAssertion{
+      internFileName(shard, assertion.file), assertion.lineNumber, assertion.errorMessage, assertion.userMessage});
+}
+
+void CollectorOutput::printBenchmark(const BenchmarkResult &result) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, result.suite, result.method, result.args);
+  auto &benchmarks = getResults(method).benchmarks;
+  benchmarks.push_back(result);
+  // the names are stored once for the test-method
+  benchmarks.back().suite.clear();
+  benchmarks.back().method.clear();
+  benchmarks.back().args.clear();
+}
+
+void CollectorOutput::printComplexity(const ComplexityResult &result) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, result.suite, result.method, result.args);
+  auto &complexities = getResults(method).complexities;
+  complexities.push_back(result);
+  complexities.back().suite.clear();
+  complexities.back().method.clear();
+  complexities.back().args.clear();
+}
+
+void CollectorOutput::printPerfCounters(const PerfCounterResult &result) {
+  Shard &shard = getShard();
+  auto lock = lockShard(shard);
+  MethodRun &method = findRunningMethod(shard, result.suite, result.method, result.args);
+  auto &results = getResults(method);
+  results.availableCounters = result.available;
+  results.counterValues = result.values;
+}
+
+void CollectorOutput::visitSuites(const std::function<void(const SuiteInfo &)> &visitor) const {
+  std::lock_guard<std::mutex> guard(collection->shardsMutex);
+  if (collection->spillFile) {
+    collection->spillFile->forEachRecord([&visitor](const char *data, std::size_t size) {
+      SpillReader reader{data, data + size};
+      const std::string suiteName = reader.readString();
+      SuiteInfo suite(suiteName, static_cast<unsigned>(reader.readNumber()));
+      suite.numPositiveTests = static_cast<unsigned>(reader.readNumber());
+      suite.suiteDuration = std::chrono::microseconds{static_cast<int64_t>(reader.readNumber())};
+      const auto numMethods = static_cast<std::size_t>(reader.readNumber());
+      suite.methods.reserve(numMethods);
+      while (suite.methods.size() < numMethods) {
+        const std::string methodName = reader.readString();
+        suite.methods.emplace_back(methodName, reader.readString());
+        TestMethodInfo &method = suite.methods.back();
+        method.exceptionMessage = reader.readString();
+        method.duration = std::chrono::nanoseconds{static_cast<int64_t>(reader.readNumber())};
+        method.numPassedAssertions = reader.readNumber();
+        method.withSuccess = reader.readNumber() != 0;
+        for (auto numFailed = reader.readNumber(); numFailed > 0; --numFailed)
+          method.failedAssertions.emplace_back(reader.readFailedAssertion(suiteName, methodName, method.argString));
+        for (auto numPassed = reader.readNumber(); numPassed > 0; --numPassed)
+          method.passedAssertions.emplace_back(reader.readPassedAssertion(suiteName, methodName, method.argString));
+        if (reader.readNumber() != 0) {
+          std::shared_ptr<MethodResults> results(new MethodResults());
+          for (auto numBenchmarks = reader.readNumber(); numBenchmarks > 0; --numBenchmarks)
+            results->benchmarks.emplace_back(reader.readBenchmark());
+          for (auto numComplexities = reader.readNumber(); numComplexities > 0; --numComplexities)
+            results->complexities.emplace_back(reader.readComplexity());
+          results->availableCounters = static_cast<uint32_t>(reader.readNumber());
+          for (std::size_t i = 0; i < results->counterValues.size(); ++i) {
+            if ((results->availableCounters & (1u << i)) != 0)
+              results->counterValues[i] = reader.readNumber();
+          }
+          method.results = std::move(results);
+        }
+      }
+      visitor(suite);
+    });
+  }
+  for (const auto &merged : mergeShards(std::numeric_limits<uint64_t>::max())) {
+    SuiteInfo suite(merged.suite->suiteName, merged.suite->numTests);
+    suite.numPositiveTests = merged.suite->numPositiveTests;
+    suite.suiteDuration = merged.suite->duration;
+    suite.methods.reserve(merged.methods.size());
+    for (const auto *method : merged.methods)
+      suite.methods.emplace_back(toMethodInfo(*method));
+    visitor(suite);
+  }
+}
+
+std::size_t CollectorOutput::getNumSpilledSuites() const {
+  std::lock_guard<std::mutex> guard(collection->shardsMutex);
+  return collection->numSpilledSuites;
+}
+
+std::vector<CollectorOutput::MergedSuite> CollectorOutput::mergeShards(uint64_t endSequence) const {
+  std::vector<const SuiteRun *> suiteRuns;
+  for (const auto &shard : collection->shards) {
+    for (const auto &suite : shard->suites) {
+      if (suite.startSequence >= endSequence)
+        break;
+      suiteRuns.push_back(&suite);
+    }
+  }
+  std::sort(suiteRuns.begin(), suiteRuns.end(),
+      [](const SuiteRun *one, const SuiteRun *other) { return one->startSequence < other->startSequence; });
+
+  std::vector<MergedSuite> result;
+  result.reserve(suiteRuns.size());
+  std::unordered_map<const SuiteRun *, std::size_t> suitePositions;
+  // the positions of the suites per name, in the order they were started
+  std::map<std::string, std::vector<std::size_t>> suitesByName;
+  for (const auto *suite : suiteRuns) {
+    suitePositions.emplace(suite, result.size());
+    suitesByName[suite->suiteName].push_back(result.size());
+    result.emplace_back(MergedSuite{suite, {}});
+  }
+
+  for (const auto &shard : collection->shards) {
+    for (const auto &method : shard->methods) {
+      if (method.sequence >= endSequence)
+        break;
+      if (method.suite) {
+        result[suitePositions.at(method.suite)].methods.push_back(&method);
+        continue;
+      }
+      auto it = suitesByName.find(method.name->suite);
+      if (it == suitesByName.end())
+        continue;
+      // the innermost suite of this name started before and not finished before the test-method
+      for (auto pos = it->second.rbegin(); pos != it->second.rend(); ++pos) {
+        const SuiteRun &suite = *suiteRuns[*pos];
+        if (suite.startSequence < method.sequence && method.sequence < suite.finishSequence) {
+          result[*pos].methods.push_back(&method);
+          break;
+        }
+      }
+    }
+  }
+  for (auto &suite : result)
+    std::sort(suite.methods.begin(), suite.methods.end(),
+        [](const MethodRun *one, const MethodRun *other) { return one->sequence < other->sequence; });
+  return result;
+}
+
+void CollectorOutput::spillCompletedSuites() {
+  std::lock_guard<std::mutex> guard(collection->shardsMutex);
+  std::vector<std::unique_lock<std::mutex>> locks;
+  locks.reserve(collection->shards.size());
+  std::size_t memoryUsage = 0;
+  for (const auto &shard : collection->shards) {
+    locks.emplace_back(shard->shardMutex);
+    memoryUsage += shard->memoryUsage;
+  }
+  if (memoryUsage <= memoryLimit)
+    return;
+
+  // everything started before the first suite or test-method still running is completed
+  uint64_t endSequence = collection->nextSequence;
+  for (const auto &shard : collection->shards) {
+    for (const auto *suite : shard->runningSuites)
+      endSequence = std::min(endSequence, suite->startSequence);
+    for (const auto *method : shard->runningMethods)
+      endSequence = std::min(endSequence, method->sequence);
+  }
+  // no suite may span the end, otherwise its later test-methods would be detached from it
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &shard : collection->shards) {
+      for (const auto &suite : shard->suites) {
+        if (suite.startSequence >= endSequence)
+          break;
+        if (suite.finishSequence > endSequence) {
+          endSequence = suite.startSequence;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  const auto suites = mergeShards(endSequence);
+  if (suites.empty())
+    return;
+  if (!collection->spillFile)
+    collection->spillFile.reset(new SpillFile());
+  std::string record;
+  for (const auto &merged : suites) {
+    record.clear();
+    appendString(record, merged.suite->suiteName);
+    Private::appendVarint(record, merged.suite->numTests);
+    Private::appendVarint(record, merged.suite->numPositiveTests);
+    Private::appendVarint(record, static_cast<uint64_t>(merged.suite->duration.count()));
+    Private::appendVarint(record, merged.methods.size());
+    for (const auto *method : merged.methods) {
+      appendString(record, method->name->method);
+      appendString(record, method->name->args);
+      appendString(record, method->exceptionMessage);
+      Private::appendVarint(record, static_cast<uint64_t>(method->duration.count()));
+      Private::appendVarint(record, method->numPassedAssertions);
+      Private::appendVarint(record, method->withSuccess ? 1 : 0);
+      // the names of the test-method are only written once
+      Private::appendVarint(record, method->failedAssertions.size());
+      for (const auto &assertion : method->failedAssertions) {
+        appendString(record, assertion.file);
+        appendString(record, assertion.errorMessage);
+        appendString(record, assertion.userMessage);
+        Private::appendVarint(record, assertion.lineNumber);
+      }
+      Private::appendVarint(record, method->passedAssertions.size());
+      for (const auto &assertion : method->passedAssertions) {
+        appendString(record, assertion.file);
+        Private::appendVarint(record, assertion.lineNumber);
+      }
+      Private::appendVarint(record, method->results ? 1 : 0);
+      if (!method->results)
+        continue;
+      const MethodResults &results = *method->results;
+      Private::appendVarint(record, results.benchmarks.size());
+      for (const auto &benchmark : results.benchmarks)
+        appendBenchmark(record, benchmark);
+      Private::appendVarint(record, results.complexities.size());
+      for (const auto &complexity : results.complexities)
+        appendComplexity(record, complexity);
+      Private::appendVarint(record, results.availableCounters);
+      for (std::size_t i = 0; i < results.counterValues.size(); ++i) {
+        if ((results.availableCounters & (1u << i)) != 0)
+          Private::appendVarint(record, results.counterValues[i]);
+      }
+    }
+    collection->spillFile->appendRecord(record);
+  }
+  collection->numSpilledSuites += suites.size();
+
+  // the spilled entries are at the front of every shard
+  for (const auto &shard : collection->shards) {
+    while (!shard->suites.empty() && shard->suites.front().startSequence < endSequence) {
+      shard->memoryUsage -= estimateSize(shard->suites.front());
+      shard->suites.pop_front();
+    }
+    while (!shard->methods.empty() && shard->methods.front().sequence < endSequence) {
+      shard->memoryUsage -= estimateSize(shard->methods.front());
+      shard->methods.pop_front();
+    }
+  }
+}
+
+std::unique_lock<std::mutex> CollectorOutput::lockShard(Shard &shard) {
+  // without a memory budget, the shard is never accessed by other threads while the tests are running
+  if (memoryLimit == 0)
+    return std::unique_lock<std::mutex>(shard.shardMutex, std::defer_lock);
+  return std::unique_lock<std::mutex>(shard.shardMutex);
+}
+
+CollectorOutput::Shard &CollectorOutput::getShard() {
+  // all events of a thread are written by the same thread, so the shard is looked up without locking for most events
+  static thread_local std::pair<uint64_t, Shard *> cachedShard{0, nullptr};
+  if (cachedShard.first == collectorId)
+    return *cachedShard.second;
+  std::lock_guard<std::mutex> guard(collection->shardsMutex);
+  auto &shards = collection->shards;
+  const auto thread = std::this_thread::get_id();
+  auto it = std::find_if(
+      shards.begin(), shards.end(), [thread](const std::unique_ptr<Shard> &shard) { return shard->thread == thread; });
+  if (it == shards.end()) {
+    shards.emplace_back(new Shard{});
+    shards.back()->thread = thread;
+    it = shards.end() - 1;
+  }
+  cachedShard = std::make_pair(collectorId, it->get());
+  return **it;
+}
+
+CollectorOutput::MethodRun &CollectorOutput::startMethod(
+    Shard &shard, const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  auto suite = std::find_if(shard.runningSuites.rbegin(), shard.runningSuites.rend(),
+      [&suiteName](const SuiteRun *running) { return running->suiteName == suiteName; });
+  const TestId test = internTest(suiteName, methodName, argString);
+  shard.methods.emplace_back(MethodRun{&getTestName(test), test, false, collection->nextSequence++,
+      suite == shard.runningSuites.rend() ? nullptr : *suite, std::chrono::nanoseconds::zero(), 0, {}, {}, "",
+      nullptr});
+  return shard.methods.back();
+}
+
+std::size_t CollectorOutput::estimateSize(const SuiteRun &suite) {
+  return sizeof(SuiteRun) + suite.suiteName.size();
+}
+
+std::size_t CollectorOutput::estimateSize(const MethodRun &method) {
+  // the names are interned and shared with all runs of the test-method
+  std::size_t size = sizeof(MethodRun) + method.exceptionMessage.size() +
+                     method.passedAssertions.size() * sizeof(PassedAssertion);
+  for (const auto &assertion : method.failedAssertions)
+    size += sizeof(FailedAssertion) + assertion.errorMessage.size() + assertion.userMessage.size();
+  if (method.results) {
+    size += sizeof(MethodResults) + method.results->benchmarks.size() * sizeof(BenchmarkResult);
+    for (const auto &complexity : method.results->complexities)
+      size += sizeof(ComplexityResult) + complexity.measurements.size() * sizeof(ComplexityResult::Measurement);
+  }
+  return size;
+}
+
+CollectorOutput::MethodRun &CollectorOutput::findRunningMethod(
+    Shard &shard, const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  // usually there is only a single test-method running per thread
+  auto it = std::find_if(shard.runningMethods.rbegin(), shard.runningMethods.rend(), [&](const MethodRun *method) {
+    return method->name->method == methodName && method->name->args == argString && method->name->suite == suiteName;
+  });
+  if (it == shard.runningMethods.rend())
     throw std::runtime_error("Invalid Test-Method!");
-  currentMethod->failedAssertions.push_back(assertion);
+  return **it;
+}
+
+const char *CollectorOutput::internFileName(Shard &shard, const std::string &file) {
+  // usually all assertions of a test-method are in the same file
+  return shard.fileNames.insert(file).first->c_str();
+}
+
+CollectorOutput::MethodResults &CollectorOutput::getResults(MethodRun &method) {
+  if (!method.results)
+    method.results.reset(new MethodResults());
+  return *method.results;
+}
+
+CollectorOutput::TestMethodInfo CollectorOutput::toMethodInfo(const MethodRun &method) {
+  const TestName &name = *method.name;
+  TestMethodInfo info(name.method, name.args);
+  info.exceptionMessage = method.exceptionMessage;
+  info.withSuccess = method.withSuccess;
+  info.duration = method.duration;
+  info.numPassedAssertions = method.numPassedAssertions;
+  info.results = method.results;
+  info.failedAssertions.reserve(method.failedAssertions.size());
+  for (const auto &failed : method.failedAssertions) {
+    info.failedAssertions.emplace_back(failed.file, failed.lineNumber, failed.errorMessage, failed.userMessage);
+    info.failedAssertions.back().suite = name.suite;
+    info.failedAssertions.back().method = name.method;
+    info.failedAssertions.back().args = name.args;
+  }
+  info.passedAssertions.reserve(method.passedAssertions.size());
+  for (const auto &passed : method.passedAssertions) {
+    info.passedAssertions.emplace_back(passed.file, passed.lineNumber);
+    info.passedAssertions.back().suite = name.suite;
+    info.passedAssertions.back().method = name.method;
+    info.passedAssertions.back().args = name.args;
+  }
+  return info;
 }
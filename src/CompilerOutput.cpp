@@ -33,7 +33,8 @@ void CompilerOutput::printFailure(const Assertion &assertion) {
 }
 
 void CompilerOutput::printException(const std::string &suiteName, const std::string &methodName,
-    const std::string &argString, const std::exception &ex) {
-  Assertion assertion(suiteName.data(), 0, ex.what(), methodName.data());
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  const std::string message = std::string(ex.what()) + " (after " + Private::formatDuration(duration) + ")";
+  Assertion assertion(suiteName.data(), 0, message, methodName.data());
   printFailure(assertion);
 }
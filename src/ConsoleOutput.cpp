@@ -20,12 +20,12 @@ void ConsoleOutput::finishSuite(const std::string &suiteName, const unsigned int
   stream << resetColors;
 }
 
-void ConsoleOutput::finishTestMethod(
-    const std::string &suiteName, const std::string &methodName, const std::string &argString, const bool withSuccess) {
+void ConsoleOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const bool withSuccess, std::chrono::nanoseconds duration) {
   if (!withSuccess) {
     stream << errorColor;
   }
-  TextOutput::finishTestMethod(suiteName, methodName, argString, withSuccess);
+  TextOutput::finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
   stream << resetColors;
 }
 
@@ -42,8 +42,8 @@ void ConsoleOutput::printFailure(const Assertion &assertion) {
 }
 
 void ConsoleOutput::printException(const std::string &suiteName, const std::string &methodName,
-    const std::string &argString, const std::exception &ex) {
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
   stream << errorColor;
-  TextOutput::printException(suiteName, methodName, argString, ex);
+  TextOutput::printException(suiteName, methodName, argString, ex, duration);
   stream << resetColors;
 }
@@ -0,0 +1,464 @@
+#include "EventStream.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Test;
+using namespace Test::Private;
+
+void EventEncoder::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  beginRecord(EventType::INITIALIZE_SUITE);
+  writeName(suiteName);
+  writeVarint(numTests);
+  endRecord();
+}
+
+void EventEncoder::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  beginRecord(EventType::FINISH_SUITE);
+  writeName(suiteName);
+  writeVarint(numTests);
+  writeVarint(numPositiveTests);
+  writeVarint(static_cast<uint64_t>(totalDuration.count()));
+  endRecord();
+}
+
+void EventEncoder::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  beginRecord(EventType::INITIALIZE_TEST_METHOD);
+  writeName(suiteName);
+  writeName(methodName);
+  writeName(argString);
+  endRecord();
+}
+
+void EventEncoder::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  beginRecord(EventType::FINISH_TEST_METHOD);
+  writeName(suiteName);
+  writeName(methodName);
+  writeName(argString);
+  writeVarint(withSuccess ? 1 : 0);
+  writeVarint(static_cast<uint64_t>(duration.count()));
+  endRecord();
+}
+
+void EventEncoder::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  beginRecord(EventType::EXCEPTION);
+  writeName(suiteName);
+  writeName(methodName);
+  writeName(argString);
+  writeString(ex.what());
+  writeVarint(static_cast<uint64_t>(duration.count()));
+  endRecord();
+}
+
+void EventEncoder::printSuccess(const Assertion &assertion) {
+  beginRecord(EventType::SUCCESS);
+  writeAssertion(assertion);
+  endRecord();
+}
+
+void EventEncoder::printSuccessEvent(const AssertionEvent &event) {
+  // same record as for printSuccess, but without creating the full assertion
+  if (lastTestName == nullptr || lastTest != event.test) {
+    lastTestName = &getTestName(event.test);
+    lastTest = event.test;
+  }
+  const TestName &name = *lastTestName;
+  beginRecord(EventType::SUCCESS);
+  writeName(name.suite);
+  if (!interning)
+    writeString(event.file);
+  else {
+    auto it = fileNames.find(event.file);
+    if (it == fileNames.end())
+      it = fileNames.emplace(event.file, internString(event.file)).first;
+    writeVarint((it->second << 1) | 1);
+  }
+  writeName(name.method);
+  writeName(name.args);
+  writeVarint(0);
+  writeVarint(0);
+  writeVarint(event.lineNumber);
+  endRecord();
+}
+
+void EventEncoder::printFailure(const Assertion &assertion) {
+  beginRecord(EventType::FAILURE);
+  writeAssertion(assertion);
+  endRecord();
+}
+
+void EventEncoder::printBenchmark(const BenchmarkResult &result) {
+  beginRecord(EventType::BENCHMARK);
+  writeName(result.suite);
+  writeName(result.method);
+  writeName(result.args);
+  writeVarint(result.iterations);
+  writeVarint(result.repetitions);
+  appendDouble(record, result.minimum);
+  appendDouble(record, result.median);
+  appendDouble(record, result.mean);
+  appendDouble(record, result.standardDeviation);
+  appendDouble(record, result.percentile99);
+  writeVarint(result.bytesPerIteration);
+  writeVarint(result.itemsPerIteration);
+  writeVarint(result.threads);
+  appendDouble(record, result.scalingEfficiency);
+  endRecord();
+}
+
+void EventEncoder::printComplexity(const ComplexityResult &result) {
+  beginRecord(EventType::COMPLEXITY);
+  writeName(result.suite);
+  writeName(result.method);
+  writeName(result.args);
+  writeVarint(result.measurements.size());
+  for (const auto &measurement : result.measurements) {
+    writeVarint(static_cast<uint64_t>(measurement.size));
+    appendDouble(record, measurement.median);
+  }
+  writeVarint(static_cast<uint64_t>(result.complexity));
+  appendDouble(record, result.coefficient);
+  appendDouble(record, result.rms);
+  writeVarint(static_cast<uint64_t>(result.expected));
+  endRecord();
+}
+
+void EventEncoder::printPerfCounters(const PerfCounterResult &result) {
+  beginRecord(EventType::PERF_COUNTERS);
+  writeName(result.suite);
+  writeName(result.method);
+  writeName(result.args);
+  // only the available counters are written
+  writeVarint(result.available);
+  for (std::size_t i = 0; i < result.values.size(); ++i) {
+    if (result.has(static_cast<PerfCounter>(i)))
+      writeVarint(result.values[i]);
+  }
+  endRecord();
+}
+
+void EventEncoder::writeResult(bool success, std::chrono::microseconds duration) {
+  beginRecord(EventType::TEST_RESULT);
+  writeVarint(success ? 1 : 0);
+  writeVarint(static_cast<uint64_t>(duration.count()));
+  endRecord();
+}
+
+void EventEncoder::beginRecord(EventType type) {
+  record.clear();
+  record.push_back(static_cast<char>(type));
+}
+
+void Private::appendVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void EventEncoder::endRecord() {
+  appendVarint(buffer, record.size());
+  buffer.append(record);
+  finishRecord();
+}
+
+void EventEncoder::writeVarint(uint64_t value) { appendVarint(record, value); }
+
+void EventEncoder::writeString(const std::string &string) {
+  writeVarint(static_cast<uint64_t>(string.size()) << 1);
+  record.append(string);
+}
+
+void EventEncoder::writeName(const std::string &name) {
+  if (interning)
+    writeVarint((internString(name) << 1) | 1);
+  else
+    writeString(name);
+}
+
+uint64_t EventEncoder::internString(const std::string &string) {
+  auto it = stringTable.find(string);
+  if (it != stringTable.end())
+    return it->second;
+  const uint64_t index = stringTable.size();
+  stringTable.emplace(string, index);
+  // the definition is written before the record currently being built
+  std::string definition(1, static_cast<char>(EventType::STRING));
+  appendVarint(definition, static_cast<uint64_t>(string.size()) << 1);
+  definition.append(string);
+  appendVarint(buffer, definition.size());
+  buffer.append(definition);
+  return index;
+}
+
+void EventEncoder::writeAssertion(const Assertion &assertion) {
+  writeName(assertion.suite);
+  writeName(assertion.file);
+  writeName(assertion.method);
+  writeName(assertion.args);
+  writeString(assertion.errorMessage);
+  writeString(assertion.userMessage);
+  writeVarint(assertion.lineNumber);
+}
+
+bool Private::readVarint(const char *&data, const char *end, uint64_t &value) {
+  value = 0;
+  unsigned shift = 0;
+  while (data != end && shift < 64) {
+    auto byte = static_cast<uint8_t>(*data++);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+    shift += 7;
+  }
+  return false;
+}
+
+void Private::appendDouble(std::string &out, double value) {
+  uint64_t bits = 0;
+  static_assert(sizeof(bits) == sizeof(value), "Unsupported floating-point type");
+  std::memcpy(&bits, &value, sizeof(value));
+  for (unsigned i = 0; i < sizeof(bits); ++i)
+    out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+}
+
+bool Private::readDouble(const char *&data, const char *end, double &value) {
+  uint64_t bits = 0;
+  if (end - data < static_cast<std::ptrdiff_t>(sizeof(bits)))
+    return false;
+  for (unsigned i = 0; i < sizeof(bits); ++i)
+    bits |= static_cast<uint64_t>(static_cast<uint8_t>(*data++)) << (8 * i);
+  std::memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+void Private::replaceFile(const std::string &fileName, const std::string &content, const std::string &description) {
+  static std::atomic<unsigned> nextFile{0};
+#ifdef _WIN32
+  const auto processId = _getpid();
+#else
+  const auto processId = getpid();
+#endif
+  const std::string tmpFileName =
+      fileName + "." + std::to_string(processId) + "." + std::to_string(nextFile++) + ".tmp";
+  {
+    std::ofstream out(tmpFileName, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (!out || !out.write(content.data(), static_cast<std::streamsize>(content.size())) || !out.flush()) {
+      out.close();
+      std::remove(tmpFileName.c_str());
+      throw std::runtime_error("Failed to write " + description + ": " + tmpFileName);
+    }
+  }
+#ifdef _WIN32
+  // rename does not replace existing files on Windows
+  std::remove(fileName.c_str());
+#endif
+  if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+    std::remove(tmpFileName.c_str());
+    throw std::runtime_error("Failed to replace " + description + ": " + fileName);
+  }
+}
+
+EventDecoder::EventDecoder(Output &output, ResultCallback callback)
+    : out(output), resultCallback(std::move(callback)) {}
+
+void EventDecoder::feed(const char *data, std::size_t size) {
+  pending.append(data, size);
+  const char *begin = pending.data();
+  const char *end = begin + pending.size();
+  while (begin != end) {
+    const char *recordStart = begin;
+    uint64_t length = 0;
+    if (!readVarint(recordStart, end, length) || static_cast<uint64_t>(end - recordStart) < length)
+      // incomplete record, wait for more data
+      break;
+    const char *next = recordStart + length;
+    try {
+      replay(recordStart, static_cast<std::size_t>(length));
+    } catch (...) {
+      // skip the failed record, so it is not replayed again with the next data
+      pending.erase(0, static_cast<std::size_t>(next - pending.data()));
+      throw;
+    }
+    begin = next;
+  }
+  pending.erase(0, static_cast<std::size_t>(begin - pending.data()));
+}
+
+namespace {
+  struct RecordReader {
+    const char *data;
+    const char *end;
+    const std::vector<std::string> &stringTable;
+
+    uint64_t readNumber() {
+      uint64_t value = 0;
+      if (!readVarint(data, end, value))
+        throw std::runtime_error("Malformed event record");
+      return value;
+    }
+
+    std::string readString() {
+      auto header = readNumber();
+      if ((header & 1) != 0) {
+        if ((header >> 1) >= stringTable.size())
+          throw std::runtime_error("Malformed event record");
+        return stringTable[static_cast<std::size_t>(header >> 1)];
+      }
+      auto length = header >> 1;
+      if (static_cast<uint64_t>(end - data) < length)
+        throw std::runtime_error("Malformed event record");
+      std::string result(data, static_cast<std::size_t>(length));
+      data += length;
+      return result;
+    }
+
+    double readDecimal() {
+      double value = 0.0;
+      if (!readDouble(data, end, value))
+        throw std::runtime_error("Malformed event record");
+      return value;
+    }
+
+    Assertion readAssertion() {
+      auto suite = readString();
+      auto file = readString();
+      auto method = readString();
+      auto args = readString();
+      auto errorMessage = readString();
+      auto userMessage = readString();
+      Assertion assertion(file.c_str(), static_cast<uint32_t>(readNumber()), errorMessage, userMessage);
+      assertion.suite = std::move(suite);
+      assertion.method = std::move(method);
+      assertion.args = std::move(args);
+      return assertion;
+    }
+  };
+} // namespace
+
+void EventDecoder::replay(const char *data, std::size_t size) {
+  if (size == 0)
+    throw std::runtime_error("Malformed event record");
+  RecordReader reader{data + 1, data + size, stringTable};
+  switch (static_cast<EventType>(*data)) {
+  case EventType::INITIALIZE_SUITE: {
+    auto suiteName = reader.readString();
+    out.initializeSuite(suiteName, static_cast<unsigned>(reader.readNumber()));
+    break;
+  }
+  case EventType::FINISH_SUITE: {
+    auto suiteName = reader.readString();
+    auto numTests = static_cast<unsigned>(reader.readNumber());
+    auto numPositiveTests = static_cast<unsigned>(reader.readNumber());
+    auto duration = std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(reader.readNumber())};
+    out.finishSuite(suiteName, numTests, numPositiveTests, duration);
+    break;
+  }
+  case EventType::INITIALIZE_TEST_METHOD: {
+    auto suiteName = reader.readString();
+    auto methodName = reader.readString();
+    out.initializeTestMethod(suiteName, methodName, reader.readString());
+    break;
+  }
+  case EventType::FINISH_TEST_METHOD: {
+    auto suiteName = reader.readString();
+    auto methodName = reader.readString();
+    auto argString = reader.readString();
+    bool withSuccess = reader.readNumber() != 0;
+    auto duration = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(reader.readNumber())};
+    out.finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+    break;
+  }
+  case EventType::EXCEPTION: {
+    auto suiteName = reader.readString();
+    auto methodName = reader.readString();
+    auto argString = reader.readString();
+    std::runtime_error ex(reader.readString());
+    auto duration = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(reader.readNumber())};
+    out.printException(suiteName, methodName, argString, ex, duration);
+    break;
+  }
+  case EventType::SUCCESS:
+    out.printSuccess(reader.readAssertion());
+    break;
+  case EventType::FAILURE:
+    out.printFailure(reader.readAssertion());
+    break;
+  case EventType::BENCHMARK: {
+    BenchmarkResult result;
+    result.suite = reader.readString();
+    result.method = reader.readString();
+    result.args = reader.readString();
+    result.iterations = reader.readNumber();
+    result.repetitions = static_cast<uint32_t>(reader.readNumber());
+    result.minimum = reader.readDecimal();
+    result.median = reader.readDecimal();
+    result.mean = reader.readDecimal();
+    result.standardDeviation = reader.readDecimal();
+    result.percentile99 = reader.readDecimal();
+    result.bytesPerIteration = reader.readNumber();
+    result.itemsPerIteration = reader.readNumber();
+    result.threads = static_cast<uint32_t>(reader.readNumber());
+    result.scalingEfficiency = reader.readDecimal();
+    out.printBenchmark(result);
+    break;
+  }
+  case EventType::COMPLEXITY: {
+    ComplexityResult result;
+    result.suite = reader.readString();
+    result.method = reader.readString();
+    result.args = reader.readString();
+    for (auto numMeasurements = reader.readNumber(); numMeasurements > 0; --numMeasurements) {
+      ComplexityResult::Measurement measurement;
+      measurement.size = static_cast<int64_t>(reader.readNumber());
+      measurement.median = reader.readDecimal();
+      result.measurements.push_back(measurement);
+    }
+    result.complexity = static_cast<Complexity>(reader.readNumber());
+    result.coefficient = reader.readDecimal();
+    result.rms = reader.readDecimal();
+    result.expected = static_cast<Complexity>(reader.readNumber());
+    out.printComplexity(result);
+    break;
+  }
+  case EventType::PERF_COUNTERS: {
+    PerfCounterResult result;
+    result.suite = reader.readString();
+    result.method = reader.readString();
+    result.args = reader.readString();
+    const auto available = reader.readNumber();
+    for (std::size_t i = 0; i < result.values.size(); ++i) {
+      if ((available & (1u << i)) != 0)
+        result.set(static_cast<PerfCounter>(i), reader.readNumber());
+    }
+    out.printPerfCounters(result);
+    break;
+  }
+  case EventType::STRING:
+    stringTable.emplace_back(reader.readString());
+    break;
+  case EventType::TEST_RESULT: {
+    bool success = reader.readNumber() != 0;
+    auto duration = std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(reader.readNumber())};
+    if (resultCallback)
+      resultCallback(success, duration);
+    break;
+  }
+  default:
+    throw std::runtime_error("Unknown event record type: " + std::to_string(static_cast<unsigned>(*data)));
+  }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Output.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Test {
+  namespace Private {
+
+    enum class EventType : uint8_t {
+      INITIALIZE_SUITE = 1,
+      FINISH_SUITE = 2,
+      INITIALIZE_TEST_METHOD = 3,
+      FINISH_TEST_METHOD = 4,
+      EXCEPTION = 5,
+      SUCCESS = 6,
+      FAILURE = 7,
+      // not an Output event, the result of a single test-method as returned by Suite::runTestMethod
+      TEST_RESULT = 8,
+      // not an Output event, defines the next entry of the string table
+      STRING = 9,
+      BENCHMARK = 10,
+      COMPLEXITY = 11,
+      PERF_COUNTERS = 12,
+    };
+
+    /*!
+     * Output serializing all events into a compact byte stream which can be decoded by \ref EventDecoder.
+     *
+     * Every record consists of the varint-encoded length of the record, the event type and the event fields. Integers
+     * are varint-encoded. Strings are either written inline, prefixed with their length shifted left by one, or as
+     * reference into the string table, as index shifted left by one with the lowest bit set.
+     *
+     * If interning is enabled, the names of suites, test-methods, arguments and source files are added to the string
+     * table on their first use (by writing a STRING record before the record using them) and referenced afterwards.
+     * The decoder must then see all records in order, e.g. a single continuous log.
+     */
+    class EventEncoder : public Output {
+    public:
+      /*!
+       * \param encodedEvents The kinds of events to encode, e.g. the events consumed by the Output the decoded events
+       * are replayed into. The results of the test-methods (see \ref writeResult) are always encoded.
+       */
+      explicit EventEncoder(OutputEvents encodedEvents = OutputEvents::ALL, bool internStrings = false)
+          : consumedEvents(encodedEvents), interning(internStrings), lastTest(0), lastTestName(nullptr) {}
+      EventEncoder(const EventEncoder &) = delete;
+      EventEncoder(EventEncoder &&) noexcept = delete;
+      ~EventEncoder() noexcept override = default;
+
+      EventEncoder &operator=(const EventEncoder &) = delete;
+      EventEncoder &operator=(EventEncoder &&) noexcept = delete;
+
+      void initializeSuite(const std::string &suiteName, unsigned int numTests) override;
+      void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+          std::chrono::microseconds totalDuration) override;
+      void initializeTestMethod(
+          const std::string &suiteName, const std::string &methodName, const std::string &argString) override;
+      void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+          bool withSuccess, std::chrono::nanoseconds duration) override;
+      void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+          const std::exception &ex, std::chrono::nanoseconds duration) override;
+      OutputEvents getConsumedEvents() const override { return consumedEvents; }
+      void printSuccess(const Assertion &assertion) override;
+      void printSuccessEvent(const AssertionEvent &event) override;
+      void printFailure(const Assertion &assertion) override;
+      void printBenchmark(const BenchmarkResult &result) override;
+      void printComplexity(const ComplexityResult &result) override;
+      void printPerfCounters(const PerfCounterResult &result) override;
+
+      /*!
+       * Writes the result of a single test-method
+       */
+      void writeResult(bool success, std::chrono::microseconds duration);
+
+      const std::string &getBuffer() const noexcept { return buffer; }
+      void clear() noexcept { buffer.clear(); }
+
+    protected:
+      /*!
+       * Called after every complete record written to the buffer, e.g. to flush the buffer
+       */
+      virtual void finishRecord() {}
+
+    private:
+      const OutputEvents consumedEvents;
+      const bool interning;
+      std::string buffer;
+      std::string record;
+      std::unordered_map<std::string, uint64_t> stringTable;
+      // the string table entries of the source file names (which are string literals) by their address
+      std::unordered_map<const char *, uint64_t> fileNames;
+      // the names of the test of the last successful assertion, to not look them up (under a lock) for every assertion
+      TestId lastTest;
+      const TestName *lastTestName;
+
+      void beginRecord(EventType type);
+      void endRecord();
+      void writeVarint(uint64_t value);
+      void writeString(const std::string &string);
+      // writes the string as reference into the string table, if interning is enabled
+      void writeName(const std::string &name);
+      uint64_t internString(const std::string &string);
+      void writeAssertion(const Assertion &assertion);
+    };
+
+    /*!
+     * Decodes the records written by \ref EventEncoder and replays them into an Output
+     */
+    class EventDecoder {
+    public:
+      using ResultCallback = std::function<void(bool, std::chrono::microseconds)>;
+
+      explicit EventDecoder(Output &output, ResultCallback callback = nullptr);
+
+      /*!
+       * Adds the given data and replays all records which are complete.
+       *
+       * Incomplete records are kept until the remaining data is fed. If replaying a record throws an exception, the
+       * record is dropped and the exception is rethrown, the remaining records are replayed with the next call.
+       */
+      void feed(const char *data, std::size_t size);
+
+      /*!
+       * Returns whether there is data of an incomplete record left
+       */
+      bool hasPendingData() const noexcept { return !pending.empty(); }
+
+    private:
+      Output &out;
+      ResultCallback resultCallback;
+      std::string pending;
+      std::vector<std::string> stringTable;
+
+      void replay(const char *data, std::size_t size);
+    };
+
+    /*!
+     * Appends the given value as varint (7 bits per byte, least significant first) to the given string
+     */
+    void appendVarint(std::string &out, uint64_t value);
+
+    /*!
+     * Reads a varint from the given position, returns whether a complete varint could be read
+     */
+    bool readVarint(const char *&data, const char *end, uint64_t &value);
+
+    /*!
+     * Appends the IEEE 754 representation of the given value (8 bytes, least significant first) to the given string
+     */
+    void appendDouble(std::string &out, double value);
+
+    /*!
+     * Reads a value written by \ref appendDouble from the given position, returns whether enough data was available
+     */
+    bool readDouble(const char *&data, const char *end, double &value);
+
+    /*!
+     * Replaces the given file with the given content by writing a temporary file first and renaming it, so concurrent
+     * readers never see an incomplete file. The temporary file is unique per process and call, so concurrent writers
+     * (e.g. the shards of a test run sharing a file) do not overwrite each other's temporary file.
+     *
+     * \param description The kind of file for the error messages
+     * \throws std::runtime_error if the file could not be written or replaced
+     */
+    void replaceFile(const std::string &fileName, const std::string &content, const std::string &description);
+  } // namespace Private
+} // namespace Test
@@ -1,5 +1,7 @@
 #include "HTMLOutput.h"
 
+#include <algorithm>
+
 using namespace Test;
 
 void HTMLOutput::generate(std::ostream &stream, bool includePassed, const std::string &title) {
@@ -9,14 +11,13 @@ void HTMLOutput::generate(std::ostream &stream, bool includePassed, const std::s
   // 2. print table
   generateSuitesTable(stream, includePassed);
   stream << "<br>" << std::endl;
-  auto suiteInfo = suites.begin();
-  while (suiteInfo != suites.end()) {
-    if (includePassed || suiteInfo->numTests != suiteInfo->numPositiveTests) {
-      generateTestsTable(stream, *suiteInfo, includePassed);
+  // streams through the suites a second time, so only a single suite needs to be loaded at any time
+  visitSuites([&](const SuiteInfo &suiteInfo) {
+    if (includePassed || suiteInfo.numTests != suiteInfo.numPositiveTests) {
+      generateTestsTable(stream, suiteInfo, includePassed);
       stream << "<br>" << std::endl;
     }
-    ++suiteInfo;
-  }
+  });
   stream << "</body></html>" << std::endl;
   // flush all data to the stream
   stream.flush();
@@ -64,41 +65,49 @@ void HTMLOutput::generateSuitesTable(std::ostream &stream, bool includePassed) {
       << "<table id='top' class='suites'><tr><th>Suite</th><th># Tests</th><th>Passed Tests</th><th>Duration</th></tr>"
       << std::endl;
   // content
-  auto info = suites.begin();
-  while (info != suites.end()) {
-    if (includePassed || info->numPositiveTests != info->numTests) {
-      stream << "<tr><td><a href='#suite_" << info->suiteName << "'>" << info->suiteName << "</a></td>"
-             << "<td>" << info->numTests << "</td>"
-             << "<td class='" << getCssClass(info->numTests, info->numPositiveTests) << "'>" << info->numPositiveTests
-             << " (" << prettifyPercentage(info->numPositiveTests, info->numTests) << "%)</td>"
-             << "<td>" << static_cast<double>(info->suiteDuration.count()) / 1000.0 << " ms ("
-             << static_cast<double>(info->suiteDuration.count()) / 1000000.0 << " s)</td>"
+  visitSuites([&](const SuiteInfo &info) {
+    if (includePassed || info.numPositiveTests != info.numTests) {
+      stream << "<tr><td><a href='#suite_" << info.suiteName << "'>" << info.suiteName << "</a></td>"
+             << "<td>" << info.numTests << "</td>"
+             << "<td class='" << getCssClass(info.numTests, info.numPositiveTests) << "'>" << info.numPositiveTests
+             << " (" << prettifyPercentage(info.numPositiveTests, info.numTests) << "%)</td>"
+             << "<td>" << static_cast<double>(info.suiteDuration.count()) / 1000.0 << " ms ("
+             << static_cast<double>(info.suiteDuration.count()) / 1000000.0 << " s)</td>"
              << "</tr>" << std::endl;
     }
-    ++info;
-  }
+  });
   stream << "</table>" << std::endl;
 }
 
 void HTMLOutput::generateTestsTable(std::ostream &stream, const SuiteInfo &suite, bool includePassed) {
+  // the benchmark column is only added for suites running benchmarks
+  const bool hasBenchmarks = std::any_of(suite.methods.begin(), suite.methods.end(),
+      [](const TestMethodInfo &method) {
+        return method.results && (!method.results->benchmarks.empty() || !method.results->complexities.empty());
+      });
+  // as is the column of the performance counters for suites run with the counters enabled
+  const bool hasCounters = std::any_of(suite.methods.begin(), suite.methods.end(),
+      [](const TestMethodInfo &method) { return method.results && method.results->availableCounters != 0; });
   stream << "<table id='suite_" << suite.suiteName << "'>"
-         << "<tr><th>Test-method</th><th># Assertions</th><th>Passed Assertions</th><th>Failures</th></tr>"
-         << std::endl;
+         << "<tr><th>Test-method</th><th># Assertions</th><th>Passed Assertions</th><th>Duration</th><th>Failures</th>"
+         << (hasBenchmarks ? "<th>Benchmark</th>" : "") << (hasCounters ? "<th>Performance Counters</th>" : "")
+         << "</tr>" << std::endl;
   // content
   auto testMethod = suite.methods.begin();
   while (testMethod != suite.methods.end()) {
-    std::size_t totalAssertions = testMethod->passedAssertions.size() + testMethod->failedAssertions.size();
-    stream << "<tr><td>" << stripMethodName(testMethod->methodName) << "(" << truncateString(testMethod->argString, 20)
+    const TestMethodInfo &method = *testMethod;
+    const auto numPassed = static_cast<std::size_t>(method.numPassedAssertions);
+    const std::size_t totalAssertions = numPassed + method.failedAssertions.size();
+    stream << "<tr><td>" << stripMethodName(method.methodName) << "(" << truncateString(method.argString, 20)
            << ")</td>"
            << "<td>" << totalAssertions << "</td>"
-           << "<td class='" << getCssClass(totalAssertions, testMethod->passedAssertions.size()) << "'>"
-           << testMethod->passedAssertions.size() << " ("
-           << prettifyPercentage(
-                  static_cast<double>(testMethod->passedAssertions.size()), static_cast<double>(totalAssertions))
+           << "<td class='" << getCssClass(totalAssertions, numPassed) << "'>" << numPassed << " ("
+           << prettifyPercentage(static_cast<double>(numPassed), static_cast<double>(totalAssertions))
            << "%)</td>"
+           << "<td>" << Private::formatDuration(method.duration) << "</td>"
            << "<td>";
-    auto assertion = testMethod->failedAssertions.begin();
-    while (assertion != testMethod->failedAssertions.end()) {
+    auto assertion = method.failedAssertions.begin();
+    while (assertion != method.failedAssertions.end()) {
       stream << "<span class='message'><a href='file://" << assertion->file << "'>" << assertion->file
              << "</a>: " << assertion->lineNumber << ": "
              << truncateString(
@@ -106,8 +115,21 @@ void HTMLOutput::generateTestsTable(std::ostream &stream, const SuiteInfo &suite
              << "</span>";
       ++assertion;
     }
-    stream << "</td>"
-           << "</tr>" << std::endl;
+    stream << "</td>";
+    if (hasBenchmarks) {
+      stream << "<td>";
+      if (method.results) {
+        for (const auto &benchmark : method.results->benchmarks)
+          stream << "<span class='message'>" << Private::formatBenchmark(benchmark) << "</span>";
+        for (const auto &complexity : method.results->complexities)
+          stream << "<span class='message'>" << Private::formatComplexity(complexity) << "</span>";
+      }
+      stream << "</td>";
+    }
+    if (hasCounters)
+      stream << "<td>" << (method.results ? Private::formatPerfCounters(method.results->getPerfCounters()) : "")
+             << "</td>";
+    stream << "</tr>" << std::endl;
     ++testMethod;
   }
   stream << "</table>" << std::endl;
@@ -0,0 +1,215 @@
+#include "NDJSONOutput.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+
+using namespace Test;
+
+void Private::appendJSONString(std::string &out, const char *text, std::size_t length) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  out.push_back('"');
+  const char *end = text + length;
+  const char *runStart = text;
+  for (const char *it = text; it != end; ++it) {
+    const auto c = static_cast<unsigned char>(*it);
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    // copy the characters which need no escaping at once
+    out.append(runStart, static_cast<std::size_t>(it - runStart));
+    runStart = it + 1;
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      out.append("\\u00");
+      out.push_back(HEX_DIGITS[c >> 4]);
+      out.push_back(HEX_DIGITS[c & 0xF]);
+    }
+  }
+  out.append(runStart, static_cast<std::size_t>(end - runStart));
+  out.push_back('"');
+}
+
+NDJSONOutput::NDJSONOutput(std::ostream &stream) : output(stream) {}
+
+NDJSONOutput::NDJSONOutput(const std::string &outputFile)
+    : fileStream(new std::ofstream(outputFile)), output(*fileStream) {}
+
+NDJSONOutput::~NDJSONOutput() noexcept { output.flush(); }
+
+void NDJSONOutput::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  beginEvent("suite_start", suiteName);
+  writeNumber("tests", numTests);
+  writeLine();
+}
+
+void NDJSONOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  beginEvent("suite_finish", suiteName);
+  writeNumber("tests", numTests);
+  writeNumber("passed", numPositiveTests);
+  writeNumber("duration_us", totalDuration.count());
+  writeLine();
+}
+
+void NDJSONOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  beginEvent("test_start", suiteName);
+  writeTest(methodName, argString);
+  writeLine();
+}
+
+void NDJSONOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  beginEvent("test_finish", suiteName);
+  writeTest(methodName, argString);
+  line.append(withSuccess ? ",\"success\":true" : ",\"success\":false");
+  writeNumber("duration_ns", duration.count());
+  writeLine();
+}
+
+void NDJSONOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  beginEvent("exception", suiteName);
+  writeTest(methodName, argString);
+  line.append(",\"message\":");
+  const char *message = ex.what();
+  Private::appendJSONString(line, message, std::strlen(message));
+  writeNumber("duration_ns", duration.count());
+  writeLine();
+}
+
+void NDJSONOutput::printFailure(const Assertion &assertion) {
+  beginEvent("failure", assertion.suite);
+  writeTest(assertion.method, assertion.args);
+  writeString("file", assertion.file);
+  writeNumber("line", assertion.lineNumber);
+  writeString("message", assertion.errorMessage);
+  if (!assertion.userMessage.empty())
+    writeString("user_message", assertion.userMessage);
+  writeLine();
+}
+
+void NDJSONOutput::printBenchmark(const BenchmarkResult &result) {
+  beginEvent("benchmark", result.suite);
+  writeTest(result.method, result.args);
+  writeNumber("iterations", static_cast<int64_t>(result.iterations));
+  writeNumber("repetitions", static_cast<int64_t>(result.repetitions));
+  writeDecimal("min_ns", result.minimum);
+  writeDecimal("median_ns", result.median);
+  writeDecimal("mean_ns", result.mean);
+  writeDecimal("stddev_ns", result.standardDeviation);
+  writeDecimal("p99_ns", result.percentile99);
+  if (result.threads > 1) {
+    writeNumber("threads", result.threads);
+    writeDecimal("ops_per_second", result.getIterationsPerSecond());
+    if (result.scalingEfficiency > 0.0)
+      writeDecimal("scaling_efficiency", result.scalingEfficiency);
+  }
+  if (result.bytesPerIteration != 0) {
+    writeNumber("bytes_per_iteration", static_cast<int64_t>(result.bytesPerIteration));
+    writeDecimal("bytes_per_second", result.getBytesPerSecond());
+  }
+  if (result.itemsPerIteration != 0) {
+    writeNumber("items_per_iteration", static_cast<int64_t>(result.itemsPerIteration));
+    writeDecimal("items_per_second", result.getItemsPerSecond());
+  }
+  writeLine();
+}
+
+void NDJSONOutput::printComplexity(const ComplexityResult &result) {
+  beginEvent("complexity", result.suite);
+  writeTest(result.method, result.args);
+  writeString("complexity", toString(result.complexity));
+  // the coefficients of the faster growing functions are fractions of nanoseconds
+  writeDecimal("coefficient_ns", result.coefficient, 9);
+  writeDecimal("rms", result.rms);
+  if (result.expected != Complexity::NONE)
+    writeString("expected", toString(result.expected));
+  line.append(",\"measurements\":[");
+  for (std::size_t i = 0; i < result.measurements.size(); ++i) {
+    line.append(i == 0 ? "{" : ",{");
+    line.append("\"n\":").append(std::to_string(result.measurements[i].size));
+    writeDecimal("median_ns", result.measurements[i].median);
+    line.push_back('}');
+  }
+  line.push_back(']');
+  writeLine();
+}
+
+void NDJSONOutput::printPerfCounters(const PerfCounterResult &result) {
+  static const std::array<const char *, PerfCounterResult::NUM_COUNTERS> names{{"cycles", "instructions", "branches",
+      "branch_misses", "l1d_reads", "l1d_read_misses", "llc_references", "llc_misses", "context_switches"}};
+  beginEvent("perf_counters", result.suite);
+  writeTest(result.method, result.args);
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (result.has(static_cast<PerfCounter>(i)))
+      writeNumber(names[i], static_cast<int64_t>(result.values[i]));
+  }
+  if (result.has(PerfCounter::INSTRUCTIONS) && result.has(PerfCounter::CYCLES))
+    writeDecimal("ipc", result.getInstructionsPerCycle());
+  if (result.has(PerfCounter::BRANCH_MISSES) && result.has(PerfCounter::BRANCHES))
+    writeDecimal("branch_miss_rate", result.getBranchMissRate(), 6);
+  if (result.has(PerfCounter::L1D_READ_MISSES) && result.has(PerfCounter::L1D_READS))
+    writeDecimal("l1d_miss_rate", result.getL1DMissRate(), 6);
+  if (result.has(PerfCounter::LLC_MISSES) && result.has(PerfCounter::LLC_REFERENCES))
+    writeDecimal("llc_miss_rate", result.getLLCMissRate(), 6);
+  writeLine();
+}
+
+void NDJSONOutput::flush() { output.flush(); }
+
+void NDJSONOutput::beginEvent(const char *event, const std::string &suiteName) {
+  line.assign("{\"event\":\"").append(event).push_back('"');
+  writeString("suite", suiteName);
+}
+
+void NDJSONOutput::writeTest(const std::string &methodName, const std::string &argString) {
+  // same as stripMethodName() without the copy
+  const auto pos = methodName.find_last_of(':');
+  const std::size_t start = pos == std::string::npos ? 0 : pos + 1;
+  line.append(",\"method\":");
+  Private::appendJSONString(line, methodName.data() + start, methodName.size() - start);
+  writeString("args", argString);
+}
+
+void NDJSONOutput::writeString(const char *key, const std::string &value) {
+  line.append(",\"").append(key).append("\":");
+  Private::appendJSONString(line, value.data(), value.size());
+}
+
+void NDJSONOutput::writeNumber(const char *key, int64_t value) {
+  line.append(",\"").append(key).append("\":").append(std::to_string(value));
+}
+
+void NDJSONOutput::writeDecimal(const char *key, double value, int precision) {
+  std::ostringstream ss;
+  // JSON requires a decimal point regardless of the locale
+  ss.imbue(std::locale::classic());
+  ss << std::fixed << std::setprecision(precision) << value;
+  line.append(",\"").append(key).append("\":").append(ss.str());
+}
+
+void NDJSONOutput::writeLine() {
+  line.append("}\n");
+  output.write(line.data(), static_cast<std::streamsize>(line.size()));
+  // flushed per line, so collectors tailing the output see every event immediately
+  output.flush();
+}
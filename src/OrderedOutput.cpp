@@ -0,0 +1,404 @@
+#include "OrderedOutput.h"
+
+#include "EventStream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace Test;
+
+static std::string toKey(const std::string &suiteName, const std::string &fullName) {
+  return suiteName + '\n' + fullName;
+}
+
+// writes and removes the buffered events
+static void replay(Private::EventEncoder &events, Output &output) {
+  if (events.getBuffer().empty())
+    return;
+  const std::string data = events.getBuffer();
+  events.clear();
+  Private::EventDecoder decoder(output);
+  decoder.feed(data.data(), data.size());
+}
+
+struct OrderedOutput::Group {
+  Group(const std::string &suiteName, const std::string &fullName, OutputEvents consumedEvents)
+      : key(toKey(suiteName, fullName)), events(consumedEvents), spillOffset(0), spillSize(0) {}
+
+  const std::string key;
+  // does not intern any strings, so the events can be replayed on their own
+  Private::EventEncoder events;
+  // the position of the events in the temporary file, if they were moved there
+  long spillOffset;
+  std::size_t spillSize;
+};
+
+/*!
+ * Temporary file the events of the finished test-methods are moved to, removed once closed
+ */
+class OrderedOutput::SpillFile {
+public:
+  SpillFile() : file(std::tmpfile()) {
+    if (file == nullptr)
+      throw std::runtime_error("Failed to create temporary file for buffered test output");
+  }
+  SpillFile(const SpillFile &) = delete;
+  SpillFile(SpillFile &&) noexcept = delete;
+  ~SpillFile() noexcept { std::fclose(file); }
+
+  SpillFile &operator=(const SpillFile &) = delete;
+  SpillFile &operator=(SpillFile &&) noexcept = delete;
+
+  /*!
+   * Appends the data and returns its position
+   */
+  long append(const std::string &data) {
+    if (std::fseek(file, 0, SEEK_END) != 0)
+      throw std::runtime_error("Failed to write buffered test output to temporary file");
+    const long position = std::ftell(file);
+    if (position < 0 || std::fwrite(data.data(), 1, data.size(), file) != data.size())
+      throw std::runtime_error("Failed to write buffered test output to temporary file");
+    return position;
+  }
+
+  std::string read(long position, std::size_t size) {
+    std::string data(size, '\0');
+    if (std::fseek(file, position, SEEK_SET) != 0 || std::fread(&data[0], 1, size, file) != size)
+      throw std::runtime_error("Failed to read buffered test output from temporary file");
+    return data;
+  }
+
+private:
+  std::FILE *file;
+};
+
+struct OrderedOutput::SuiteState {
+  explicit SuiteState(OutputEvents consumedEvents)
+      : expectedRuns(0), finishedRuns(0), finished(false), done(false), head(consumedEvents), tail(consumedEvents) {}
+
+  // the number of instances of the suite with the same name, e.g. added multiple times to a parallel suite
+  unsigned expectedRuns;
+  unsigned finishedRuns;
+  bool finished;
+  // whether all events are written, further events are written immediately
+  bool done;
+  // the events before and between the test-methods, e.g. the start of the suite
+  Private::EventEncoder head;
+  // the events after the suite finished
+  Private::EventEncoder tail;
+};
+
+OrderedOutput::OrderedOutput(Output &backingOutput, Order outputOrder, std::size_t memoryBudget)
+    : realOutput(backingOutput), realEvents(backingOutput.getConsumedEvents()), order(outputOrder),
+      memoryLimit(memoryBudget), nextEntry(0), currentSuite(nullptr), bufferedSize(0) {}
+
+OrderedOutput::~OrderedOutput() noexcept {
+  try {
+    std::lock_guard<std::mutex> guard(outputMutex);
+    writeAll();
+    realOutput.flush();
+  } catch (...) {
+    // nobody to report the error to
+  }
+}
+
+void OrderedOutput::expectSuite(const Suite &suite, const std::vector<TestMethodInfo> &selectedMethods) {
+  if (order != Order::CANONICAL)
+    return;
+  std::unordered_set<std::uintptr_t> selectedReferences;
+  for (const auto &method : selectedMethods)
+    selectedReferences.insert(method.reference);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  writeAll();
+  entries.clear();
+  openPositions.clear();
+  suites.clear();
+  nextEntry = 0;
+  currentSuite = nullptr;
+  addExpectedSuite(suite, selectedReferences);
+}
+
+void OrderedOutput::addExpectedSuite(const Suite &suite, const std::unordered_set<std::uintptr_t> &selectedMethods) {
+  // same order as Suite::run
+  auto &state = suites[suite.suiteName];
+  if (!state)
+    state.reset(new SuiteState(realEvents));
+  ++state->expectedRuns;
+  entries.emplace_back(Entry{suite.suiteName, nullptr, true});
+  for (const auto &method : suite.testMethods) {
+    if (selectedMethods.find(reinterpret_cast<std::uintptr_t>(&method)) == selectedMethods.end())
+      continue;
+    openPositions[toKey(suite.suiteName, method.fullName())].push_back(entries.size());
+    entries.emplace_back(Entry{suite.suiteName, nullptr, false});
+  }
+  for (const auto &subSuite : suite.subSuites)
+    addExpectedSuite(*subSuite, selectedMethods);
+}
+
+void OrderedOutput::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  reportSuiteEvent(suiteName, false, OutputEvents::INITIALIZE_SUITE,
+      [&](Output &out) { out.initializeSuite(suiteName, numTests); });
+}
+
+void OrderedOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  reportSuiteEvent(suiteName, true, OutputEvents::FINISH_SUITE,
+      [&](Output &out) { out.finishSuite(suiteName, numTests, numPositiveTests, totalDuration); });
+}
+
+void OrderedOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  const TestId test = internTest(suiteName, methodName, argString);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  auto &group = runningTests[std::make_pair(std::this_thread::get_id(), test)];
+  group.reset(new Group(suiteName, methodName + '(' + argString + ')', realEvents));
+  if (hasAny(realEvents, OutputEvents::INITIALIZE_TEST_METHOD))
+    group->events.initializeTestMethod(suiteName, methodName, argString);
+}
+
+void OrderedOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  const TestId test = internTest(suiteName, methodName, argString);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  auto it = runningTests.find(std::make_pair(std::this_thread::get_id(), test));
+  if (it == runningTests.end()) {
+    // not started via this output
+    if (hasAny(realEvents, OutputEvents::FINISH_TEST_METHOD))
+      realOutput.finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+    return;
+  }
+  std::unique_ptr<Group> group = std::move(it->second);
+  runningTests.erase(it);
+  if (hasAny(realEvents, OutputEvents::FINISH_TEST_METHOD))
+    group->events.finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+  finishGroup(std::move(group));
+}
+
+void OrderedOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  const TestId test = internTest(suiteName, methodName, argString);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printException(suiteName, methodName, argString, ex, duration);
+  else
+    reportSuiteEvent(suiteName, false, OutputEvents::EXCEPTION,
+        [&](Output &out) { out.printException(suiteName, methodName, argString, ex, duration); });
+}
+
+OutputEvents OrderedOutput::getConsumedEvents() const {
+  // the start and end of every test-method delimit the buffered events, the end of a suite the announced test-methods
+  return realEvents | OutputEvents::INITIALIZE_TEST_METHOD | OutputEvents::FINISH_TEST_METHOD |
+         OutputEvents::FINISH_SUITE;
+}
+
+void OrderedOutput::printSuccess(const Assertion &assertion) {
+  const TestId test = internTest(assertion.suite, assertion.method, assertion.args);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printSuccess(assertion);
+  else
+    reportSuiteEvent(
+        assertion.suite, false, OutputEvents::SUCCESS, [&](Output &out) { out.printSuccess(assertion); });
+}
+
+void OrderedOutput::printSuccessEvent(const AssertionEvent &event) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(event.test))
+    group->events.printSuccessEvent(event);
+  else
+    reportSuiteEvent(getTestName(event.test).suite, false, OutputEvents::SUCCESS,
+        [&](Output &out) { out.printSuccessEvent(event); });
+}
+
+void OrderedOutput::printFailure(const Assertion &assertion) {
+  const TestId test = internTest(assertion.suite, assertion.method, assertion.args);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printFailure(assertion);
+  else
+    reportSuiteEvent(
+        assertion.suite, false, OutputEvents::FAILURE, [&](Output &out) { out.printFailure(assertion); });
+}
+
+void OrderedOutput::printBenchmark(const BenchmarkResult &result) {
+  const TestId test = internTest(result.suite, result.method, result.args);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printBenchmark(result);
+  else
+    reportSuiteEvent(
+        result.suite, false, OutputEvents::BENCHMARK, [&](Output &out) { out.printBenchmark(result); });
+}
+
+void OrderedOutput::printComplexity(const ComplexityResult &result) {
+  const TestId test = internTest(result.suite, result.method, result.args);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printComplexity(result);
+  else
+    reportSuiteEvent(
+        result.suite, false, OutputEvents::COMPLEXITY, [&](Output &out) { out.printComplexity(result); });
+}
+
+void OrderedOutput::printPerfCounters(const PerfCounterResult &result) {
+  const TestId test = internTest(result.suite, result.method, result.args);
+  std::lock_guard<std::mutex> guard(outputMutex);
+  if (Group *group = findGroup(test))
+    group->events.printPerfCounters(result);
+  else
+    reportSuiteEvent(
+        result.suite, false, OutputEvents::PERF_COUNTERS, [&](Output &out) { out.printPerfCounters(result); });
+}
+
+void OrderedOutput::flush() {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  writeAll();
+  for (auto &running : runningTests)
+    replay(running.second->events, realOutput);
+  realOutput.flush();
+}
+
+OrderedOutput::Group *OrderedOutput::findGroup(TestId test) {
+  auto it = runningTests.find(std::make_pair(std::this_thread::get_id(), test));
+  if (it != runningTests.end())
+    return it->second.get();
+  // reported from another thread, e.g. by the watchdog aborting the test-method
+  for (auto &running : runningTests) {
+    if (running.first.second == test)
+      return running.second.get();
+  }
+  return nullptr;
+}
+
+void OrderedOutput::finishGroup(std::unique_ptr<Group> &&group) {
+  auto it = openPositions.find(group->key);
+  if (it == openPositions.end() || it->second.empty()) {
+    // grouped order or not announced
+    replay(group->events, realOutput);
+    return;
+  }
+  const std::size_t position = it->second.front();
+  it->second.erase(it->second.begin());
+  entries[position].result = std::move(group);
+  bufferedSize += entries[position].result->events.getBuffer().size();
+  writeReadyEntries();
+  if (memoryLimit != 0 && bufferedSize > memoryLimit)
+    spillFinishedEntries();
+}
+
+void OrderedOutput::reportSuiteEvent(const std::string &suiteName, bool isFinish, OutputEvents event,
+    const std::function<void(Output &)> &report) {
+  auto it = suites.find(suiteName);
+  if (it == suites.end() || it->second->done) {
+    if (hasAny(realEvents, event))
+      report(realOutput);
+    return;
+  }
+  SuiteState &suite = *it->second;
+  if (hasAny(realEvents, event))
+    report(suite.finished || isFinish ? suite.tail : suite.head);
+  if (isFinish && !suite.finished && ++suite.finishedRuns >= suite.expectedRuns) {
+    suite.finished = true;
+    // all test-methods of the suite are finished, the remaining ones are not run at all
+    for (std::size_t i = nextEntry; i < entries.size(); ++i) {
+      if (entries[i].suiteName == suiteName && !entries[i].result)
+        entries[i].skipped = true;
+    }
+    for (auto &positions : openPositions) {
+      positions.second.erase(std::remove_if(positions.second.begin(), positions.second.end(),
+                                 [this](std::size_t position) { return entries[position].skipped; }),
+          positions.second.end());
+    }
+  }
+  writeReadyEntries();
+}
+
+void OrderedOutput::writeReadyEntries() {
+  while (true) {
+    if (nextEntry < entries.size() && currentSuite != suites[entries[nextEntry].suiteName].get()) {
+      // the previous suite needs to be completely written before starting the next one
+      if (currentSuite && !leaveCurrentSuite())
+        return;
+      currentSuite = suites[entries[nextEntry].suiteName].get();
+    }
+    if (nextEntry == entries.size()) {
+      if (currentSuite && leaveCurrentSuite())
+        currentSuite = nullptr;
+      return;
+    }
+    replay(currentSuite->head, realOutput);
+    Entry &entry = entries[nextEntry];
+    if (!entry.result && !entry.skipped)
+      // wait for the next test-method to finish
+      return;
+    writeEntry(entry);
+    ++nextEntry;
+  }
+}
+
+bool OrderedOutput::leaveCurrentSuite() {
+  if (!currentSuite->finished && !currentSuite->done)
+    return false;
+  replay(currentSuite->head, realOutput);
+  replay(currentSuite->tail, realOutput);
+  currentSuite->done = true;
+  return true;
+}
+
+void OrderedOutput::writeAll() {
+  // write the events in the announced order, regardless of whether the suites and test-methods finished
+  for (; nextEntry < entries.size(); ++nextEntry) {
+    SuiteState *suite = suites[entries[nextEntry].suiteName].get();
+    if (suite != currentSuite) {
+      if (currentSuite) {
+        currentSuite->finished = true;
+        leaveCurrentSuite();
+      }
+      currentSuite = suite;
+    }
+    replay(currentSuite->head, realOutput);
+    writeEntry(entries[nextEntry]);
+  }
+  for (auto &suite : suites) {
+    if (!suite.second->done) {
+      currentSuite = suite.second.get();
+      currentSuite->finished = true;
+      leaveCurrentSuite();
+    }
+  }
+  currentSuite = nullptr;
+  // test-methods finishing afterwards are written immediately
+  openPositions.clear();
+  spillFile.reset();
+}
+
+void OrderedOutput::writeEntry(Entry &entry) {
+  if (!entry.result)
+    return;
+  std::unique_ptr<Group> group = std::move(entry.result);
+  if (group->spillSize != 0) {
+    const std::string data = spillFile->read(group->spillOffset, group->spillSize);
+    Private::EventDecoder decoder(realOutput);
+    decoder.feed(data.data(), data.size());
+  } else {
+    bufferedSize -= group->events.getBuffer().size();
+    replay(group->events, realOutput);
+  }
+}
+
+void OrderedOutput::spillFinishedEntries() {
+  if (!spillFile)
+    spillFile.reset(new SpillFile());
+  for (std::size_t i = nextEntry; i < entries.size(); ++i) {
+    Group *group = entries[i].result.get();
+    if (!group || group->events.getBuffer().empty())
+      continue;
+    group->spillOffset = spillFile->append(group->events.getBuffer());
+    group->spillSize = group->events.getBuffer().size();
+    bufferedSize -= group->spillSize;
+    group->events.clear();
+  }
+}
@@ -1,5 +1,16 @@
 #include "Output.h"
 
+#include <array>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 using namespace Test;
 std::string Private::getFileName(const std::string &file) {
   std::string fileName = file;
@@ -30,6 +41,56 @@ Assertion::Assertion(const char *fileName, uint32_t lineNum, const char *userMsg
 Assertion::Assertion(const char *fileName, uint32_t lineNum)
     : suite(""), file(fileName), method(""), args(""), errorMessage(""), userMessage(""), lineNumber(lineNum) {}
 
+namespace {
+  struct TestNameRegistry {
+    std::mutex registryMutex;
+    // std::deque never moves its elements, so references to the names stay valid
+    std::deque<TestName> names;
+    std::unordered_map<std::string, TestId> ids;
+  };
+} // namespace
+
+static TestNameRegistry &getRegistry() {
+  static TestNameRegistry registry;
+#ifndef _WIN32
+  // a worker process forked (see ProcessPool) while another thread interns a test would inherit the locked registry
+  static const int forkHandlers = pthread_atfork([]() { getRegistry().registryMutex.lock(); },
+      []() { getRegistry().registryMutex.unlock(); }, []() { getRegistry().registryMutex.unlock(); });
+  static_cast<void>(forkHandlers);
+#endif
+  return registry;
+}
+
+TestId Test::internTest(const std::string &suite, const std::string &method, const std::string &args) {
+  std::string key;
+  key.reserve(suite.size() + method.size() + args.size() + 2);
+  key.append(suite).append(1, '\0').append(method).append(1, '\0').append(args);
+  TestNameRegistry &registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.registryMutex);
+  auto it = registry.ids.find(key);
+  if (it != registry.ids.end())
+    return it->second;
+  auto id = static_cast<TestId>(registry.names.size());
+  registry.names.emplace_back(TestName{suite, method, args});
+  registry.ids.emplace(std::move(key), id);
+  return id;
+}
+
+const TestName &Test::getTestName(TestId id) {
+  TestNameRegistry &registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.registryMutex);
+  return registry.names.at(id);
+}
+
+Assertion AssertionEvent::toAssertion() const {
+  Assertion assertion(file, lineNumber);
+  const TestName &name = getTestName(test);
+  assertion.suite = name.suite;
+  assertion.method = name.method;
+  assertion.args = name.args;
+  return assertion;
+}
+
 double Output::prettifyPercentage(const double part, const double whole) const {
   if (part == 0 || whole == 0) {
     return 0;
@@ -54,3 +115,138 @@ std::string Output::truncateString(const std::string &string, unsigned int lengt
   }
   return string.substr(0, length - 3) + "...";
 }
+
+std::string Private::formatDuration(std::chrono::nanoseconds duration) {
+  static const std::array<const char *, 4> units{{"ns", "us", "ms", "s"}};
+  std::ostringstream ss;
+  if (duration.count() < 1000) {
+    ss << duration.count() << ' ' << units[0];
+    return ss.str();
+  }
+  auto value = static_cast<double>(duration.count());
+  std::size_t unit = 0;
+  while (unit + 1 < units.size() && value >= 1000.0) {
+    value /= 1000.0;
+    ++unit;
+  }
+  ss << std::fixed << std::setprecision(3) << value << ' ' << units[unit];
+  return ss.str();
+}
+
+// same units as formatDuration, but keeps the fraction of nanoseconds of very short iterations
+static std::string formatNanoseconds(double nanoseconds) {
+  static const std::array<const char *, 4> units{{"ns", "us", "ms", "s"}};
+  std::size_t unit = 0;
+  while (unit + 1 < units.size() && nanoseconds >= 1000.0) {
+    nanoseconds /= 1000.0;
+    ++unit;
+  }
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(3) << nanoseconds << ' ' << units[unit];
+  return ss.str();
+}
+
+// e.g. "1.234 GB" or with a separator between prefix and unit "1.234 M items"
+static std::string formatCount(double count, const char *unit, const char *separator) {
+  static const std::array<const char *, 5> prefixes{{"", "k", "M", "G", "T"}};
+  std::size_t prefix = 0;
+  while (prefix + 1 < prefixes.size() && count >= 1000.0) {
+    count /= 1000.0;
+    ++prefix;
+  }
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(3) << count << ' ' << prefixes[prefix] << (prefix != 0 ? separator : "")
+     << unit;
+  return ss.str();
+}
+
+// e.g. "1.234 GB/s" or with a separator between prefix and unit "1.234 M items/s"
+static std::string formatRate(double perSecond, const char *unit, const char *separator) {
+  return formatCount(perSecond, unit, separator) + "/s";
+}
+
+std::string Private::formatBenchmark(const BenchmarkResult &result) {
+  std::string text = formatNanoseconds(result.mean) + "/iteration (min " + formatNanoseconds(result.minimum) +
+                     ", median " + formatNanoseconds(result.median) + ", stddev " +
+                     formatNanoseconds(result.standardDeviation) + ", p99 " + formatNanoseconds(result.percentile99) +
+                     ", " + std::to_string(result.repetitions) + " x " + std::to_string(result.iterations) +
+                     " iterations)";
+  if (result.threads > 1) {
+    text.append(", ").append(std::to_string(result.threads)).append(" threads, ");
+    text.append(formatRate(result.getIterationsPerSecond(), "ops", " "));
+    if (result.scalingEfficiency > 0.0) {
+      std::ostringstream ss;
+      ss << std::fixed << std::setprecision(1) << result.scalingEfficiency * 100.0 << "% scaling efficiency";
+      text.append(", ").append(ss.str());
+    }
+  }
+  if (result.bytesPerIteration != 0)
+    text.append(", ").append(formatRate(result.getBytesPerSecond(), "B", ""));
+  if (result.itemsPerIteration != 0)
+    text.append(", ").append(formatRate(result.getItemsPerSecond(), "items", " "));
+  return text;
+}
+
+const char *Test::toString(Complexity complexity) noexcept {
+  switch (complexity) {
+  case Complexity::CONSTANT:
+    return "O(1)";
+  case Complexity::LOGARITHMIC:
+    return "O(log n)";
+  case Complexity::LINEAR:
+    return "O(n)";
+  case Complexity::LINEARITHMIC:
+    return "O(n log n)";
+  case Complexity::QUADRATIC:
+    return "O(n^2)";
+  case Complexity::NONE:
+    break;
+  }
+  return "O(?)";
+}
+
+std::string Private::formatComplexity(const ComplexityResult &result) {
+  static const std::array<const char *, 6> functions{{"", "", " * log n", " * n", " * n log n", " * n^2"}};
+  std::ostringstream ss;
+  // the coefficients of the faster growing functions are fractions of nanoseconds
+  ss << toString(result.complexity) << ", " << std::setprecision(4) << result.coefficient << " ns"
+     << functions[static_cast<std::size_t>(result.complexity) % functions.size()] << " (rms " << std::fixed
+     << std::setprecision(1) << result.rms * 100.0 << "%, " << result.measurements.size() << " input sizes";
+  if (result.expected != Complexity::NONE)
+    ss << ", expected " << toString(result.expected);
+  ss << ')';
+  return ss.str();
+}
+
+std::string Private::formatComplexityTable(const ComplexityResult &result, const std::string &linePrefix) {
+  std::ostringstream ss;
+  ss << linePrefix << std::setw(12) << "n" << std::setw(20) << "time/iteration" << '\n';
+  for (const auto &measurement : result.measurements)
+    ss << linePrefix << std::setw(12) << measurement.size << std::setw(20) << formatNanoseconds(measurement.median)
+       << '\n';
+  return ss.str();
+}
+
+std::string Private::formatPerfCounters(const PerfCounterResult &result) {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  const char *separator = "";
+  if (result.has(PerfCounter::INSTRUCTIONS) && result.has(PerfCounter::CYCLES)) {
+    ss << "IPC " << result.getInstructionsPerCycle() << " ("
+       << formatCount(static_cast<double>(result.get(PerfCounter::INSTRUCTIONS)), "instructions", " ") << ')';
+    separator = ", ";
+  }
+  const auto writeRate = [&](PerfCounter misses, PerfCounter total, double rate, const char *name) {
+    if (result.has(misses) && result.has(total)) {
+      ss << separator << rate * 100.0 << "% " << name << " misses";
+      separator = ", ";
+    }
+  };
+  writeRate(PerfCounter::BRANCH_MISSES, PerfCounter::BRANCHES, result.getBranchMissRate(), "branch");
+  writeRate(PerfCounter::L1D_READ_MISSES, PerfCounter::L1D_READS, result.getL1DMissRate(), "L1D");
+  writeRate(PerfCounter::LLC_MISSES, PerfCounter::LLC_REFERENCES, result.getLLCMissRate(), "LLC");
+  if (result.has(PerfCounter::CONTEXT_SWITCHES))
+    ss << separator << result.get(PerfCounter::CONTEXT_SWITCHES)
+       << (result.get(PerfCounter::CONTEXT_SWITCHES) == 1 ? " context switch" : " context switches");
+  return ss.str();
+}
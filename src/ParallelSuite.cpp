@@ -1,40 +1,98 @@
 #include "ParallelSuite.h"
 
+#include "TimingHistory.h"
+#include "TimingReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <unordered_set>
+
 using namespace Test;
 
 ParallelSuite::ParallelSuite(const std::string &name) : Suite(name) {}
-ParallelSuite::~ParallelSuite() { delete output; }
+ParallelSuite::~ParallelSuite() = default;
 
 bool ParallelSuite::run(Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError) {
   this->continueAfterFail = continueOnError;
-  this->output = new SynchronizedOutput(out);
-  out.initializeSuite(suiteName, static_cast<unsigned>(testMethods.size()));
-  if (setup()) {
-    // warn if test-methods are directly added
-    if (!testMethods.empty()) {
-      Assertion notEmptyAssterion(
-          suiteName.c_str(), 0, "Any test-methods directly added to a parallel-suite are not executed!");
-      out.printFailure(notEmptyAssterion);
-    }
-    // run tear-down after all tests
-    tear_down();
-  }
-  out.finishSuite(suiteName, static_cast<unsigned>(testMethods.size()), 0, std::chrono::microseconds::zero());
+  // thread-safe outputs can be used by all sub-suites directly
+  this->synchronizedOutput.reset(out.isThreadSafe() ? nullptr : new SynchronizedOutput(out));
+  setOutput(synchronizedOutput ? *synchronizedOutput : out);
+  const bool success = runOwnTestMethods(out);
 
-  std::vector<std::future<bool>> results(subSuites.size());
-  // run sub-suites
-  for (unsigned int i = 0; i < subSuites.size(); i++) {
-    results[i] = std::async(std::launch::async, &ParallelSuite::runSuite, this, i, selectedMethods);
+  // run sub-suites, nested parallel suites are scheduled on the same pool
+  WorkerPool &pool = WorkerPool::getDefault();
+  WorkerPool::TaskGroup group;
+  std::atomic<std::chrono::nanoseconds::rep> busyCount{0};
+  const auto startTime = std::chrono::steady_clock::now();
+  for (unsigned int i : orderLongestFirst(selectedMethods)) {
+    pool.submit(group, [this, i, &selectedMethods, &busyCount]() {
+      const auto suiteStart = std::chrono::steady_clock::now();
+      runSuite(i, selectedMethods);
+      busyCount += (std::chrono::steady_clock::now() - suiteStart).count();
+    });
   }
 
   // join sub-suites
-  for (std::future<bool> &result : results) {
-    result.get();
+  pool.wait(group);
+  if (TimingReport *report = TimingReport::getActive()) {
+    const auto numWorkers = std::min<std::size_t>(pool.getNumWorkers(), subSuites.size());
+    report->recordParallelRun(suiteName, std::chrono::nanoseconds{busyCount.load()},
+        std::chrono::steady_clock::now() - startTime, static_cast<unsigned>(numWorkers));
   }
 
-  return true;
+  return success;
+}
+
+bool ParallelSuite::runOwnTestMethods(Output &out) {
+  if (hasAny(consumedEvents, OutputEvents::INITIALIZE_SUITE))
+    out.initializeSuite(suiteName, static_cast<unsigned>(testMethods.size()));
+  bool success = true;
+  if (runSetup()) {
+    // warn if test-methods are directly added
+    if (!testMethods.empty()) {
+      if (hasAny(consumedEvents, OutputEvents::FAILURE)) {
+        Assertion notEmptyAssterion(
+            suiteName.c_str(), 0, "Any test-methods directly added to a parallel-suite are not executed!");
+        out.printFailure(notEmptyAssterion);
+      }
+      success = false;
+    }
+    // run tear-down after all tests
+    runTearDown();
+  }
+  if (hasAny(consumedEvents, OutputEvents::FINISH_SUITE))
+    out.finishSuite(suiteName, static_cast<unsigned>(testMethods.size()), 0, std::chrono::microseconds::zero());
+  return success;
 }
 
 bool ParallelSuite::runSuite(unsigned int suiteIndex, const std::vector<TestMethodInfo> &selectedMethods) {
   return subSuites[suiteIndex]->run(*output, selectedMethods, continueAfterFail);
 }
+
+std::vector<unsigned int> ParallelSuite::orderLongestFirst(const std::vector<TestMethodInfo> &selectedMethods) const {
+  std::vector<unsigned int> order(subSuites.size());
+  std::iota(order.begin(), order.end(), 0U);
+  const TimingHistory *history = TimingHistory::getActive();
+  if (history == nullptr || history->empty())
+    return order;
+  // the expected duration of a sub-suite is the sum of the expected durations of its selected test-methods
+  std::unordered_set<std::uintptr_t> selectedReferences;
+  for (const auto &info : selectedMethods)
+    selectedReferences.insert(info.reference);
+  std::vector<std::chrono::microseconds> suiteDurations;
+  suiteDurations.reserve(subSuites.size());
+  for (const auto &suite : subSuites) {
+    std::vector<std::string> testNames;
+    for (const auto &test : suite->listTests()) {
+      if (selectedReferences.find(test.reference) != selectedReferences.end())
+        testNames.emplace_back(TimingHistory::getTestKey(test.suiteName, test.fullName));
+    }
+    auto estimates = history->estimateDurations(testNames);
+    suiteDurations.emplace_back(std::accumulate(estimates.begin(), estimates.end(), std::chrono::microseconds::zero()));
+  }
+  // submitted tasks are started in order, so the slowest sub-suites are started first
+  std::stable_sort(order.begin(), order.end(),
+      [&suiteDurations](unsigned int one, unsigned int other) { return suiteDurations[one] > suiteDurations[other]; });
+  return order;
+}
@@ -0,0 +1,163 @@
+#include "PerfCounters.h"
+
+#include <atomic>
+#include <memory>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace Test;
+
+static std::atomic<bool> countersEnabled{false};
+
+bool PerfCounters::isEnabled() noexcept { return countersEnabled; }
+
+void PerfCounters::setEnabled(bool enabled) noexcept { countersEnabled = enabled; }
+
+#ifdef __linux__
+namespace {
+  struct CounterConfig {
+    PerfCounter counter;
+    uint32_t type;
+    uint64_t config;
+  };
+
+  struct GroupConfig {
+    // whether the counters are still meaningful when only counting in user-space
+    bool allowUserOnly;
+    std::vector<CounterConfig> counters;
+  };
+} // namespace
+
+static uint64_t getCacheConfig(uint64_t cache, uint64_t result) {
+  return cache | (static_cast<uint64_t>(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (result << 16);
+}
+
+// the first counter of every group is its leader
+static const std::vector<GroupConfig> GROUPS{
+    {true,
+        {{PerfCounter::CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PerfCounter::INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PerfCounter::BRANCHES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+            {PerfCounter::BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}}},
+    {true,
+        {{PerfCounter::L1D_READS, PERF_TYPE_HW_CACHE,
+             getCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+            {PerfCounter::L1D_READ_MISSES, PERF_TYPE_HW_CACHE,
+                getCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS)}}},
+    {true,
+        {{PerfCounter::LLC_REFERENCES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+            {PerfCounter::LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}}},
+    // context switches happen in the kernel, so they are never counted in user-space only
+    {false, {{PerfCounter::CONTEXT_SWITCHES, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}}},
+};
+
+static int openCounter(const CounterConfig &config, int groupLeader, bool userOnly) {
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = config.type;
+  attributes.config = config.config;
+  // the group is started and stopped as a whole via its leader
+  attributes.disabled = groupLeader == -1 ? 1 : 0;
+  attributes.exclude_kernel = userOnly ? 1 : 0;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // the calling thread on any CPU
+  return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupLeader, PERF_FLAG_FD_CLOEXEC));
+}
+
+PerfCounters::PerfCounters() : groups({}), available(0) {
+  for (const auto &groupConfig : GROUPS) {
+    Group group{-1, {}, {}};
+    bool userOnly = false;
+    for (const auto &config : groupConfig.counters) {
+      int descriptor = openCounter(config, group.leader, userOnly);
+      if (descriptor < 0 && group.leader == -1 && (errno == EACCES || errno == EPERM) && groupConfig.allowUserOnly) {
+        // perf_event_paranoid only allows to count in user-space
+        userOnly = true;
+        descriptor = openCounter(config, group.leader, userOnly);
+      }
+      if (descriptor < 0) {
+        if (group.leader == -1)
+          // without the leader, the whole group is not available
+          break;
+        continue;
+      }
+      if (group.leader == -1)
+        group.leader = descriptor;
+      group.descriptors.push_back(descriptor);
+      group.counters.push_back(config.counter);
+      available |= 1u << static_cast<unsigned>(config.counter);
+    }
+    if (group.leader != -1)
+      groups.push_back(std::move(group));
+  }
+}
+
+PerfCounters::~PerfCounters() noexcept {
+  for (const auto &group : groups) {
+    for (int descriptor : group.descriptors)
+      close(descriptor);
+  }
+}
+
+void PerfCounters::start() noexcept {
+  for (const auto &group : groups) {
+    ioctl(group.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+void PerfCounters::stop(PerfCounterResult &result) noexcept {
+  for (const auto &group : groups)
+    ioctl(group.leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  for (const auto &group : groups) {
+    // the number of counters, the time enabled and running followed by the value of every counter
+    std::vector<uint64_t> values(3 + group.counters.size());
+    const auto size = static_cast<ssize_t>(values.size() * sizeof(uint64_t));
+    if (read(group.leader, values.data(), values.size() * sizeof(uint64_t)) != size ||
+        values[0] != group.counters.size() || values[2] == 0)
+      // the group was never scheduled onto the hardware counters
+      continue;
+    // the kernel multiplexed the groups, extrapolate to the whole time
+    const double scale = static_cast<double>(values[1]) / static_cast<double>(values[2]);
+    for (std::size_t i = 0; i < group.counters.size(); ++i)
+      result.set(group.counters[i], static_cast<uint64_t>(static_cast<double>(values[3 + i]) * scale + 0.5));
+  }
+}
+
+PerfCounters &PerfCounters::getCurrentThread() {
+  static thread_local std::unique_ptr<PerfCounters> counters;
+  static thread_local pid_t owner = 0;
+  // the counters inherited by a forked process still count the thread of the parent process
+  if (!counters || owner != getpid()) {
+    counters.reset(new PerfCounters());
+    owner = getpid();
+  }
+  return *counters;
+}
+
+bool PerfCounters::isSupported() noexcept { return true; }
+#else
+PerfCounters::PerfCounters() : groups({}), available(0) {}
+
+PerfCounters::~PerfCounters() noexcept = default;
+
+void PerfCounters::start() noexcept {}
+
+void PerfCounters::stop(PerfCounterResult &result) noexcept { (void)result; }
+
+PerfCounters &PerfCounters::getCurrentThread() {
+  static thread_local PerfCounters counters;
+  return counters;
+}
+
+bool PerfCounters::isSupported() noexcept { return false; }
+#endif
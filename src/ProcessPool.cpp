@@ -0,0 +1,472 @@
+#include "ProcessPool.h"
+
+#include "EventStream.h"
+#include "ParallelSuite.h"
+#include "TimingHistory.h"
+#include "TimingReport.h"
+#include "Watchdog.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Test;
+
+ProcessPool::ProcessPool(unsigned workers, const Limits &workerLimits)
+    : numWorkers(workers == 0 ? WorkerPool::getDefaultConcurrency() : workers), limits(workerLimits) {}
+
+bool ProcessPool::run(
+    Suite &suite, Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError) {
+  if (!isSupported())
+    return suite.run(out, selectedMethods, continueOnError);
+  return runSuite(suite, out, selectedMethods, continueOnError);
+}
+
+bool ProcessPool::runSuite(
+    Suite &suite, Output &out, const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError) {
+  if (auto parallelSuite = dynamic_cast<ParallelSuite *>(&suite)) {
+    std::vector<Suite *> subSuites;
+    bool success = collectParallelSuites(*parallelSuite, out, continueOnError, subSuites);
+    return runSuites(parallelSuite->suiteName, subSuites, out, selectedMethods, continueOnError) && success;
+  }
+  bool success = runSuites(suite.suiteName, {&suite}, out, selectedMethods, continueOnError);
+  for (auto &subSuite : suite.subSuites)
+    success = runSuite(*subSuite, out, selectedMethods, continueOnError) && success;
+  return success;
+}
+
+bool ProcessPool::collectParallelSuites(
+    Suite &suite, Output &out, bool continueOnError, std::vector<Suite *> &suites) {
+  bool success = true;
+  if (auto parallelSuite = dynamic_cast<ParallelSuite *>(&suite)) {
+    parallelSuite->continueAfterFail = continueOnError;
+    parallelSuite->setOutput(out);
+    success = parallelSuite->runOwnTestMethods(out);
+  } else {
+    suites.push_back(&suite);
+  }
+  for (auto &subSuite : suite.subSuites)
+    success = collectParallelSuites(*subSuite, out, continueOnError, suites) && success;
+  return success;
+}
+
+bool ProcessPool::runSuites(const std::string &name, const std::vector<Suite *> &suites, Output &out,
+    const std::vector<TestMethodInfo> &selectedMethods, bool continueOnError) {
+  std::vector<SuiteRun> runs;
+  runs.reserve(suites.size());
+  for (Suite *suite : suites) {
+    SuiteRun run{suite, {}, 0, false, std::chrono::steady_clock::now()};
+    for (const auto &method : suite->filterTests(selectedMethods))
+      run.methodIndices.push_back(static_cast<std::size_t>(&method.get() - suite->testMethods.data()));
+
+    suite->continueAfterFail = continueOnError;
+    suite->setOutput(out);
+    if (hasAny(suite->consumedEvents, OutputEvents::INITIALIZE_SUITE))
+      out.initializeSuite(suite->suiteName, static_cast<unsigned>(run.methodIndices.size()));
+    suite->totalDuration = std::chrono::microseconds::zero();
+    suite->positiveTestMethods = 0;
+    suite->passedAssertions = 0;
+    // run setup in the parent process, so the fixtures are shared with all worker processes
+    run.setupSucceeded = suite->runSetup();
+    runs.emplace_back(std::move(run));
+  }
+  runMethods(name, runs, out);
+  return std::all_of(runs.begin(), runs.end(),
+      [](const SuiteRun &run) { return run.suite->positiveTestMethods == run.methodIndices.size(); });
+}
+
+void ProcessPool::finishSuite(SuiteRun &run, Output &out) {
+  Suite &suite = *run.suite;
+  if (run.setupSucceeded)
+    suite.runTearDown();
+  if (TimingReport *report = TimingReport::getActive())
+    report->recordSuite(suite.suiteName, std::chrono::steady_clock::now() - run.startTime);
+  if (hasAny(suite.consumedEvents, OutputEvents::FINISH_SUITE))
+    out.finishSuite(suite.suiteName, static_cast<unsigned>(run.methodIndices.size()), suite.positiveTestMethods,
+        suite.totalDuration);
+}
+
+#ifdef _WIN32
+bool ProcessPool::isSupported() noexcept { return false; }
+
+void ProcessPool::runMethods(const std::string &name, std::vector<SuiteRun> &runs, Output &out) {}
+#else
+bool ProcessPool::isSupported() noexcept { return true; }
+
+static const std::size_t NO_METHOD = static_cast<std::size_t>(-1);
+
+static bool writeAll(int fd, const char *data, std::size_t size) {
+  while (size > 0) {
+    auto written = ::write(fd, data, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+static bool readAll(int fd, char *data, std::size_t size) {
+  while (size > 0) {
+    auto numRead = ::read(fd, data, size);
+    if (numRead < 0 && errno == EINTR)
+      continue;
+    if (numRead <= 0)
+      return false;
+    data += numRead;
+    size -= static_cast<std::size_t>(numRead);
+  }
+  return true;
+}
+
+namespace {
+  /*
+   * Streams every event of the worker process directly to the parent process, so no result is lost on a crash
+   */
+  class PipeEncoder : public Private::EventEncoder {
+  public:
+    PipeEncoder(int fileDescriptor, OutputEvents encodedEvents) : EventEncoder(encodedEvents), fd(fileDescriptor) {}
+
+  protected:
+    void finishRecord() override {
+      if (!writeAll(fd, getBuffer().data(), getBuffer().size()))
+        // the parent process is gone, nobody is interested in our results anymore
+        ::_exit(EXIT_FAILURE);
+      clear();
+    }
+
+  private:
+    int fd;
+  };
+
+  struct Worker {
+    pid_t pid = -1;
+    int requestFd = -1;
+    int resultFd = -1;
+    // position of the running test-method in the list of test-methods to run
+    std::size_t currentMethod = NO_METHOD;
+    std::unique_ptr<Private::EventDecoder> decoder;
+    // the timeout of the running test-method, the watchdog kills the worker process on expiry
+    Watchdog::Handle timeoutHandle = 0;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::milliseconds timeout = std::chrono::milliseconds::zero();
+    std::atomic<bool> timedOut{false};
+  };
+} // namespace
+
+static std::string describeTermination(int status, const ProcessPool::Limits &limits) {
+  if (WIFSIGNALED(status)) {
+    int signal = WTERMSIG(status);
+    std::string message = "Worker process terminated by signal " + std::to_string(signal);
+    const char *name = strsignal(signal);
+    if (name != nullptr)
+      message.append(" (").append(name).append(")");
+    if (signal == SIGXCPU && limits.maxCpuTime.count() > 0)
+      message.append(", exceeded the worker CPU time limit of " + std::to_string(limits.maxCpuTime.count()) + " s");
+    else if (limits.maxMemory > 0 && (signal == SIGKILL || signal == SIGABRT || signal == SIGSEGV))
+      message.append(", the worker memory limit of " + std::to_string(limits.maxMemory / (1024 * 1024)) +
+                     " MiB might have been exceeded");
+    return message;
+  }
+  if (WIFEXITED(status))
+    return "Worker process exited with code " + std::to_string(WEXITSTATUS(status)) + " while running the test-method";
+  return "Worker process terminated unexpectedly";
+}
+
+static void applyLimits(const ProcessPool::Limits &limits) {
+  if (limits.maxMemory > 0) {
+    struct rlimit limit {};
+    limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(limits.maxMemory);
+    setrlimit(RLIMIT_AS, &limit);
+  }
+  if (limits.maxCpuTime.count() > 0) {
+    struct rlimit limit {};
+    limit.rlim_cur = static_cast<rlim_t>(limits.maxCpuTime.count());
+    // send SIGXCPU at the soft limit, the hard limit makes sure the worker is killed if it handles SIGXCPU
+    limit.rlim_max = limit.rlim_cur + 1;
+    setrlimit(RLIMIT_CPU, &limit);
+  }
+}
+
+void ProcessPool::runMethods(const std::string &name, std::vector<SuiteRun> &runs, Output &out) {
+  // the test-methods of all suites to run, as index of the suite run and index of the test-method
+  std::vector<std::pair<std::size_t, std::size_t>> methods;
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    if (!runs[i].setupSucceeded || runs[i].methodIndices.empty()) {
+      finishSuite(runs[i], out);
+      continue;
+    }
+    for (auto index : runs[i].methodIndices)
+      methods.emplace_back(i, index);
+  }
+  if (methods.empty())
+    return;
+  // start the historically slowest test-methods first to not end up waiting for them at the end
+  const TimingHistory *timingHistory = TimingHistory::getActive();
+  if (timingHistory != nullptr && !timingHistory->empty()) {
+    std::vector<std::string> testNames;
+    testNames.reserve(methods.size());
+    for (const auto &method : methods)
+      testNames.emplace_back(runs[method.first].suite->testMethods[method.second].fullName());
+    std::vector<std::pair<std::size_t, std::size_t>> sortedMethods;
+    sortedMethods.reserve(methods.size());
+    for (auto position : timingHistory->orderLongestFirst(testNames))
+      sortedMethods.push_back(methods[position]);
+    methods = std::move(sortedMethods);
+  }
+
+  // writing to the pipe of a crashed worker must not kill us
+  struct sigaction ignorePipe {};
+  struct sigaction previousPipe {};
+  ignorePipe.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &ignorePipe, &previousPipe);
+
+  std::vector<Worker> workers(std::min<std::size_t>(numWorkers, methods.size()));
+  std::size_t nextMethod = 0;
+  const auto startTime = std::chrono::steady_clock::now();
+  // the summed time the workers spent running test-methods, including the communication overhead
+  std::chrono::nanoseconds busyTime = std::chrono::nanoseconds::zero();
+
+  // finishes the suite once all of its test-methods ran
+  auto finishMethod = [&](std::size_t method) {
+    SuiteRun &run = runs[methods[method].first];
+    if (++run.numFinishedMethods == run.methodIndices.size())
+      finishSuite(run, out);
+  };
+
+  auto stopTimeout = [](Worker &worker) {
+    if (worker.timeoutHandle != 0)
+      Watchdog::getDefault().cancel(worker.timeoutHandle);
+    worker.timeoutHandle = 0;
+  };
+
+  auto dispatch = [&](Worker &worker) {
+    stopTimeout(worker);
+    if (worker.timedOut) {
+      // the deadline expired just after the test-method finished, the worker is already killed and replaced on exit
+      worker.currentMethod = NO_METHOD;
+      return;
+    }
+    if (nextMethod < methods.size()) {
+      worker.currentMethod = nextMethod++;
+      const auto &method = methods[worker.currentMethod];
+      const Suite &suite = *runs[method.first].suite;
+      const std::array<uint32_t, 2> request{
+          {static_cast<uint32_t>(method.first), static_cast<uint32_t>(method.second)}};
+      worker.startTime = std::chrono::steady_clock::now();
+      worker.timeout = suite.getTimeout(suite.testMethods[method.second]);
+      if (worker.timeout.count() > 0) {
+        Worker *workerPtr = &worker;
+        pid_t pid = worker.pid;
+        worker.timeoutHandle = Watchdog::getDefault().watch(worker.startTime + worker.timeout, [workerPtr, pid]() {
+          // the process is not reaped before the deadline is cancelled, so the pid cannot be reused yet
+          workerPtr->timedOut = true;
+          ::kill(pid, SIGKILL);
+        });
+      }
+      // if this fails, the worker is gone and we handle that on reading its end-of-file
+      writeAll(worker.requestFd, reinterpret_cast<const char *>(request.data()), sizeof(request));
+    } else {
+      // no more work, let the worker exit
+      worker.currentMethod = NO_METHOD;
+      if (worker.requestFd >= 0)
+        ::close(worker.requestFd);
+      worker.requestFd = -1;
+    }
+  };
+
+  auto spawn = [&](Worker &worker) -> bool {
+    int requestPipe[2];
+    int resultPipe[2];
+    if (::pipe(requestPipe) != 0)
+      return false;
+    if (::pipe(resultPipe) != 0) {
+      ::close(requestPipe[0]);
+      ::close(requestPipe[1]);
+      return false;
+    }
+    // do not duplicate any buffered output into the worker process
+    std::cout.flush();
+    std::cerr.flush();
+    std::clog.flush();
+    std::fflush(nullptr);
+    pid_t pid = ::fork();
+    if (pid < 0) {
+      for (int fd : {requestPipe[0], requestPipe[1], resultPipe[0], resultPipe[1]})
+        ::close(fd);
+      return false;
+    }
+    if (pid == 0) {
+      // worker process
+      ::close(requestPipe[1]);
+      ::close(resultPipe[0]);
+      for (const auto &other : workers) {
+        if (other.requestFd >= 0)
+          ::close(other.requestFd);
+        if (other.resultFd >= 0)
+          ::close(other.resultFd);
+      }
+      sigaction(SIGPIPE, &previousPipe, nullptr);
+      applyLimits(limits);
+      // only the forking thread exists in the worker process, so do not use anything owned by the other threads of the
+      // parent process. The durations are recorded by the parent process.
+      TimingHistory::setActive(nullptr);
+      TimingReport::setActive(nullptr);
+      WorkerPool::abandonDefault();
+      PipeEncoder encoder(resultPipe[1], out.getConsumedEvents());
+      for (auto &run : runs) {
+        // the watchdog thread does not exist in the forked process, the parent process enforces the timeouts
+        run.suite->watchTimeouts = false;
+        run.suite->setOutput(encoder);
+      }
+      std::array<uint32_t, 2> request{};
+      try {
+        while (readAll(requestPipe[0], reinterpret_cast<char *>(request.data()), sizeof(request))) {
+          Suite &suite = *runs.at(request[0]).suite;
+          std::pair<bool, std::chrono::microseconds> result = suite.runTestMethod(suite.testMethods.at(request[1]));
+          std::cout.flush();
+          std::cerr.flush();
+          std::fflush(nullptr);
+          encoder.writeResult(result.first, result.second);
+        }
+      } catch (...) {
+        ::_exit(EXIT_FAILURE);
+      }
+      // skip any static destructors and exit handlers of the parent process
+      ::_exit(EXIT_SUCCESS);
+    }
+    ::close(requestPipe[0]);
+    ::close(resultPipe[1]);
+    worker.pid = pid;
+    worker.timedOut = false;
+    worker.requestFd = requestPipe[1];
+    worker.resultFd = resultPipe[0];
+    worker.currentMethod = NO_METHOD;
+    Worker *workerPtr = &worker;
+    worker.decoder.reset(new Private::EventDecoder(out, [&, workerPtr](bool success, std::chrono::microseconds time) {
+      busyTime += std::chrono::steady_clock::now() - workerPtr->startTime;
+      SuiteRun &run = runs[methods[workerPtr->currentMethod].first];
+      run.suite->totalDuration += time;
+      // the duration recorded by the worker process is lost with the process
+      const auto &method = run.suite->testMethods[methods[workerPtr->currentMethod].second];
+      if (TimingHistory *history = TimingHistory::getActive())
+        history->record(TimingHistory::getTestKey(run.suite->suiteName, method.fullName()), time);
+      if (TimingReport *report = TimingReport::getActive())
+        report->recordTestMethod(TimingHistory::getTestKey(run.suite->suiteName, method.fullName()), time);
+      if (success)
+        ++run.suite->positiveTestMethods;
+      finishMethod(workerPtr->currentMethod);
+      dispatch(*workerPtr);
+    }));
+    return true;
+  };
+
+  auto reportFailure = [&](std::size_t method, const std::string &message, std::chrono::nanoseconds elapsed) {
+    if (out.consumes(OutputEvents::EXCEPTION)) {
+      const Suite &suite = *runs[methods[method].first].suite;
+      const auto &testMethod = suite.testMethods[methods[method].second];
+      out.printException(suite.suiteName, testMethod.name, testMethod.argString, std::runtime_error(message), elapsed);
+    }
+    finishMethod(method);
+  };
+
+  for (auto &worker : workers) {
+    if (!spawn(worker)) {
+      // this method would have been run by this worker
+      reportFailure(nextMethod++, std::string("Failed to create worker process: ") + strerror(errno),
+          std::chrono::nanoseconds::zero());
+      continue;
+    }
+    dispatch(worker);
+  }
+
+  std::vector<struct pollfd> pollFds;
+  std::vector<Worker *> polledWorkers;
+  std::array<char, 64 * 1024> buffer{};
+  while (true) {
+    pollFds.clear();
+    polledWorkers.clear();
+    for (auto &worker : workers) {
+      if (worker.resultFd >= 0) {
+        pollFds.push_back(pollfd{worker.resultFd, POLLIN, 0});
+        polledWorkers.push_back(&worker);
+      }
+    }
+    if (pollFds.empty())
+      break;
+    if (::poll(pollFds.data(), static_cast<nfds_t>(pollFds.size()), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error(std::string("Failed to wait for worker processes: ") + strerror(errno));
+    }
+    for (std::size_t i = 0; i < pollFds.size(); ++i) {
+      if (pollFds[i].revents == 0)
+        continue;
+      Worker &worker = *polledWorkers[i];
+      auto numRead = ::read(worker.resultFd, buffer.data(), buffer.size());
+      if (numRead < 0 && errno == EINTR)
+        continue;
+      if (numRead > 0) {
+        worker.decoder->feed(buffer.data(), static_cast<std::size_t>(numRead));
+        continue;
+      }
+      // end-of-file, the worker process is gone
+      ::close(worker.resultFd);
+      worker.resultFd = -1;
+      if (worker.requestFd >= 0)
+        ::close(worker.requestFd);
+      worker.requestFd = -1;
+      stopTimeout(worker);
+      int status = 0;
+      while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      worker.pid = -1;
+      if (worker.currentMethod != NO_METHOD) {
+        // includes the time to start the test-method in the worker process
+        const auto elapsed = std::chrono::steady_clock::now() - worker.startTime;
+        busyTime += elapsed;
+        auto message = describeTermination(status, limits);
+        if (worker.timedOut)
+          message = "Test-method timed out after " +
+                    std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) +
+                    " ms (timeout " + std::to_string(worker.timeout.count()) + " ms), killed worker process";
+        // the errno left behind is unrelated to the termination of the worker
+        errno = 0;
+        reportFailure(worker.currentMethod, message, elapsed);
+        worker.currentMethod = NO_METHOD;
+      }
+      // replace the crashed worker, if there is more work to do
+      while (nextMethod < methods.size()) {
+        if (spawn(worker)) {
+          dispatch(worker);
+          break;
+        }
+        reportFailure(nextMethod++, std::string("Failed to create worker process: ") + strerror(errno),
+            std::chrono::nanoseconds::zero());
+      }
+    }
+  }
+
+  sigaction(SIGPIPE, &previousPipe, nullptr);
+  if (TimingReport *report = TimingReport::getActive())
+    report->recordParallelRun(
+        name, busyTime, std::chrono::steady_clock::now() - startTime, static_cast<unsigned>(workers.size()));
+}
+#endif
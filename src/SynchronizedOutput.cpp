@@ -21,16 +21,21 @@ void SynchronizedOutput::initializeTestMethod(
   realOutput.initializeTestMethod(suiteName, methodName, argString);
 }
 
-void SynchronizedOutput::finishTestMethod(
-    const std::string &suiteName, const std::string &methodName, const std::string &argString, const bool withSuccess) {
+void SynchronizedOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const bool withSuccess, std::chrono::nanoseconds duration) {
   std::lock_guard<std::mutex> guard(outputMutex);
-  realOutput.finishTestMethod(suiteName, methodName, argString, withSuccess);
+  realOutput.finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
 }
 
 void SynchronizedOutput::printException(const std::string &suiteName, const std::string &methodName,
-    const std::string &argString, const std::exception &ex) {
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
   std::lock_guard<std::mutex> guard(outputMutex);
-  realOutput.printException(suiteName, methodName, argString, ex);
+  realOutput.printException(suiteName, methodName, argString, ex, duration);
+}
+
+OutputEvents SynchronizedOutput::getConsumedEvents() const {
+  // not synchronized, the value does not change while running
+  return realOutput.getConsumedEvents();
 }
 
 void SynchronizedOutput::printSuccess(const Assertion &assertion) {
@@ -38,7 +43,32 @@ void SynchronizedOutput::printSuccess(const Assertion &assertion) {
   realOutput.printSuccess(assertion);
 }
 
+void SynchronizedOutput::printSuccessEvent(const AssertionEvent &event) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  realOutput.printSuccessEvent(event);
+}
+
 void SynchronizedOutput::printFailure(const Assertion &assertion) {
   std::lock_guard<std::mutex> guard(outputMutex);
   realOutput.printFailure(assertion);
 }
+
+void SynchronizedOutput::printBenchmark(const BenchmarkResult &result) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  realOutput.printBenchmark(result);
+}
+
+void SynchronizedOutput::printComplexity(const ComplexityResult &result) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  realOutput.printComplexity(result);
+}
+
+void SynchronizedOutput::printPerfCounters(const PerfCounterResult &result) {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  realOutput.printPerfCounters(result);
+}
+
+void SynchronizedOutput::flush() {
+  std::lock_guard<std::mutex> guard(outputMutex);
+  realOutput.flush();
+}
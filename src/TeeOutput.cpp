@@ -0,0 +1,103 @@
+#include "TeeOutput.h"
+
+using namespace Test;
+
+TeeOutput::TeeOutput(Output &first, Output &second) {
+  addOutput(first);
+  addOutput(second);
+}
+
+void TeeOutput::addOutput(Output &output) { targets.push_back(Target{&output, output.getConsumedEvents()}); }
+
+void TeeOutput::initializeSuite(const std::string &suiteName, const unsigned int numTests) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::INITIALIZE_SUITE))
+      target.output->initializeSuite(suiteName, numTests);
+  }
+}
+
+void TeeOutput::finishSuite(const std::string &suiteName, const unsigned int numTests,
+    const unsigned int numPositiveTests, const std::chrono::microseconds totalDuration) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::FINISH_SUITE))
+      target.output->finishSuite(suiteName, numTests, numPositiveTests, totalDuration);
+  }
+}
+
+void TeeOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::INITIALIZE_TEST_METHOD))
+      target.output->initializeTestMethod(suiteName, methodName, argString);
+  }
+}
+
+void TeeOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const bool withSuccess, std::chrono::nanoseconds duration) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::FINISH_TEST_METHOD))
+      target.output->finishTestMethod(suiteName, methodName, argString, withSuccess, duration);
+  }
+}
+
+void TeeOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::EXCEPTION))
+      target.output->printException(suiteName, methodName, argString, ex, duration);
+  }
+}
+
+OutputEvents TeeOutput::getConsumedEvents() const {
+  OutputEvents events = OutputEvents::NONE;
+  for (const auto &target : targets)
+    events = events | target.events;
+  return events;
+}
+
+void TeeOutput::printSuccess(const Assertion &assertion) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::SUCCESS))
+      target.output->printSuccess(assertion);
+  }
+}
+
+void TeeOutput::printSuccessEvent(const AssertionEvent &event) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::SUCCESS))
+      target.output->printSuccessEvent(event);
+  }
+}
+
+void TeeOutput::printFailure(const Assertion &assertion) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::FAILURE))
+      target.output->printFailure(assertion);
+  }
+}
+
+void TeeOutput::printBenchmark(const BenchmarkResult &result) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::BENCHMARK))
+      target.output->printBenchmark(result);
+  }
+}
+
+void TeeOutput::printComplexity(const ComplexityResult &result) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::COMPLEXITY))
+      target.output->printComplexity(result);
+  }
+}
+
+void TeeOutput::printPerfCounters(const PerfCounterResult &result) {
+  for (auto &target : targets) {
+    if (hasAny(target.events, OutputEvents::PERF_COUNTERS))
+      target.output->printPerfCounters(result);
+  }
+}
+
+void TeeOutput::flush() {
+  for (auto &target : targets)
+    target.output->flush();
+}
@@ -14,8 +14,6 @@
 #include <vector>
 
 namespace Test {
-  using SuiteSupplier = std::function<Test::Suite *(void)>;
-
   struct SuiteEntry {
     std::string name;
     SuiteSupplier supplier;
@@ -75,18 +73,78 @@ namespace Test {
               << std::endl;
     std::cout << std::setw(paramWidth) << " " << std::setw(gapWidth) << " "
               << "Can be repeated to include test-methods matching any of the given patterns." << std::endl;
+    std::cout << std::setw(paramWidth) << "--jobs=<num>" << std::setw(gapWidth) << " "
+              << "Sets the number of worker threads running parallel suites. Defaults to the number of hardware "
+                 "threads"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--timeout=<ms>" << std::setw(gapWidth) << " "
+              << "Sets the default timeout for all test-methods without explicit timeout, 0 disables the timeout. A "
+                 "test-method exceeding its timeout fails and is cancelled on its next assertion. If it does not "
+                 "return within the timeout again, the test run is aborted (use --isolate=process to continue)"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--shard=I/N" << std::setw(gapWidth) << " "
+              << "Runs only the I-th (starting at 1) of N shards of the selected test-methods. The test-methods are "
+                 "distributed to have the same total duration per shard according to the --timing-file, or by their "
+                 "names if no durations are recorded"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--timing-file=<file>" << std::setw(gapWidth) << " "
+              << "Reads the durations of the test-methods recorded in previous runs from and writes the durations of "
+                 "this run to the given file"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--benchmark-baseline=<file>" << std::setw(gapWidth) << " "
+              << "Compares the benchmarks against the results recorded in the given file and fails benchmarks with a "
+                 "significant slowdown. Benchmarks missing in the file are added to it"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--benchmark-threshold=<%>" << std::setw(gapWidth) << " "
+              << "Sets the slowdown of the median in percent a benchmark needs to exceed to fail. Defaults to 5"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--benchmark-significance=<p>" << std::setw(gapWidth) << " "
+              << "Sets the maximum p-value of the Mann-Whitney U test for a slowdown to be significant. Defaults to "
+                 "0.01"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--benchmark-update-baseline" << std::setw(gapWidth) << " "
+              << "Replaces the results of all benchmarks in the --benchmark-baseline with the results of this run"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--perf-counters" << std::setw(gapWidth) << " "
+              << "Measures the cycles, instructions, branch and cache misses and context switches of every test-method "
+                 "via the Linux perf_event_open interface and reports the IPC and miss rates. Counters not permitted "
+                 "by /proc/sys/kernel/perf_event_paranoid are skipped"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--report-slowest=<num>" << std::setw(gapWidth) << " "
+              << "Prints a summary after all tests finished: the given number of slowest test-methods and suites, the "
+                 "share of the time spent in the fixtures and test-methods and the parallel efficiency of the suites "
+                 "run in parallel. Printed to stderr if a junit, ndjson or binary output is written to stdout"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--isolate=val" << std::setw(gapWidth) << " "
+              << "Sets the isolation of the test-methods. Available options are: none, process. 'process' runs the "
+                 "test-methods in a pool of --jobs worker processes forked after the suite setup, reporting crashed "
+                 "workers as test errors. Defaults to 'none'"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--isolate-memory-limit=<MiB>" << std::setw(gapWidth) << " "
+              << "Limits the virtual memory of every worker process in process isolation mode" << std::endl;
+    std::cout << std::setw(paramWidth) << "--isolate-cpu-limit=<s>" << std::setw(gapWidth) << " "
+              << "Limits the CPU time of every worker process in process isolation mode" << std::endl;
     std::cout << std::setw(paramWidth) << "--output=val" << std::setw(gapWidth) << " "
-              << "Sets the output of the tests. Available options are: plain, colored, gcc, msvc, generic, junit. "
-                 "Defaults to 'plain'"
+              << "Sets the output of the tests. Available options are: plain, colored, gcc, msvc, generic, junit, "
+                 "ndjson, binary. Defaults to 'plain'"
               << std::endl;
     std::cout << std::setw(paramWidth) << "-o=val" << std::setw(gapWidth) << " "
               << "'plain' prints simple text, 'colored' uses console colors, 'gcc', 'msvc' and 'generic' use "
-                 "compiler-like output syntax"
+                 "compiler-like output syntax, 'ndjson' writes one JSON object per event and line, 'binary' writes a "
+                 "compact event log which can be replayed into any other output with 'cpptest-replay'"
               << std::endl;
     std::cout << std::setw(paramWidth) << "--mode=val" << std::setw(gapWidth) << " "
               << "Sets the output mode to one of 'debug', 'verbose', 'terse' in order of the amount of information "
                  "printed. Defaults to 'terse'"
               << std::endl;
+    std::cout << std::setw(paramWidth) << "--async-output" << std::setw(gapWidth) << " "
+              << "Writes the output on a dedicated thread, the test-methods only append their events to per-thread "
+                 "buffers. Not supported with --isolate=process"
+              << std::endl;
+    std::cout << std::setw(paramWidth) << "--output-order=val" << std::setw(gapWidth) << " "
+              << "Writes the output of every test-method as one block once it finished ('grouped') or additionally in "
+                 "the order of registration ('canonical'), so parallel runs produce the same output"
+              << std::endl;
     std::cout << std::setw(paramWidth) << "--output-file=file" << std::setw(gapWidth) << " "
               << "Sets the optional output file to write to, defaults to 'stdout'. 'colored' output can only write to "
                  "console!"
@@ -114,20 +172,54 @@ namespace Test {
     return it == parts.end();
   }
 
+  static bool matchesAnyPattern(const std::string &name, const std::vector<std::vector<std::string>> &patterns) {
+    return std::any_of(patterns.begin(), patterns.end(),
+        [&name](const std::vector<std::string> &pattern) { return matchesPattern(name, pattern); });
+  }
+
   static std::vector<TestMethodInfo> filterTests(
       std::vector<TestMethodInfo> &&infos, const std::vector<std::vector<std::string>> &patterns) {
-    infos.erase(
-        std::remove_if(infos.begin(), infos.end(),
-            [&patterns](const TestMethodInfo &info) {
-              return std::none_of(patterns.begin(), patterns.end(),
-                  [&info](const std::vector<std::string> &pattern) { return matchesPattern(info.fullName, pattern); });
-            }),
+    infos.erase(std::remove_if(infos.begin(), infos.end(),
+                    [&patterns](const TestMethodInfo &info) { return !matchesAnyPattern(info.fullName, patterns); }),
         infos.end());
     return std::move(infos);
   }
 
+  /*
+   * Returns the positions (in the list of test-methods of the suite) of the test-methods of the given shard for every
+   * given suite. Only a single suite instance is alive at any time.
+   */
+  static std::vector<std::vector<std::size_t>> selectShard(const std::vector<const SuiteEntry *> &suites,
+      const std::vector<std::vector<std::string>> &patterns, unsigned shardIndex, unsigned numShards,
+      const TimingHistory &history) {
+    std::vector<std::vector<std::size_t>> positions(suites.size());
+    std::vector<std::string> testNames;
+    for (std::size_t i = 0; i < suites.size(); ++i) {
+      std::unique_ptr<Test::Suite> suite(suites[i]->supplier());
+      auto tests = suite->listTests();
+      for (std::size_t position = 0; position < tests.size(); ++position) {
+        if (patterns.empty() || matchesAnyPattern(tests[position].fullName, patterns)) {
+          positions[i].push_back(position);
+          testNames.emplace_back(Test::TimingHistory::getTestKey(tests[position].suiteName, tests[position].fullName));
+        }
+      }
+    }
+    auto shards = history.assignShards(testNames, numShards);
+    auto shard = shards.begin();
+    for (auto &suitePositions : positions) {
+      std::vector<std::size_t> shardPositions;
+      for (auto position : suitePositions) {
+        if (*shard++ == shardIndex)
+          shardPositions.push_back(position);
+      }
+      suitePositions = std::move(shardPositions);
+    }
+    return positions;
+  }
+
   int runSuites(int argc, char **argv, const ArgumentCallback &callback) {
-    std::vector<std::pair<std::unique_ptr<Test::Suite>, std::string>> selectedSuites;
+    // the suites are only constructed right before they are used, see below
+    std::vector<const SuiteEntry *> selectedSuites;
     std::set<std::string> selectedSuiteNames;
     selectedSuites.reserve(static_cast<std::size_t>(argc));
     std::string outputMode = "plain";
@@ -137,6 +229,18 @@ namespace Test {
     std::ostream *listTestsOutput = nullptr;
     std::ostream *listSuitesOutput = nullptr;
     std::vector<std::string> testPatterns;
+    bool isolateProcesses = false;
+    Test::ProcessPool::Limits workerLimits;
+    unsigned shardIndex = 0;
+    unsigned numShards = 0;
+    std::string timingFile;
+    std::string baselineFile;
+    Test::BenchmarkBaseline benchmarkBaseline;
+    std::unique_ptr<Test::TimingReport> timingReport;
+    bool perfCounters = false;
+    bool asyncOutput = false;
+    bool orderOutput = false;
+    Test::OrderedOutput::Order outputOrder = Test::OrderedOutput::Order::GROUPED;
     for (int i = 1; i < argc; ++i) {
       std::string arg(argv[i]);
       if (arg == "--help" || arg == "-h") {
@@ -159,6 +263,90 @@ namespace Test {
       } else if (arg.find("--test-pattern=") == 0) {
         if (arg.find('=') != std::string::npos)
           testPatterns.emplace_back(arg.substr(arg.find('=') + 1));
+      } else if (arg.find("--jobs=") == 0) {
+        try {
+          Test::WorkerPool::setDefaultConcurrency(static_cast<unsigned>(std::stoul(arg.substr(arg.find('=') + 1))));
+        } catch (const std::exception &) {
+          std::cerr << "Invalid number of jobs: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--timeout=") == 0) {
+        try {
+          Test::Watchdog::setDefaultTimeout(std::chrono::milliseconds{std::stoul(arg.substr(arg.find('=') + 1))});
+        } catch (const std::exception &) {
+          std::cerr << "Invalid timeout: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--shard=") == 0) {
+        auto shard = arg.substr(arg.find('=') + 1);
+        try {
+          if (shard.find('/') == std::string::npos)
+            throw std::invalid_argument("Missing number of shards");
+          shardIndex = static_cast<unsigned>(std::stoul(shard.substr(0, shard.find('/'))));
+          numShards = static_cast<unsigned>(std::stoul(shard.substr(shard.find('/') + 1)));
+          if (shardIndex == 0 || shardIndex > numShards)
+            throw std::out_of_range("Shard index out of range");
+        } catch (const std::exception &) {
+          std::cerr << "Invalid shard, expected --shard=I/N with 1 <= I <= N: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--timing-file=") == 0) {
+        timingFile = arg.substr(arg.find('=') + 1);
+      } else if (arg.find("--benchmark-baseline=") == 0) {
+        baselineFile = arg.substr(arg.find('=') + 1);
+      } else if (arg.find("--benchmark-threshold=") == 0) {
+        try {
+          benchmarkBaseline.setRelativeThreshold(std::stod(arg.substr(arg.find('=') + 1)) / 100.0);
+        } catch (const std::exception &) {
+          std::cerr << "Invalid benchmark threshold: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--benchmark-significance=") == 0) {
+        try {
+          benchmarkBaseline.setSignificanceLevel(std::stod(arg.substr(arg.find('=') + 1)));
+        } catch (const std::exception &) {
+          std::cerr << "Invalid benchmark significance level: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg == "--benchmark-update-baseline") {
+        benchmarkBaseline.setUpdateExisting(true);
+      } else if (arg == "--perf-counters") {
+        perfCounters = true;
+      } else if (arg.find("--report-slowest=") == 0) {
+        try {
+          timingReport.reset(new Test::TimingReport(std::stoul(arg.substr(arg.find('=') + 1))));
+        } catch (const std::exception &) {
+          std::cerr << "Invalid number of slowest tests: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--isolate=") == 0) {
+        if (arg.substr(arg.find('=') + 1) == "process")
+          isolateProcesses = true;
+        else if (arg.substr(arg.find('=') + 1) != "none") {
+          std::cerr << "Unrecognized isolation mode: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg.find("--isolate-memory-limit=") == 0 || arg.find("--isolate-cpu-limit=") == 0) {
+        try {
+          auto limit = std::stoul(arg.substr(arg.find('=') + 1));
+          if (arg.find("--isolate-memory-limit=") == 0)
+            workerLimits.maxMemory = static_cast<std::size_t>(limit) * 1024 * 1024;
+          else
+            workerLimits.maxCpuTime = std::chrono::seconds{limit};
+        } catch (const std::exception &) {
+          std::cerr << "Invalid resource limit: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else if (arg == "--async-output") {
+        asyncOutput = true;
+      } else if (arg.find("--output-order=") == 0) {
+        orderOutput = true;
+        if (arg.substr(arg.find('=') + 1) == "canonical")
+          outputOrder = Test::OrderedOutput::Order::CANONICAL;
+        else if (arg.substr(arg.find('=') + 1) != "grouped") {
+          std::cerr << "Unrecognized output order: " << arg << std::endl;
+          return EXIT_FAILURE;
+        }
       } else if (arg.find("--output-file=") == 0) {
         if (arg.find('=') != std::string::npos)
           outputFile = arg.substr(arg.find('=') + 1);
@@ -187,7 +375,7 @@ namespace Test {
           continue;
         }
         if (selectedSuiteNames.find(name) == selectedSuiteNames.end()) {
-          selectedSuites.emplace_back(std::make_pair(it->supplier(), it->name));
+          selectedSuites.emplace_back(&*it);
           selectedSuiteNames.emplace(name);
         }
       }
@@ -219,18 +407,32 @@ namespace Test {
           continue;
         }
         if (selectedSuiteNames.find(entry.name) == selectedSuiteNames.end()) {
-          selectedSuites.emplace_back(std::make_pair(entry.supplier(), entry.name));
+          selectedSuites.emplace_back(&entry);
           selectedSuiteNames.emplace(entry.name);
         }
       }
     }
 
+    if (isolateProcesses && !Test::ProcessPool::isSupported()) {
+      std::cerr << "Process isolation is not supported on this platform, running tests in-process!" << std::endl;
+      isolateProcesses = false;
+    }
+    if (isolateProcesses && asyncOutput) {
+      // the worker processes are forked at any time, while the writer thread could hold locks or unflushed output
+      std::cerr << "Asynchronous output is not supported with process isolation, writing the output synchronously!"
+                << std::endl;
+      asyncOutput = false;
+    }
+
     std::ofstream f;
     if (!outputFile.empty())
       f.open(outputFile, std::ios_base::out | std::ios_base::trunc);
 
     std::unique_ptr<Test::Output> realOutput;
     std::unique_ptr<Test::Output> output;
+    std::unique_ptr<Test::OrderedOutput> orderedOutput;
+    // the machine-readable outputs written to stdout must not be followed by the text of the timing report
+    std::ostream *reportStream = &std::cout;
 
     if (outputMode.find("plain") != std::string::npos) {
       if (!outputFile.empty())
@@ -257,8 +459,24 @@ namespace Test {
     } else if (outputMode.find("junit") != std::string::npos) {
       if (!outputFile.empty())
         realOutput.reset(new Test::XMLOutput(outputFile));
-      else
+      else {
         realOutput.reset(new Test::XMLOutput(std::cout));
+        reportStream = &std::cerr;
+      }
+    } else if (outputMode.find("ndjson") != std::string::npos) {
+      if (!outputFile.empty())
+        realOutput.reset(new Test::NDJSONOutput(outputFile));
+      else {
+        realOutput.reset(new Test::NDJSONOutput(std::cout));
+        reportStream = &std::cerr;
+      }
+    } else if (outputMode.find("binary") != std::string::npos) {
+      if (!outputFile.empty())
+        realOutput.reset(new Test::BinaryLogOutput(outputFile));
+      else {
+        realOutput.reset(new Test::BinaryLogOutput(std::cout));
+        reportStream = &std::cerr;
+      }
     } else {
       std::cout << "Unrecognized output: " << outputMode << std::endl;
       if (!outputFile.empty())
@@ -268,27 +486,147 @@ namespace Test {
     }
 
     // there could be parallel suites
-    output.reset(new Test::SynchronizedOutput(*realOutput));
+    if (asyncOutput)
+      output.reset(new Test::AsyncOutput(*realOutput));
+    else if (!orderOutput)
+      output.reset(new Test::SynchronizedOutput(*realOutput));
+    if (orderOutput) {
+      // the ordered output is thread-safe itself
+      orderedOutput.reset(new Test::OrderedOutput(output ? *output : *realOutput, outputOrder));
+    }
+    Test::Output &runOutput = orderedOutput ? *orderedOutput : *output;
 
     if (selectedSuites.empty()) {
       std::cerr << "No Test-suites selected, exiting!" << std::endl;
       return EXIT_SUCCESS;
     }
 
+    auto runSuite = [&](Test::Suite &suite, const SuiteEntry &entry, const std::vector<TestMethodInfo> &tests) {
+      if (orderedOutput)
+        orderedOutput->expectSuite(suite, tests);
+      if (isolateProcesses) {
+        Test::ProcessPool pool(Test::WorkerPool::getDefaultConcurrency(), workerLimits);
+        return pool.run(suite, runOutput, tests, Test::continueAfterFailure);
+      }
+      if (entry.has(RegistrationFlags::PARALLEL_METHODS))
+        return suite.runInParallel(runOutput, tests, entry.supplier, Test::continueAfterFailure);
+      return suite.run(runOutput, tests, Test::continueAfterFailure);
+    };
+
+    Test::TimingHistory timingHistory;
+    if (!timingFile.empty())
+      timingHistory.load(timingFile);
+
+    // the positions of the test-methods of this shard per selected suite
+    std::vector<std::vector<std::size_t>> shardPositions;
+    if (numShards != 0)
+      shardPositions = selectShard(selectedSuites, testSplitPatterns, shardIndex - 1, numShards, timingHistory);
+
+    if (!timingFile.empty())
+      Test::TimingHistory::setActive(&timingHistory);
+    if (!baselineFile.empty()) {
+      benchmarkBaseline.load(baselineFile);
+      Test::BenchmarkBaseline::setActive(&benchmarkBaseline);
+    }
+    Test::TimingReport::setActive(timingReport.get());
+    // a hung test-method cannot be joined, so the outputs cannot be finished, but everything recorded so far is saved
+    Test::Watchdog::setAbortHandler([&]() {
+      runOutput.flush();
+      if (!timingFile.empty()) {
+        try {
+          timingHistory.save(timingFile);
+        } catch (const std::exception &e) {
+          std::cerr << e.what() << std::endl;
+        }
+      }
+      if (!baselineFile.empty()) {
+        try {
+          benchmarkBaseline.save(baselineFile);
+        } catch (const std::exception &e) {
+          std::cerr << e.what() << std::endl;
+        }
+      }
+    });
+    if (perfCounters) {
+      // the counters of the main thread, the other threads open their counters on first use
+      const uint32_t available = Test::PerfCounters::getCurrentThread().getAvailable();
+      if (available == 0)
+        std::cerr << "Performance counters are not available (not supported on this platform or forbidden by "
+                     "/proc/sys/kernel/perf_event_paranoid), running without them"
+                  << std::endl;
+      else if ((available & (1u << static_cast<unsigned>(Test::PerfCounter::CYCLES))) == 0)
+        std::cerr << "Hardware performance counters are not available (e.g. forbidden by "
+                     "/proc/sys/kernel/perf_event_paranoid or not exposed to a virtual machine), only measuring the "
+                     "software counters"
+                  << std::endl;
+      Test::PerfCounters::setEnabled(available != 0);
+    }
+
     bool failures = false;
-    for (auto &suite : selectedSuites) {
-      if (!testPatterns.empty()) {
-        auto matchingTests = filterTests(suite.first->listTests(), testSplitPatterns);
-        if (!matchingTests.empty())
-          failures = !suite.first->run(*output, matchingTests, Test::continueAfterFailure) || failures;
+    for (std::size_t i = 0; i < selectedSuites.size(); ++i) {
+      const SuiteEntry &entry = *selectedSuites[i];
+      // construct every suite right before it is used and destroy it afterwards, so only one suite (and its fixtures)
+      // is resident at any time
+      std::unique_ptr<Test::Suite> suite(entry.supplier());
+      // the test-methods to run, only if a subset of the test-methods is selected
+      std::vector<TestMethodInfo> selectedTests;
+      if (numShards != 0) {
+        auto tests = suite->listTests();
+        for (auto position : shardPositions[i])
+          selectedTests.emplace_back(std::move(tests[position]));
+      } else if (!testPatterns.empty()) {
+        selectedTests = filterTests(suite->listTests(), testSplitPatterns);
+      }
+
+      if (!testPatterns.empty() || (numShards != 0 && !listTestsOutput && !listSuitesOutput)) {
+        if (!selectedTests.empty())
+          failures = !runSuite(*suite, entry, selectedTests) || failures;
       } else if (listTestsOutput) {
-        for (const auto &test : suite.first->listTests()) {
+        for (const auto &test : numShards != 0 ? selectedTests : suite->listTests()) {
           *listTestsOutput << test.fullName << std::endl;
         }
       } else if (listSuitesOutput) {
-        *listSuitesOutput << suite.first->getName() << ':' << suite.second << std::endl;
+        *listSuitesOutput << suite->getName() << ':' << entry.name << std::endl;
+      } else if (isolateProcesses || entry.has(RegistrationFlags::PARALLEL_METHODS)) {
+        failures = !runSuite(*suite, entry, suite->listTests()) || failures;
       } else {
-        failures = !suite.first->run(*output, Test::continueAfterFailure) || failures;
+        if (orderedOutput)
+          orderedOutput->expectSuite(*suite, suite->listTests());
+        failures = !suite->run(runOutput, Test::continueAfterFailure) || failures;
+      }
+    }
+
+    Test::Watchdog::setAbortHandler(nullptr);
+    Test::TimingReport::setActive(nullptr);
+    Test::PerfCounters::setEnabled(false);
+    if (timingReport && !listSuitesOutput && (!listTestsOutput || !testPatterns.empty())) {
+      // the summary is printed after all output of the tests
+      orderedOutput.reset();
+      output.reset();
+      realOutput.reset();
+      timingReport->print(*reportStream);
+    }
+
+    if (!timingFile.empty()) {
+      Test::TimingHistory::setActive(nullptr);
+      // only listing the test-methods does not record anything
+      if (!listSuitesOutput && (!listTestsOutput || !testPatterns.empty())) {
+        try {
+          timingHistory.save(timingFile);
+        } catch (const std::exception &e) {
+          std::cerr << e.what() << std::endl;
+        }
+      }
+    }
+
+    if (!baselineFile.empty()) {
+      Test::BenchmarkBaseline::setActive(nullptr);
+      if (!listSuitesOutput && (!listTestsOutput || !testPatterns.empty())) {
+        try {
+          benchmarkBaseline.save(baselineFile);
+        } catch (const std::exception &e) {
+          std::cerr << e.what() << std::endl;
+        }
       }
     }
 
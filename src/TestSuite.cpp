@@ -1,5 +1,15 @@
 #include "TestSuite.h"
 
+#include "PerfCounters.h"
+#include "SynchronizedOutput.h"
+#include "TimingHistory.h"
+#include "TimingReport.h"
+#include "Watchdog.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
 #if defined(__GNUG__) || defined(__clang__)
@@ -8,12 +18,20 @@
 
 using namespace Test;
 
+static std::string describeTimeout(std::chrono::steady_clock::duration elapsed, std::chrono::milliseconds timeout) {
+  return "Test-method timed out after " +
+         std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + " ms (timeout " +
+         std::to_string(timeout.count()) + " ms)";
+}
+
 Suite::Suite() : Suite("") {}
 
 Suite::Suite(const std::string &name)
     : suiteName(name), testMethods({}), subSuites({}), currentTestMethodName(""), currentTestMethodArgs(""),
       totalDuration(std::chrono::microseconds::zero()), output(nullptr), positiveTestMethods(0),
-      continueAfterFail(true), currentTestSucceeded(false) {}
+      continueAfterFail(true), currentTestSucceeded(false), consumedEvents(OutputEvents::ALL), currentTest(0),
+      passedAssertions(0), suiteTimeout(std::chrono::milliseconds::zero()),
+      watchTimeouts(true), currentTimeout(std::chrono::milliseconds::zero()), currentTimeoutExpired(nullptr) {}
 
 void Suite::add(const std::shared_ptr<Test::Suite> &suite) { subSuites.push_back(suite); }
 
@@ -23,13 +41,16 @@ bool Suite::run(Output &out, const std::vector<TestMethodInfo> &selectedMethods,
   auto selectedTestMethods = filterTests(selectedMethods);
 
   this->continueAfterFail = continueOnError;
-  this->output = &out;
-  out.initializeSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()));
+  setOutput(out);
+  if (hasAny(consumedEvents, OutputEvents::INITIALIZE_SUITE))
+    out.initializeSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()));
   // run tests
   totalDuration = std::chrono::microseconds::zero();
   positiveTestMethods = 0;
+  passedAssertions = 0;
+  const auto startTime = std::chrono::steady_clock::now();
   // run setup before all tests
-  if (setup()) {
+  if (runSetup()) {
     for (const auto &method : selectedTestMethods) {
       std::pair<bool, std::chrono::microseconds> result = runTestMethod(method.get());
       totalDuration += result.second;
@@ -37,9 +58,91 @@ bool Suite::run(Output &out, const std::vector<TestMethodInfo> &selectedMethods,
         ++positiveTestMethods;
     }
     // run tear-down after all tests
-    tear_down();
+    runTearDown();
+  }
+  if (TimingReport *report = TimingReport::getActive())
+    report->recordSuite(suiteName, std::chrono::steady_clock::now() - startTime);
+  if (hasAny(consumedEvents, OutputEvents::FINISH_SUITE))
+    out.finishSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()), positiveTestMethods, totalDuration);
+
+  // run sub-suites
+  for (std::shared_ptr<Test::Suite> &suite : subSuites) {
+    suite->run(out, selectedMethods, continueAfterFail);
+  }
+
+  return positiveTestMethods == selectedTestMethods.size();
+}
+
+bool Suite::runInParallel(Output &out, const std::vector<TestMethodInfo> &selectedMethods,
+    const SuiteSupplier &supplier, bool continueOnError) {
+  auto selectedTestMethods = filterTests(selectedMethods);
+  WorkerPool &pool = WorkerPool::getDefault();
+  const auto numWorkers = std::min<std::size_t>(pool.getNumWorkers(), selectedTestMethods.size());
+  if (!supplier || numWorkers < 2)
+    return run(out, selectedMethods, continueOnError);
+
+  // the index of a test-method is the same for every instance of this suite
+  std::vector<std::size_t> methodIndices;
+  methodIndices.reserve(selectedTestMethods.size());
+  for (const auto &method : selectedTestMethods)
+    methodIndices.push_back(static_cast<std::size_t>(&method.get() - testMethods.data()));
+  sortLongestFirst(methodIndices);
+
+  this->continueAfterFail = continueOnError;
+  // thread-safe outputs can be used by all workers directly
+  std::unique_ptr<SynchronizedOutput> synchronizedOutput(out.isThreadSafe() ? nullptr : new SynchronizedOutput(out));
+  Output &workerOutput = synchronizedOutput ? *synchronizedOutput : out;
+  const OutputEvents events = out.getConsumedEvents();
+  if (hasAny(events, OutputEvents::INITIALIZE_SUITE))
+    out.initializeSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()));
+
+  std::atomic<std::size_t> nextMethod{0};
+  std::atomic<uint32_t> numPositiveTests{0};
+  std::atomic<std::chrono::microseconds::rep> durationCount{0};
+  std::atomic<uint64_t> numPassedAssertions{0};
+  std::atomic<bool> setupFailed{false};
+  std::atomic<std::chrono::nanoseconds::rep> busyCount{0};
+  const auto startTime = std::chrono::steady_clock::now();
+  WorkerPool::TaskGroup group;
+  for (std::size_t i = 0; i < numWorkers; ++i) {
+    pool.submit(group, [&]() {
+      const auto workerStart = std::chrono::steady_clock::now();
+      std::unique_ptr<Suite> worker(supplier());
+      if (!worker || worker->testMethods.size() != testMethods.size())
+        throw std::logic_error("Supplier for suite '" + suiteName + "' created an instance with other test-methods");
+      worker->continueAfterFail = continueAfterFail;
+      worker->setOutput(workerOutput);
+      // run setup once per worker instance, skip all remaining test-methods if any setup fails
+      if (setupFailed || !worker->runSetup()) {
+        setupFailed = true;
+        return;
+      }
+      std::size_t index = 0;
+      while (!setupFailed && (index = nextMethod++) < methodIndices.size()) {
+        std::pair<bool, std::chrono::microseconds> result =
+            worker->runTestMethod(worker->testMethods[methodIndices[index]]);
+        durationCount += result.second.count();
+        if (result.first)
+          ++numPositiveTests;
+      }
+      worker->runTearDown();
+      numPassedAssertions += worker->passedAssertions;
+      busyCount += (std::chrono::steady_clock::now() - workerStart).count();
+    });
+  }
+  pool.wait(group);
+  if (TimingReport *report = TimingReport::getActive()) {
+    const auto wallTime = std::chrono::steady_clock::now() - startTime;
+    report->recordSuite(suiteName, wallTime);
+    report->recordParallelRun(
+        suiteName, std::chrono::nanoseconds{busyCount.load()}, wallTime, static_cast<unsigned>(numWorkers));
   }
-  out.finishSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()), positiveTestMethods, totalDuration);
+
+  totalDuration = std::chrono::microseconds{durationCount.load()};
+  positiveTestMethods = numPositiveTests;
+  passedAssertions = numPassedAssertions;
+  if (hasAny(events, OutputEvents::FINISH_SUITE))
+    out.finishSuite(suiteName, static_cast<unsigned>(selectedTestMethods.size()), positiveTestMethods, totalDuration);
 
   // run sub-suites
   for (std::shared_ptr<Test::Suite> &suite : subSuites) {
@@ -53,8 +156,7 @@ std::vector<TestMethodInfo> Suite::listTests() const {
   std::vector<TestMethodInfo> result;
   result.reserve(testMethods.size());
   for (const auto &method : testMethods) {
-    result.emplace_back(
-        TestMethodInfo{reinterpret_cast<std::uintptr_t>(&method), method.name + "(" + method.argString + ")"});
+    result.emplace_back(TestMethodInfo{reinterpret_cast<std::uintptr_t>(&method), method.fullName(), suiteName});
   }
   for (const auto &suite : subSuites) {
     auto tmp = suite->listTests();
@@ -74,7 +176,17 @@ void Suite::addTest(SimpleTestMethod method, const std::string &funcName) {
   testMethods.emplace_back(funcName, method);
 }
 
+void Suite::setTestTimeout(std::chrono::milliseconds timeout) {
+  if (testMethods.empty())
+    throw std::logic_error("Cannot set the timeout, no test-method added to suite: " + suiteName);
+  testMethods.back().timeout = timeout;
+}
+
 void Suite::testSucceeded(Assertion &&assertion) {
+  checkTimeout();
+  ++passedAssertions;
+  if (!hasAny(consumedEvents, OutputEvents::SUCCESS))
+    return;
   assertion.method = currentTestMethodName;
   assertion.args = currentTestMethodArgs;
   assertion.suite = suiteName;
@@ -82,7 +194,10 @@ void Suite::testSucceeded(Assertion &&assertion) {
 }
 
 void Suite::testFailed(Assertion &&assertion) {
+  checkTimeout();
   currentTestSucceeded = false;
+  if (!hasAny(consumedEvents, OutputEvents::FAILURE))
+    return;
   assertion.method = currentTestMethodName;
   assertion.args = currentTestMethodArgs;
   assertion.suite = suiteName;
@@ -91,19 +206,23 @@ void Suite::testFailed(Assertion &&assertion) {
 
 void Suite::testFailed(
     const char *fileName, uint32_t lineNumber, std::string &&errorMessage, const std::string &userMessage) {
-  testFailed(Assertion(fileName, lineNumber, errorMessage, userMessage));
+  if (hasAny(consumedEvents, OutputEvents::FAILURE))
+    testFailed(Assertion(fileName, lineNumber, errorMessage, userMessage));
+  else {
+    // nobody is interested in the details of the failure
+    checkTimeout();
+    currentTestSucceeded = false;
+  }
   if (!continueAfterFailure())
     throw AssertionFailedException{};
 }
 
 void Suite::testRun(
     bool success, const char *fileName, uint32_t lineNumber, std::string &&errorMessage, const std::string &userMessage) {
-  if (!success) {
-    testFailed(Assertion(fileName, lineNumber, errorMessage, userMessage));
-    if (!continueAfterFailure())
-      throw AssertionFailedException{};
-  } else
-    testSucceeded(Assertion(fileName, lineNumber));
+  if (!success)
+    testFailed(fileName, lineNumber, std::move(errorMessage), userMessage);
+  else
+    testSucceeded(fileName, lineNumber);
 }
 
 std::pair<bool, std::chrono::microseconds> Suite::runTestMethod(const TestMethod &method) {
@@ -112,42 +231,147 @@ std::pair<bool, std::chrono::microseconds> Suite::runTestMethod(const TestMethod
   currentTestMethodName = method.name;
   currentTestMethodArgs = method.argString;
   currentTestSucceeded = true;
-  output->initializeTestMethod(suiteName, method.name, method.argString);
+  // only needed to report successful assertions
+  currentTest =
+      hasAny(consumedEvents, OutputEvents::SUCCESS) ? internTest(suiteName, method.name, method.argString) : 0;
+  if (hasAny(consumedEvents, OutputEvents::INITIALIZE_TEST_METHOD))
+    output->initializeTestMethod(suiteName, method.name, method.argString);
   // run before() before every test
-  if (before(currentTestMethodName)) {
+  if (Private::runFixture(
+          TimingReport::Phase::METHOD_FIXTURE, [this]() { return before(currentTestMethodName); })) {
+    // the counters are opened on their first use on a thread, which is not measured
+    PerfCounters *perfCounters = PerfCounters::isEnabled() && hasAny(consumedEvents, OutputEvents::PERF_COUNTERS)
+                                     ? &PerfCounters::getCurrentThread()
+                                     : nullptr;
     std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    currentTimeout = watchTimeouts ? getTimeout(method) : std::chrono::milliseconds::zero();
+    currentTestStart = startTime;
+    std::atomic<bool> timeoutExpired{false};
+    // whether the watchdog already reported the timeout, only accessed by the test thread after the deadlines are
+    // cancelled, which waits for the callbacks to finish
+    bool timeoutReported = false;
+    Watchdog::Handle expiryHandle = 0;
+    Watchdog::Handle abortHandle = 0;
+    if (currentTimeout.count() > 0) {
+      currentTimeoutExpired = &timeoutExpired;
+      Watchdog &watchdog = Watchdog::getDefault();
+      expiryHandle = watchdog.watch(startTime + currentTimeout, [this, &method, &timeoutExpired, &timeoutReported]() {
+        timeoutExpired = true;
+        if (output->isThreadSafe()) {
+          // report the timeout right away, the test-method might only return (if at all) much later
+          if (hasAny(consumedEvents, OutputEvents::EXCEPTION)) {
+            const auto elapsed = std::chrono::steady_clock::now() - currentTestStart;
+            output->printException(suiteName, method.name, method.argString,
+                TestTimeoutException(describeTimeout(elapsed, currentTimeout)), elapsed);
+          }
+          timeoutReported = true;
+        }
+      });
+      // the test-method did not react to the cancellation within the grace period, there is no way to recover from that
+      abortHandle = watchdog.watch(startTime + 2 * currentTimeout, [this, &method, &timeoutReported]() {
+        const auto elapsed = std::chrono::steady_clock::now() - currentTestStart;
+        const std::string message =
+            describeTimeout(elapsed, currentTimeout) + " and could not be cancelled, aborting the test run";
+        if (!timeoutReported && hasAny(consumedEvents, OutputEvents::EXCEPTION))
+          output->printException(suiteName, method.name, method.argString, TestTimeoutException(message), elapsed);
+        output->flush();
+        std::cout.flush();
+        std::cerr << method.fullName() << ": " << message
+                  << "! Run the tests with process isolation (--isolate=process) to only terminate the hung test-method"
+                  << std::endl;
+        Watchdog::abortProgram();
+      });
+    }
+    if (perfCounters)
+      perfCounters->start();
+    // reported after the deadlines are cancelled, since the watchdog might already have reported the timeout
+    std::exception_ptr exception;
     try {
       method(static_cast<Suite *>(this));
     } catch (const AssertionFailedException &) {
       currentTestSucceeded = false;
-    } catch (const std::exception &e) {
-      exceptionThrown = true;
-      currentTestSucceeded = false;
-      output->printException(suiteName, method.name, method.argString, e);
     } catch (...) {
+      exception = std::current_exception();
+    }
+    std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    PerfCounterResult perfResult;
+    if (perfCounters)
+      perfCounters->stop(perfResult);
+    if (currentTimeoutExpired != nullptr) {
+      Watchdog::getDefault().cancel(abortHandle);
+      Watchdog::getDefault().cancel(expiryHandle);
+      currentTimeoutExpired = nullptr;
+    }
+    if (exception || timeoutExpired) {
       exceptionThrown = true;
       currentTestSucceeded = false;
-      output->printException(suiteName, method.name, method.argString, std::runtime_error("non-exception type thrown"));
+      // if the watchdog already reported the timeout, the exception is most likely the cancellation of the test-method
+      if (!timeoutReported && hasAny(consumedEvents, OutputEvents::EXCEPTION)) {
+        if (!exception) {
+          // the test-method exceeded its timeout without running into any assertion afterwards
+          output->printException(suiteName, method.name, method.argString,
+              TestTimeoutException(describeTimeout(endTime - startTime, currentTimeout)), endTime - startTime);
+        } else {
+          try {
+            std::rethrow_exception(exception);
+          } catch (const std::exception &e) {
+            output->printException(suiteName, method.name, method.argString, e, endTime - startTime);
+          } catch (...) {
+            output->printException(suiteName, method.name, method.argString,
+                std::runtime_error("non-exception type thrown"), endTime - startTime);
+          }
+        }
+      }
     }
-    std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
     // run after() after every test
-    after(currentTestMethodName, currentTestSucceeded);
-    if (!exceptionThrown) {
+    Private::runFixture(TimingReport::Phase::METHOD_FIXTURE, [this]() {
+      after(currentTestMethodName, currentTestSucceeded);
+      return true;
+    });
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    if (TimingHistory *history = TimingHistory::getActive())
+      history->record(TimingHistory::getTestKey(suiteName, method.fullName()), duration);
+    if (TimingReport *report = TimingReport::getActive())
+      report->recordTestMethod(TimingHistory::getTestKey(suiteName, method.fullName()), endTime - startTime);
+    if (!exceptionThrown && perfResult.available != 0) {
+      perfResult.suite = suiteName;
+      perfResult.method = method.name;
+      perfResult.args = method.argString;
+      output->printPerfCounters(perfResult);
+    }
+    if (!exceptionThrown && hasAny(consumedEvents, OutputEvents::FINISH_TEST_METHOD)) {
       // we don't need to print twice, that the method has failed
-      output->finishTestMethod(suiteName, method.name, method.argString, currentTestSucceeded);
+      output->finishTestMethod(suiteName, method.name, method.argString, currentTestSucceeded, endTime - startTime);
     }
-    return std::make_pair(
-        currentTestSucceeded, std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime));
+    return std::make_pair(currentTestSucceeded, duration);
   }
   return std::make_pair(false, std::chrono::microseconds::zero());
 }
 
+bool Suite::runSetup() {
+  return Private::runFixture(TimingReport::Phase::SUITE_FIXTURE, [this]() { return setup(); });
+}
+
+void Suite::runTearDown() {
+  Private::runFixture(TimingReport::Phase::SUITE_FIXTURE, [this]() {
+    tear_down();
+    return true;
+  });
+}
+
 std::vector<std::reference_wrapper<const Suite::TestMethod>> Suite::filterTests(
     const std::vector<TestMethodInfo> &selectedMethods) {
   std::vector<std::reference_wrapper<const TestMethod>> result;
   result.reserve(selectedMethods.size());
 
+  if (testMethods.empty())
+    return result;
+  // the selection may contain test-methods of other (e.g. sub-) suites too, only run our own
+  const auto first = reinterpret_cast<std::uintptr_t>(testMethods.data());
+  const auto last = reinterpret_cast<std::uintptr_t>(testMethods.data() + testMethods.size());
   for (const auto &info : selectedMethods) {
+    if (info.reference < first || info.reference >= last)
+      continue;
     const auto *method = reinterpret_cast<const TestMethod *>(info.reference);
     result.emplace_back(std::cref(*method));
   }
@@ -155,6 +379,39 @@ std::vector<std::reference_wrapper<const Suite::TestMethod>> Suite::filterTests(
   return result;
 }
 
+void Suite::setOutput(Output &out) {
+  output = &out;
+  consumedEvents = out.getConsumedEvents();
+}
+
+std::chrono::milliseconds Suite::getTimeout(const TestMethod &method) const noexcept {
+  if (method.timeout.count() > 0)
+    return method.timeout;
+  if (suiteTimeout.count() > 0)
+    return suiteTimeout;
+  return Watchdog::getDefaultTimeout();
+}
+
+void Suite::checkTimeout() const {
+  if (currentTimeoutExpired != nullptr && *currentTimeoutExpired)
+    throw TestTimeoutException(describeTimeout(std::chrono::steady_clock::now() - currentTestStart, currentTimeout));
+}
+
+void Suite::sortLongestFirst(std::vector<std::size_t> &methodIndices) const {
+  const TimingHistory *history = TimingHistory::getActive();
+  if (history == nullptr || history->empty())
+    return;
+  std::vector<std::string> testNames;
+  testNames.reserve(methodIndices.size());
+  for (auto index : methodIndices)
+    testNames.emplace_back(TimingHistory::getTestKey(suiteName, testMethods[index].fullName()));
+  std::vector<std::size_t> sortedIndices;
+  sortedIndices.reserve(methodIndices.size());
+  for (auto position : history->orderLongestFirst(testNames))
+    sortedIndices.push_back(methodIndices[position]);
+  methodIndices = std::move(sortedIndices);
+}
+
 std::string Suite::toPrettyTypeName(const std::type_info &type) {
   // Adapted from Howard Hinnants's implementation in http://stackoverflow.com/a/18369732
   std::string result = type.name();
@@ -11,6 +11,18 @@ TextOutput::TextOutput(const unsigned int outputMode) : TextOutput(outputMode, s
 TextOutput::TextOutput(const unsigned int outputMode, std::ostream &os) : stream(os), mode(outputMode) {}
 TextOutput::~TextOutput() { stream.flush(); }
 
+OutputEvents TextOutput::getConsumedEvents() const {
+  if (mode <= Debug)
+    return OutputEvents::ALL;
+  // failed suites, failed assertions, exceptions, benchmark results and the explicitly enabled performance counters
+  // are always printed
+  auto events = OutputEvents::FINISH_SUITE | OutputEvents::EXCEPTION | OutputEvents::FAILURE |
+                OutputEvents::BENCHMARK | OutputEvents::COMPLEXITY | OutputEvents::PERF_COUNTERS;
+  if (mode <= Verbose)
+    events = events | OutputEvents::INITIALIZE_SUITE | OutputEvents::FINISH_TEST_METHOD;
+  return events;
+}
+
 void TextOutput::initializeSuite(const std::string &suiteName, const unsigned int numTests) {
   if (mode <= Verbose)
     stream << "Running suite '" << suiteName << "' with " << numTests << " tests..." << std::endl;
@@ -32,11 +44,12 @@ void TextOutput::initializeTestMethod(
   ;
 }
 
-void TextOutput::finishTestMethod(
-    const std::string &suiteName, const std::string &methodName, const std::string &argString, const bool withSuccess) {
+void TextOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const bool withSuccess, std::chrono::nanoseconds duration) {
   if (mode <= Debug || (mode <= Verbose && !withSuccess))
     stream << "Test-method '" << methodName << '(' << (argString.empty() ? "" : argString) << ")' finished with "
-           << (withSuccess ? "success!" : "errors!") << std::endl;
+           << (withSuccess ? "success" : "errors") << " in " << Private::formatDuration(duration) << '!'
+           << std::endl;
 }
 
 void TextOutput::printSuccess(const Assertion &assertion) {
@@ -58,10 +71,11 @@ void TextOutput::printFailure(const Assertion &assertion) {
 }
 
 void TextOutput::printException(const std::string &suiteName, const std::string &methodName,
-    const std::string &argString, const std::exception &ex) {
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
   stream << "Test-method '" << methodName << '(' << (argString.empty() ? "" : argString) << ")' failed with exception!"
          << std::endl;
   stream << "\tException: " << ex.what() << std::endl;
+  stream << "\tDuration: " << Private::formatDuration(duration) << std::endl;
   stream << "\tErrno: " << errno << std::endl;
 #ifdef _MSC_VER
   std::array<char, 1024> buffer{};
@@ -72,3 +86,18 @@ void TextOutput::printException(const std::string &suiteName, const std::string
   stream << "\tError: " << strerror(errno) << std::endl;
 #endif
 }
+
+void TextOutput::printBenchmark(const BenchmarkResult &result) {
+  stream << "Benchmark '" << result.method << '(' << result.args << ")': " << Private::formatBenchmark(result)
+         << std::endl;
+}
+
+void TextOutput::printComplexity(const ComplexityResult &result) {
+  stream << "Complexity '" << result.method << "': " << Private::formatComplexity(result) << std::endl;
+  stream << Private::formatComplexityTable(result, "\t") << std::flush;
+}
+
+void TextOutput::printPerfCounters(const PerfCounterResult &result) {
+  stream << "Counters '" << result.method << '(' << result.args << ")': " << Private::formatPerfCounters(result)
+         << std::endl;
+}
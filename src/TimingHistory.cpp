@@ -0,0 +1,203 @@
+#include "TimingHistory.h"
+
+#include "EventStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+using namespace Test;
+
+constexpr double TimingHistory::SMOOTHING_FACTOR;
+
+static std::atomic<TimingHistory *> activeHistory{nullptr};
+
+// "CPTH" followed by the format version
+static const std::string FILE_HEADER{"CPTH\x02", 5};
+// the previous format version, storing the rounded mean and standard deviation
+static const std::string FILE_HEADER_V1{"CPTH\x01", 5};
+
+bool TimingHistory::load(const std::string &fileName) {
+  std::ifstream in(fileName, std::ios_base::in | std::ios_base::binary);
+  if (!in)
+    return false;
+  std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  const bool isVersion1 = content.compare(0, FILE_HEADER_V1.size(), FILE_HEADER_V1) == 0;
+  if (!isVersion1 && content.compare(0, FILE_HEADER.size(), FILE_HEADER) != 0)
+    return false;
+
+  // every entry consists of the length-prefixed name, the average duration in microseconds and variance in square
+  // microseconds as IEEE 754 values (so they do not lose precision across runs) and the varint-encoded number of runs
+  std::unordered_map<std::string, Statistics> entries;
+  const char *data = content.data() + FILE_HEADER.size();
+  const char *end = content.data() + content.size();
+  while (data != end) {
+    uint64_t length = 0;
+    if (!Private::readVarint(data, end, length) || static_cast<uint64_t>(end - data) < length)
+      return false;
+    std::string name(data, static_cast<std::size_t>(length));
+    data += length;
+    Statistics statistics;
+    if (isVersion1) {
+      // the rounded mean and standard deviation, both varint-encoded
+      uint64_t mean = 0;
+      uint64_t deviation = 0;
+      if (!Private::readVarint(data, end, mean) || !Private::readVarint(data, end, deviation))
+        return false;
+      statistics.mean = static_cast<double>(mean);
+      statistics.variance = static_cast<double>(deviation) * static_cast<double>(deviation);
+    } else if (!Private::readDouble(data, end, statistics.mean) ||
+               !Private::readDouble(data, end, statistics.variance)) {
+      return false;
+    }
+    uint64_t numRuns = 0;
+    if (!Private::readVarint(data, end, numRuns))
+      return false;
+    statistics.numRuns = static_cast<uint32_t>(std::min<uint64_t>(numRuns, UINT32_MAX));
+    entries[std::move(name)] = statistics;
+  }
+
+  std::lock_guard<std::mutex> guard(historyMutex);
+  for (auto &entry : entries)
+    durations[entry.first] = entry.second;
+  return true;
+}
+
+void TimingHistory::save(const std::string &fileName) const {
+  std::string content = FILE_HEADER;
+  {
+    std::lock_guard<std::mutex> guard(historyMutex);
+    for (const auto &entry : durations) {
+      Private::appendVarint(content, entry.first.size());
+      content.append(entry.first);
+      Private::appendDouble(content, entry.second.mean);
+      Private::appendDouble(content, entry.second.variance);
+      Private::appendVarint(content, entry.second.numRuns);
+    }
+  }
+  Private::replaceFile(fileName, content, "timing history file");
+}
+
+void TimingHistory::record(const std::string &testName, std::chrono::microseconds duration) {
+  const auto value = static_cast<double>(duration.count());
+  std::lock_guard<std::mutex> guard(historyMutex);
+  Statistics &statistics = durations[testName];
+  if (statistics.numRuns == 0) {
+    statistics.mean = value;
+    statistics.variance = 0.0;
+  } else {
+    // exponentially weighted mean and variance, see "Incremental calculation of weighted mean and variance" by Finch
+    const double difference = value - statistics.mean;
+    const double increment = SMOOTHING_FACTOR * difference;
+    statistics.mean += increment;
+    statistics.variance = (1.0 - SMOOTHING_FACTOR) * (statistics.variance + difference * increment);
+  }
+  if (statistics.numRuns < UINT32_MAX)
+    ++statistics.numRuns;
+}
+
+bool TimingHistory::lookup(const std::string &testName, std::chrono::microseconds &duration) const {
+  Statistics statistics;
+  if (!lookup(testName, statistics))
+    return false;
+  duration = std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(std::llround(statistics.mean))};
+  return true;
+}
+
+bool TimingHistory::lookup(const std::string &testName, Statistics &statistics) const {
+  std::lock_guard<std::mutex> guard(historyMutex);
+  auto it = durations.find(testName);
+  if (it == durations.end())
+    return false;
+  statistics = it->second;
+  return true;
+}
+
+bool TimingHistory::empty() const {
+  std::lock_guard<std::mutex> guard(historyMutex);
+  return durations.empty();
+}
+
+std::vector<std::chrono::microseconds> TimingHistory::estimateDurations(
+    const std::vector<std::string> &testNames) const {
+  std::vector<std::chrono::microseconds> estimates;
+  estimates.reserve(testNames.size());
+  std::lock_guard<std::mutex> guard(historyMutex);
+  double meanDuration = 0.0;
+  for (const auto &entry : durations)
+    meanDuration += entry.second.mean;
+  if (!durations.empty())
+    meanDuration /= static_cast<double>(durations.size());
+  for (const auto &name : testNames) {
+    auto it = durations.find(name);
+    auto duration = std::llround(it != durations.end() ? it->second.mean : meanDuration);
+    // every test-method has some overhead, also this distributes test-methods too fast to measure by their count
+    estimates.emplace_back(std::max<std::chrono::microseconds::rep>(duration, 1));
+  }
+  return estimates;
+}
+
+std::vector<std::size_t> TimingHistory::orderLongestFirst(const std::vector<std::string> &testNames) const {
+  auto estimates = estimateDurations(testNames);
+  std::vector<std::size_t> order(testNames.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+      [&estimates](std::size_t one, std::size_t other) { return estimates[one] > estimates[other]; });
+  return order;
+}
+
+static uint64_t hashName(const std::string &name) {
+  // FNV-1a, other than std::hash this is guaranteed to be the same for all builds and platforms
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::vector<unsigned> TimingHistory::assignShards(const std::vector<std::string> &testNames, unsigned numShards) const {
+  if (numShards == 0)
+    throw std::invalid_argument("Number of shards cannot be zero");
+  std::vector<unsigned> shards(testNames.size(), 0);
+
+  bool anyKnown = false;
+  {
+    std::lock_guard<std::mutex> guard(historyMutex);
+    anyKnown = std::any_of(testNames.begin(), testNames.end(),
+        [this](const std::string &name) { return durations.find(name) != durations.end(); });
+  }
+  if (!anyKnown) {
+    for (std::size_t i = 0; i < testNames.size(); ++i)
+      shards[i] = static_cast<unsigned>(hashName(testNames[i]) % numShards);
+    return shards;
+  }
+
+  // every runner needs to come up with the same assignment, so break ties deterministically by name
+  auto estimates = estimateDurations(testNames);
+  std::vector<std::size_t> order(testNames.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t one, std::size_t other) {
+    if (estimates[one] != estimates[other])
+      return estimates[one] > estimates[other];
+    if (testNames[one] != testNames[other])
+      return testNames[one] < testNames[other];
+    return one < other;
+  });
+
+  std::vector<std::chrono::microseconds> loads(numShards, std::chrono::microseconds::zero());
+  for (std::size_t index : order) {
+    auto shard = static_cast<unsigned>(std::min_element(loads.begin(), loads.end()) - loads.begin());
+    loads[shard] += estimates[index];
+    shards[index] = shard;
+  }
+  return shards;
+}
+
+TimingHistory *TimingHistory::getActive() noexcept { return activeHistory; }
+
+void TimingHistory::setActive(TimingHistory *history) noexcept { activeHistory = history; }
@@ -0,0 +1,129 @@
+#include "TimingReport.h"
+
+#include "Output.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace Test;
+
+static std::atomic<TimingReport *> activeReport{nullptr};
+
+static std::string formatPercentage(double part, double whole) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2) << (whole > 0.0 ? 100.0 * part / whole : 0.0) << '%';
+  return ss.str();
+}
+
+static bool isSlower(const TimingReport::Entry &one, const TimingReport::Entry &other) {
+  return one.duration > other.duration;
+}
+
+double TimingReport::ParallelRun::getEfficiency() const noexcept {
+  if (wallTime.count() <= 0 || numWorkers == 0)
+    return 0.0;
+  return static_cast<double>(busyTime.count()) / (static_cast<double>(wallTime.count()) * numWorkers);
+}
+
+TimingReport::TimingReport(std::size_t slowestCount) : numSlowest(slowestCount), testMethodThreshold(0) {
+  for (auto &duration : phaseDurations)
+    duration = 0;
+}
+
+void TimingReport::recordTestMethod(const std::string &testName, std::chrono::nanoseconds duration) {
+  recordPhase(Phase::TEST_METHOD, duration);
+  if (duration.count() <= testMethodThreshold.load(std::memory_order_relaxed))
+    return;
+  std::lock_guard<std::mutex> guard(reportMutex);
+  insertSlowest(slowestTestMethods, testName, duration);
+  if (slowestTestMethods.size() >= numSlowest && !slowestTestMethods.empty())
+    testMethodThreshold.store(slowestTestMethods.front().duration.count(), std::memory_order_relaxed);
+}
+
+void TimingReport::recordSuite(const std::string &suiteName, std::chrono::nanoseconds duration) {
+  std::lock_guard<std::mutex> guard(reportMutex);
+  insertSlowest(slowestSuites, suiteName, duration);
+}
+
+void TimingReport::recordPhase(Phase phase, std::chrono::nanoseconds duration) noexcept {
+  phaseDurations[static_cast<std::size_t>(phase)].fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+void TimingReport::recordParallelRun(const std::string &suiteName, std::chrono::nanoseconds busyTime,
+    std::chrono::nanoseconds wallTime, unsigned numWorkers) {
+  std::lock_guard<std::mutex> guard(reportMutex);
+  parallelRuns.emplace_back(ParallelRun{suiteName, busyTime, wallTime, numWorkers});
+}
+
+std::vector<TimingReport::Entry> TimingReport::getSlowestTestMethods() const {
+  std::lock_guard<std::mutex> guard(reportMutex);
+  std::vector<Entry> result(slowestTestMethods);
+  std::sort_heap(result.begin(), result.end(), isSlower);
+  return result;
+}
+
+std::vector<TimingReport::Entry> TimingReport::getSlowestSuites() const {
+  std::lock_guard<std::mutex> guard(reportMutex);
+  std::vector<Entry> result(slowestSuites);
+  std::sort_heap(result.begin(), result.end(), isSlower);
+  return result;
+}
+
+std::chrono::nanoseconds TimingReport::getPhaseDuration(Phase phase) const noexcept {
+  return std::chrono::nanoseconds{phaseDurations[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed)};
+}
+
+std::vector<TimingReport::ParallelRun> TimingReport::getParallelRuns() const {
+  std::lock_guard<std::mutex> guard(reportMutex);
+  return parallelRuns;
+}
+
+void TimingReport::print(std::ostream &stream) const {
+  const auto printEntries = [&stream](const std::string &title, const std::vector<Entry> &entries) {
+    stream << "Slowest " << entries.size() << ' ' << title << ':' << std::endl;
+    for (const auto &entry : entries)
+      stream << '\t' << std::setw(12) << Private::formatDuration(entry.duration) << "  " << entry.name << std::endl;
+  };
+  printEntries("test-methods", getSlowestTestMethods());
+  printEntries("suites", getSlowestSuites());
+
+  const std::array<const char *, 3> phaseNames{{"setup()/tear_down()", "before()/after()", "test-methods"}};
+  std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+  for (std::size_t i = 0; i < phaseNames.size(); ++i)
+    total += getPhaseDuration(static_cast<Phase>(i));
+  stream << "Time spent in (summed over all threads):" << std::endl;
+  for (std::size_t i = 0; i < phaseNames.size(); ++i) {
+    const auto duration = getPhaseDuration(static_cast<Phase>(i));
+    stream << '\t' << phaseNames[i] << std::string(20 - std::string(phaseNames[i]).size(), ' ') << std::setw(12)
+           << Private::formatDuration(duration) << " ("
+           << formatPercentage(static_cast<double>(duration.count()), static_cast<double>(total.count())) << ')'
+           << std::endl;
+  }
+
+  const auto runs = getParallelRuns();
+  if (runs.empty())
+    return;
+  stream << "Parallel efficiency:" << std::endl;
+  for (const auto &run : runs)
+    stream << '\t' << run.suiteName << ": " << formatPercentage(run.getEfficiency(), 1.0) << " (busy "
+           << Private::formatDuration(run.busyTime) << ", wall " << Private::formatDuration(run.wallTime) << ", "
+           << run.numWorkers << " workers)" << std::endl;
+}
+
+TimingReport *TimingReport::getActive() noexcept { return activeReport; }
+
+void TimingReport::setActive(TimingReport *report) noexcept { activeReport = report; }
+
+void TimingReport::insertSlowest(std::vector<Entry> &heap, const std::string &name, std::chrono::nanoseconds duration) {
+  if (numSlowest == 0)
+    return;
+  if (heap.size() < numSlowest) {
+    heap.emplace_back(Entry{name, duration});
+    std::push_heap(heap.begin(), heap.end(), isSlower);
+  } else if (duration > heap.front().duration) {
+    std::pop_heap(heap.begin(), heap.end(), isSlower);
+    heap.back() = Entry{name, duration};
+    std::push_heap(heap.begin(), heap.end(), isSlower);
+  }
+}
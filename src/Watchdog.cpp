@@ -0,0 +1,106 @@
+#include "Watchdog.h"
+
+#include <atomic>
+#include <cstdlib>
+
+using namespace Test;
+
+static std::atomic<std::chrono::milliseconds::rep> defaultTimeout{0};
+static std::mutex abortHandlerMutex;
+static Watchdog::Callback abortHandler;
+
+Watchdog::Watchdog() : nextHandle(1), runningHandle(0), shutdown(false) {}
+
+Watchdog::~Watchdog() noexcept {
+  {
+    std::lock_guard<std::mutex> guard(watchdogMutex);
+    shutdown = true;
+  }
+  changed.notify_all();
+  if (thread.joinable())
+    thread.join();
+}
+
+Watchdog::Handle Watchdog::watch(std::chrono::steady_clock::time_point deadline, Callback &&onExpiry) {
+  Handle handle = 0;
+  {
+    std::lock_guard<std::mutex> guard(watchdogMutex);
+    if (!thread.joinable())
+      thread = std::thread(&Watchdog::runWatchdog, this);
+    handle = nextHandle++;
+    deadlines.emplace(deadline, Entry{handle, std::move(onExpiry)});
+  }
+  changed.notify_all();
+  return handle;
+}
+
+void Watchdog::cancel(Handle handle) {
+  std::unique_lock<std::mutex> lock(watchdogMutex);
+  for (auto it = deadlines.begin(); it != deadlines.end(); ++it) {
+    if (it->second.handle == handle) {
+      deadlines.erase(it);
+      // no need to wake up the watchdog, it handles a spurious expiry of the removed deadline
+      return;
+    }
+  }
+  // the deadline already expired, make sure its callback is not running anymore
+  if (runningHandle == handle && std::this_thread::get_id() != thread.get_id())
+    callbackDone.wait(lock, [this, handle]() { return runningHandle != handle; });
+}
+
+Watchdog &Watchdog::getDefault() {
+  static Watchdog watchdog;
+  return watchdog;
+}
+
+void Watchdog::setDefaultTimeout(std::chrono::milliseconds timeout) noexcept { defaultTimeout = timeout.count(); }
+
+std::chrono::milliseconds Watchdog::getDefaultTimeout() noexcept { return std::chrono::milliseconds{defaultTimeout}; }
+
+void Watchdog::setAbortHandler(Callback &&handler) {
+  std::lock_guard<std::mutex> guard(abortHandlerMutex);
+  abortHandler = std::move(handler);
+}
+
+void Watchdog::abortProgram() noexcept {
+  Callback handler;
+  {
+    std::lock_guard<std::mutex> guard(abortHandlerMutex);
+    handler = abortHandler;
+  }
+  if (handler) {
+    try {
+      handler();
+    } catch (...) {
+      // the program is terminated anyway
+    }
+  }
+  std::_Exit(EXIT_FAILURE);
+}
+
+void Watchdog::runWatchdog() {
+  std::unique_lock<std::mutex> lock(watchdogMutex);
+  while (!shutdown) {
+    if (deadlines.empty()) {
+      changed.wait(lock);
+      continue;
+    }
+    auto next = deadlines.begin();
+    if (std::chrono::steady_clock::now() < next->first) {
+      changed.wait_until(lock, next->first);
+      continue;
+    }
+    Entry entry = std::move(next->second);
+    deadlines.erase(next);
+    runningHandle = entry.handle;
+    lock.unlock();
+    try {
+      entry.callback();
+    } catch (...) {
+      // an exception must not terminate the watchdog and with it the whole program
+    }
+    lock.lock();
+    runningHandle = 0;
+    callbackDone.notify_all();
+  }
+}
@@ -0,0 +1,355 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace Test;
+
+static std::atomic<unsigned> defaultConcurrency{0};
+static std::mutex defaultPoolMutex;
+static std::unique_ptr<WorkerPool> defaultPool;
+
+// the pool and queue index of the current thread, if it is a worker thread
+static thread_local const WorkerPool *currentPool = nullptr;
+static thread_local unsigned currentQueue = 0;
+// the number of nested calls to wait() of the current worker thread
+static thread_local unsigned waitDepth = 0;
+
+struct WorkerPool::Gang {
+  const std::function<void(unsigned index)> &function;
+  const unsigned numThreads;
+  // the members arrived at the barrier
+  unsigned numArrived;
+  // the members (joined or reserved) which have not finished yet
+  unsigned numPending;
+  // set if a reserved worker cannot join anymore
+  bool cancelled;
+  std::exception_ptr firstError;
+  std::condition_variable changed;
+};
+
+WorkerPool::WorkerPool(unsigned numWorkers)
+    : queuedTasks(0), nextQueue(0), shutdown(false), activeGang(nullptr), numReservedWorkers(0),
+      numWaitingWorkers(0) {
+  if (numWorkers == 0)
+    numWorkers = std::thread::hardware_concurrency();
+  if (numWorkers == 0)
+    numWorkers = 1;
+  workerStates.assign(numWorkers, WorkerState{false, false, false, 0});
+  queues.reserve(numWorkers);
+  for (unsigned i = 0; i < numWorkers; ++i)
+    queues.emplace_back(new WorkQueue());
+  workers.reserve(numWorkers);
+  for (unsigned i = 0; i < numWorkers; ++i)
+    workers.emplace_back(&WorkerPool::runWorker, this, i);
+}
+
+WorkerPool::~WorkerPool() noexcept {
+  {
+    std::lock_guard<std::mutex> guard(sleepMutex);
+    shutdown = true;
+  }
+  wakeUp.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+void WorkerPool::submit(TaskGroup &group, Task &&task) {
+  ++group.pendingTasks;
+  unsigned index = isWorkerThread() ? currentQueue : (nextQueue++ % static_cast<unsigned>(queues.size()));
+  {
+    // the group may be destroyed as soon as its last task finished, so notify a worker waiting for the group to help
+    // running the new task while holding the lock
+    std::lock_guard<std::mutex> groupGuard(group.groupMutex);
+    {
+      std::lock_guard<std::mutex> guard(queues[index]->queueMutex);
+      queues[index]->tasks.push_back(QueuedTask{std::move(task), &group});
+      ++group.queuedTasks;
+    }
+    ++queuedTasks;
+    group.groupDone.notify_all();
+  }
+  {
+    // acquire the lock to not lose the wake-up of a worker which is just about to go to sleep
+    std::lock_guard<std::mutex> guard(sleepMutex);
+  }
+  wakeUp.notify_one();
+}
+
+void WorkerPool::wait(TaskGroup &group) {
+  if (isWorkerThread()) {
+    if (waitDepth++ == 0)
+      setWaiting(currentQueue, true);
+    // help executing tasks instead of blocking this worker
+    while (group.pendingTasks != 0) {
+      if (!tryRunTask(currentQueue, &group)) {
+        // the remaining tasks of the group run on other workers, sleep until they finish or a new task is submitted
+        std::unique_lock<std::mutex> lock(group.groupMutex);
+        group.groupDone.wait(lock, [&group]() { return group.pendingTasks == 0 || group.queuedTasks != 0; });
+      }
+    }
+    if (--waitDepth == 0)
+      setWaiting(currentQueue, false);
+  } else {
+    std::unique_lock<std::mutex> lock(group.groupMutex);
+    group.groupDone.wait(lock, [&group]() { return group.pendingTasks == 0; });
+  }
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> guard(group.groupMutex);
+    std::swap(error, group.firstError);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void WorkerPool::runGang(unsigned numThreads, const std::function<void(unsigned index)> &function) {
+  if (numThreads == 0 || numThreads > getNumWorkers())
+    throw std::invalid_argument("Cannot run " + std::to_string(numThreads) + " threads at once on a pool with " +
+                                std::to_string(getNumWorkers()) + " workers");
+  const bool takePart = isWorkerThread();
+  Gang gang{function, numThreads, 0, numThreads, false, nullptr, {}};
+  {
+    std::lock_guard<std::mutex> guard(sleepMutex);
+    if (activeGang)
+      throw std::runtime_error("Cannot run " + std::to_string(numThreads) +
+                               " threads at once while another gang is running on the pool");
+    // reserve all members at once, so the availability cannot change in between
+    std::vector<unsigned> candidates;
+    for (unsigned worker = 0; worker < workerStates.size(); ++worker) {
+      if (!workerStates[worker].waiting && !(takePart && worker == currentQueue))
+        candidates.push_back(worker);
+    }
+    std::stable_partition(candidates.begin(), candidates.end(),
+        [this](unsigned worker) { return workerStates[worker].idle; });
+    const unsigned numReserved = takePart ? numThreads - 1 : numThreads;
+    if (candidates.size() < numReserved)
+      throw std::runtime_error("Cannot run " + std::to_string(numThreads) + " threads at once, only " +
+                               std::to_string(candidates.size() + (takePart ? 1 : 0)) +
+                               " workers are not waiting for other tasks");
+    for (unsigned member = 0; member < numReserved; ++member) {
+      WorkerState &state = workerStates[candidates[member]];
+      state.reserved = true;
+      state.gangIndex = numThreads - numReserved + member;
+    }
+    numReservedWorkers += numReserved;
+    activeGang = &gang;
+  }
+  wakeUp.notify_all();
+  if (takePart)
+    runGangMember(gang, 0);
+
+  std::exception_ptr error;
+  bool cancelled = false;
+  {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    gang.changed.wait(lock, [&gang]() { return gang.numPending == 0; });
+    activeGang = nullptr;
+    cancelled = gang.cancelled;
+    error = gang.firstError;
+  }
+  if (cancelled)
+    throw std::runtime_error("Cannot run " + std::to_string(numThreads) +
+                             " threads at once, a reserved worker started waiting for other tasks");
+  if (error)
+    std::rethrow_exception(error);
+}
+
+bool WorkerPool::isWorkerThread() const noexcept { return currentPool == this; }
+
+WorkerPool &WorkerPool::getDefault() {
+  std::lock_guard<std::mutex> guard(defaultPoolMutex);
+  if (!defaultPool)
+    defaultPool.reset(new WorkerPool(defaultConcurrency));
+  return *defaultPool;
+}
+
+void WorkerPool::abandonDefault() noexcept {
+  // the pool can neither run tasks nor join its worker threads in the child process, so leak it
+  static_cast<void>(defaultPool.release());
+}
+
+void WorkerPool::setDefaultConcurrency(unsigned numWorkers) { defaultConcurrency = numWorkers; }
+
+unsigned WorkerPool::getDefaultConcurrency() noexcept {
+  unsigned numWorkers = defaultConcurrency;
+  if (numWorkers == 0)
+    numWorkers = std::thread::hardware_concurrency();
+  return numWorkers == 0 ? 1 : numWorkers;
+}
+
+void WorkerPool::runWorker(unsigned index) {
+  currentPool = this;
+  currentQueue = index;
+  while (true) {
+    if (numReservedWorkers != 0 && joinReservedGang(index))
+      continue;
+    if (tryRunTask(index))
+      continue;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    WorkerState &state = workerStates[index];
+    state.idle = true;
+    wakeUp.wait(lock, [this, &state]() { return shutdown || queuedTasks != 0 || state.reserved; });
+    state.idle = false;
+    if (shutdown && queuedTasks == 0)
+      return;
+  }
+}
+
+bool WorkerPool::tryRunTask(unsigned preferredQueue, const TaskGroup *awaitedGroup) {
+  QueuedTask task;
+  if (!takeTask(preferredQueue, awaitedGroup, task))
+    return false;
+  std::exception_ptr error;
+  try {
+    task.task();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  finishTask(*task.group, error);
+  return true;
+}
+
+bool WorkerPool::takeTask(unsigned preferredQueue, const TaskGroup *awaitedGroup, QueuedTask &task) {
+  if (queuedTasks == 0)
+    return false;
+  // while waiting for a group, only help with its tasks. Any other task would run nested within the task waiting for
+  // the group (e.g. a test-method within another test-method) and could delay the completion of the group
+  if (awaitedGroup != nullptr)
+    return takeGroupTask(*awaitedGroup, preferredQueue, task);
+  // take the oldest task of our own queue
+  {
+    WorkQueue &queue = *queues[preferredQueue];
+    std::lock_guard<std::mutex> guard(queue.queueMutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      --task.group->queuedTasks;
+      --queuedTasks;
+      return true;
+    }
+  }
+  // steal the newest task of any other queue
+  for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+    WorkQueue &queue = *queues[(preferredQueue + offset) % queues.size()];
+    std::lock_guard<std::mutex> guard(queue.queueMutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      --task.group->queuedTasks;
+      --queuedTasks;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkerPool::takeGroupTask(const TaskGroup &group, unsigned preferredQueue, QueuedTask &task) {
+  if (group.queuedTasks == 0)
+    return false;
+  auto isGroupTask = [&group](const QueuedTask &queuedTask) { return queuedTask.group == &group; };
+  // the tasks of the group are usually submitted by this worker and therefore in its own queue, take the oldest one
+  {
+    WorkQueue &queue = *queues[preferredQueue];
+    std::lock_guard<std::mutex> guard(queue.queueMutex);
+    auto it = std::find_if(queue.tasks.begin(), queue.tasks.end(), isGroupTask);
+    if (it != queue.tasks.end()) {
+      task = std::move(*it);
+      queue.tasks.erase(it);
+      --task.group->queuedTasks;
+      --queuedTasks;
+      return true;
+    }
+  }
+  // steal the newest task of the group from any other queue
+  for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+    WorkQueue &queue = *queues[(preferredQueue + offset) % queues.size()];
+    std::lock_guard<std::mutex> guard(queue.queueMutex);
+    auto it = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(), isGroupTask);
+    if (it != queue.tasks.rend()) {
+      task = std::move(*it);
+      queue.tasks.erase(std::next(it).base());
+      --task.group->queuedTasks;
+      --queuedTasks;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::setWaiting(unsigned worker, bool waiting) {
+  std::lock_guard<std::mutex> guard(sleepMutex);
+  WorkerState &state = workerStates[worker];
+  state.waiting = waiting;
+  if (waiting)
+    ++numWaitingWorkers;
+  else
+    --numWaitingWorkers;
+  if (waiting && state.reserved) {
+    // this worker only runs the tasks of the awaited group from now on and would never join the gang, so cancel the
+    // gang: the reserved workers are released and the members at the barrier return without running the function
+    Gang &gang = *activeGang;
+    gang.cancelled = true;
+    for (auto &other : workerStates) {
+      if (other.reserved) {
+        other.reserved = false;
+        --numReservedWorkers;
+        --gang.numPending;
+      }
+    }
+    gang.changed.notify_all();
+  }
+}
+
+bool WorkerPool::joinReservedGang(unsigned worker) {
+  Gang *gang = nullptr;
+  unsigned index = 0;
+  {
+    std::lock_guard<std::mutex> guard(sleepMutex);
+    WorkerState &state = workerStates[worker];
+    if (!state.reserved)
+      return false;
+    state.reserved = false;
+    --numReservedWorkers;
+    gang = activeGang;
+    index = state.gangIndex;
+  }
+  runGangMember(*gang, index);
+  return true;
+}
+
+void WorkerPool::runGangMember(Gang &gang, unsigned index) {
+  {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    if (++gang.numArrived == gang.numThreads)
+      gang.changed.notify_all();
+    gang.changed.wait(lock, [&gang]() { return gang.cancelled || gang.numArrived == gang.numThreads; });
+    if (gang.cancelled) {
+      if (--gang.numPending == 0)
+        gang.changed.notify_all();
+      return;
+    }
+  }
+  std::exception_ptr error;
+  try {
+    gang.function(index);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  std::lock_guard<std::mutex> guard(sleepMutex);
+  if (error && !gang.firstError)
+    gang.firstError = error;
+  // the gang is destroyed once the last member finished, so notify while holding the lock
+  if (--gang.numPending == 0)
+    gang.changed.notify_all();
+}
+
+void WorkerPool::finishTask(TaskGroup &group, std::exception_ptr error) {
+  std::lock_guard<std::mutex> guard(group.groupMutex);
+  if (error && !group.firstError)
+    group.firstError = error;
+  if (--group.pendingTasks == 0)
+    group.groupDone.notify_all();
+}
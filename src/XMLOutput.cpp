@@ -1,19 +1,28 @@
 #include "XMLOutput.h"
 
 #include <algorithm>
-#include <ctime>
+#include <climits>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
+#include <locale>
+#include <sstream>
 
 using namespace Test;
 
-XMLOutput::XMLOutput(std::ostream &stream) : output(stream) { output << "<?xml version=\"1.0\" ?>\n<testsuites>\n"; }
+XMLOutput::XMLOutput(std::ostream &stream)
+    : output(stream), seekable(false), nextSuiteId(0), streamingSuite(nullptr) {
+  output << "<?xml version=\"1.0\" ?>\n<testsuites>\n";
+}
 
-XMLOutput::XMLOutput(const std::string &outputFile) : fileStream(new std::ofstream(outputFile)), output(*fileStream) {
+XMLOutput::XMLOutput(const std::string &outputFile)
+    : fileStream(new std::ofstream(outputFile)), output(*fileStream), seekable(true), nextSuiteId(0),
+      streamingSuite(nullptr) {
   output << "<?xml version=\"1.0\" ?>\n<testsuites>\n";
 }
 
 XMLOutput::~XMLOutput() noexcept {
+  output << pendingSuites;
   output << "</testsuites>\n";
   output.flush();
 }
@@ -36,49 +45,280 @@ static std::string escapeXML(std::string text) {
   return text;
 }
 
-void XMLOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
-    std::chrono::microseconds totalDuration) {
-  CollectorOutput::finishSuite(suiteName, numTests, numPositiveTests, totalDuration);
-
-  std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+// the opening <testsuite> element without the closing '>'
+static std::string toSuiteHeader(const std::string &suiteName, unsigned numTests, unsigned numFailures,
+    unsigned numErrors, std::chrono::microseconds totalDuration, std::time_t startTime) {
   std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(totalDuration);
-  std::chrono::microseconds remainder = totalDuration - seconds;
-  unsigned numErrors = static_cast<unsigned>(std::count_if(currentSuite->methods.begin(), currentSuite->methods.end(),
-      [](const TestMethodInfo &method) { return !method.exceptionMessage.empty(); }));
+  std::chrono::milliseconds remainder = std::chrono::duration_cast<std::chrono::milliseconds>(totalDuration - seconds);
 #ifdef _MSC_VER
   struct tm tmp {};
-  gmtime_s(&tmp, &now);
+  gmtime_s(&tmp, &startTime);
   auto time = &tmp;
 #else
-  auto time = gmtime(&now);
+  auto time = gmtime(&startTime);
 #endif
-  output << "\t<testsuite name=\"" << escapeXML(suiteName) << "\" tests=\"" << numTests << "\" failures=\""
-         << (numTests - numPositiveTests - numErrors) << "\" errors=\"" << numErrors << "\" time=\"" << seconds.count()
-         << '.' << std::setfill('0') << std::setw(3) << remainder.count() << "\" timestamp=\""
-         << std::put_time(time, "%FT%T") << "\">\n";
-
-  for (const TestMethodInfo &method : currentSuite->methods) {
-    std::string name = stripMethodName(method.methodName);
-    if (!method.argString.empty())
-      name.append("(" + method.argString + ")");
-    output << "\t\t<testcase classname=\"" << escapeXML(suiteName) << "\" name=\"" << escapeXML(name) << "\">\n";
-    if (!method.exceptionMessage.empty())
-      output << "\t\t\t<error message=\"" << escapeXML(method.exceptionMessage) << "\" type=\"\"/>\n";
-    else if (method.failedAssertions.empty() && method.passedAssertions.empty())
-      output << "\t\t\t<skipped message=\"Test case has no assertions\" type=\"\"/>\n";
-    else if (!method.failedAssertions.empty()) {
-      for (const Assertion &assertion : method.failedAssertions) {
-        output << "\t\t\t<failure message=\""
-               << (assertion.errorMessage.empty() ? "Failure" : escapeXML(assertion.errorMessage)) << "\" type=\"\">\n";
-        output << "\t\t\t\tFile: " << escapeXML(Private::getFileName(assertion.file)) << '\n';
-        output << "\t\t\t\tLine: " << assertion.lineNumber << '\n';
-        if (!assertion.userMessage.empty())
-          output << "\t\t\t\tMessage: " << escapeXML(assertion.userMessage) << '\n';
-        output << "\t\t\t</failure>\n";
-      }
-    }
-    output << "\t\t</testcase>\n";
+  std::stringstream ss;
+  ss << "\t<testsuite name=\"" << escapeXML(suiteName) << "\" tests=\"" << numTests << "\" failures=\"" << numFailures
+     << "\" errors=\"" << numErrors << "\" time=\"" << seconds.count() << '.' << std::setfill('0') << std::setw(3)
+     << remainder.count() << "\" timestamp=\"" << std::put_time(time, "%FT%T") << '"';
+  return ss.str();
+}
+
+void XMLOutput::initializeSuite(const std::string &suiteName, unsigned int numTests) {
+  runningSuites.push_back(
+      SuiteInfo{nextSuiteId++, suiteName, std::this_thread::get_id(), std::time(nullptr), 0, -1, ""});
+  // the vector might have been reallocated
+  streamingSuite = nullptr;
+  for (auto &suite : runningSuites) {
+    if (suite.headerPosition >= 0)
+      streamingSuite = &suite;
+  }
+  if (streamingSuite || runningSuites.size() > 1)
+    // another suite is written while running
+    return;
+
+  SuiteInfo &suite = runningSuites.back();
+  const std::streamoff position = seekable ? static_cast<std::streamoff>(output.tellp()) : -1;
+  if (position < 0)
+    // not seekable, the suite is written once it finished
+    return;
+  // reserve space for the largest possible values
+  const std::string placeholder =
+      toSuiteHeader(suiteName, UINT_MAX, UINT_MAX, UINT_MAX, std::chrono::hours{24 * 365 * 1000}, suite.startTime);
+  output << placeholder << std::string(8, ' ') << ">\n";
+  suite.headerPosition = position;
+  streamingSuite = &suite;
+}
+
+void XMLOutput::finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+    std::chrono::microseconds totalDuration) {
+  SuiteInfo *suite = findSuite(suiteName);
+  if (!suite)
+    return;
+  const std::string header = toSuiteHeader(
+      suiteName, numTests, numTests - numPositiveTests - suite->numErrors, suite->numErrors, totalDuration,
+      suite->startTime);
+  if (suite == streamingSuite) {
+    output << "\t</testsuite>\n";
+    // patch the attributes into the placeholder, the remaining space is filled with whitespace between the attributes
+    const std::streamoff end = output.tellp();
+    const std::string placeholder =
+        toSuiteHeader(suiteName, UINT_MAX, UINT_MAX, UINT_MAX, std::chrono::hours{24 * 365 * 1000}, suite->startTime);
+    output.seekp(suite->headerPosition);
+    output << header << std::string(placeholder.size() + 8 - header.size(), ' ');
+    output.seekp(end);
+    streamingSuite = nullptr;
+    // the suites finished in the meantime
+    output << pendingSuites;
+    pendingSuites.clear();
+  } else {
+    std::string element = header + ">\n" + suite->testCases + "\t</testsuite>\n";
+    if (streamingSuite)
+      pendingSuites.append(element);
+    else
+      output << element;
+  }
+  runningSuites.erase(runningSuites.begin() + (suite - runningSuites.data()));
+  // the vector elements were moved
+  streamingSuite = nullptr;
+  for (auto &running : runningSuites) {
+    if (running.headerPosition >= 0)
+      streamingSuite = &running;
   }
+}
+
+void XMLOutput::initializeTestMethod(
+    const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+  const SuiteInfo *suite = findSuite(suiteName);
+  std::string name = stripMethodName(methodName);
+  if (!argString.empty())
+    name.append("(" + argString + ")");
+  runningMethods[std::make_pair(std::this_thread::get_id(), internTest(suiteName, methodName, argString))] =
+      MethodInfo{suite ? suite->id : UINT64_MAX, std::move(name), "", "", "", "", 0, std::chrono::nanoseconds::zero()};
+}
+
+void XMLOutput::finishTestMethod(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, bool withSuccess, std::chrono::nanoseconds duration) {
+  const TestId test = internTest(suiteName, methodName, argString);
+  auto it = runningMethods.find(std::make_pair(std::this_thread::get_id(), test));
+  if (it == runningMethods.end())
+    return;
+  it->second.duration = duration;
+  writeTestCase(suiteName, it->second);
+  runningMethods.erase(it);
+}
+
+void XMLOutput::printException(const std::string &suiteName, const std::string &methodName,
+    const std::string &argString, const std::exception &ex, std::chrono::nanoseconds duration) {
+  const TestId test = internTest(suiteName, methodName, argString);
+  auto it = runningMethods.find(std::make_pair(std::this_thread::get_id(), test));
+  if (it == runningMethods.end()) {
+    // reported from another thread, e.g. by the watchdog aborting the test-method
+    it = std::find_if(runningMethods.begin(), runningMethods.end(),
+        [test](const std::pair<const std::pair<std::thread::id, TestId>, MethodInfo> &running) {
+          return running.first.second == test;
+        });
+  }
+  if (it == runningMethods.end())
+    return;
+  it->second.exceptionMessage = ex.what();
+  it->second.duration = duration;
+  // finishTestMethod is skipped for this test-method
+  writeTestCase(suiteName, it->second);
+  runningMethods.erase(it);
+}
+
+void XMLOutput::printSuccess(const Assertion &assertion) {
+  if (MethodInfo *method = findMethod(internTest(assertion.suite, assertion.method, assertion.args)))
+    ++method->numAssertions;
+}
+
+void XMLOutput::printSuccessEvent(const AssertionEvent &event) {
+  if (MethodInfo *method = findMethod(event.test))
+    ++method->numAssertions;
+}
+
+void XMLOutput::printFailure(const Assertion &assertion) {
+  MethodInfo *found = findMethod(internTest(assertion.suite, assertion.method, assertion.args));
+  if (!found)
+    return;
+  MethodInfo &method = *found;
+  ++method.numAssertions;
+  method.failures.append("\t\t\t<failure message=\"")
+      .append(assertion.errorMessage.empty() ? "Failure" : escapeXML(assertion.errorMessage))
+      .append("\" type=\"\">\n");
+  method.failures.append("\t\t\t\tFile: ").append(escapeXML(Private::getFileName(assertion.file))).append("\n");
+  method.failures.append("\t\t\t\tLine: ").append(std::to_string(assertion.lineNumber)).append("\n");
+  if (!assertion.userMessage.empty())
+    method.failures.append("\t\t\t\tMessage: ").append(escapeXML(assertion.userMessage)).append("\n");
+  method.failures.append("\t\t\t</failure>\n");
+}
+
+void XMLOutput::printBenchmark(const BenchmarkResult &result) {
+  MethodInfo *method = findMethod(internTest(result.suite, result.method, result.args));
+  if (!method)
+    return;
+  std::stringstream ss;
+  ss.imbue(std::locale::classic());
+  ss << std::fixed << std::setprecision(3);
+  const auto writeProperty = [&ss](const char *name, double value) {
+    ss << "\t\t\t\t<property name=\"benchmark." << name << "\" value=\"" << value << "\"/>\n";
+  };
+  ss << "\t\t\t\t<property name=\"benchmark.iterations\" value=\"" << result.iterations << "\"/>\n";
+  ss << "\t\t\t\t<property name=\"benchmark.repetitions\" value=\"" << result.repetitions << "\"/>\n";
+  writeProperty("min_ns", result.minimum);
+  writeProperty("median_ns", result.median);
+  writeProperty("mean_ns", result.mean);
+  writeProperty("stddev_ns", result.standardDeviation);
+  writeProperty("p99_ns", result.percentile99);
+  if (result.threads > 1) {
+    ss << "\t\t\t\t<property name=\"benchmark.threads\" value=\"" << result.threads << "\"/>\n";
+    writeProperty("ops_per_second", result.getIterationsPerSecond());
+    if (result.scalingEfficiency > 0.0)
+      writeProperty("scaling_efficiency", result.scalingEfficiency);
+  }
+  if (result.bytesPerIteration != 0)
+    writeProperty("bytes_per_second", result.getBytesPerSecond());
+  if (result.itemsPerIteration != 0)
+    writeProperty("items_per_second", result.getItemsPerSecond());
+  method->properties.append(ss.str());
+}
+
+void XMLOutput::printComplexity(const ComplexityResult &result) {
+  MethodInfo *method = findMethod(internTest(result.suite, result.method, result.args));
+  if (!method)
+    return;
+  std::stringstream ss;
+  ss.imbue(std::locale::classic());
+  ss << "\t\t\t\t<property name=\"benchmark.complexity\" value=\"" << toString(result.complexity) << "\"/>\n";
+  ss << "\t\t\t\t<property name=\"benchmark.complexity_coefficient_ns\" value=\"" << std::setprecision(6)
+     << result.coefficient << "\"/>\n";
+  ss << "\t\t\t\t<property name=\"benchmark.complexity_rms\" value=\"" << std::fixed << std::setprecision(3)
+     << result.rms << "\"/>\n";
+  method->properties.append(ss.str());
+}
+
+void XMLOutput::printPerfCounters(const PerfCounterResult &result) {
+  MethodInfo *method = findMethod(internTest(result.suite, result.method, result.args));
+  if (!method)
+    return;
+  std::stringstream ss;
+  ss.imbue(std::locale::classic());
+  ss << std::fixed;
+  const auto writeProperty = [&ss](const char *name, double value, int precision) {
+    ss << "\t\t\t\t<property name=\"perf." << name << "\" value=\"" << std::setprecision(precision) << value
+       << "\"/>\n";
+  };
+  const auto writeCount = [&ss](const char *name, uint64_t value) {
+    ss << "\t\t\t\t<property name=\"perf." << name << "\" value=\"" << value << "\"/>\n";
+  };
+  if (result.has(PerfCounter::INSTRUCTIONS) && result.has(PerfCounter::CYCLES)) {
+    writeCount("cycles", result.get(PerfCounter::CYCLES));
+    writeCount("instructions", result.get(PerfCounter::INSTRUCTIONS));
+    writeProperty("ipc", result.getInstructionsPerCycle(), 3);
+  }
+  if (result.has(PerfCounter::BRANCH_MISSES) && result.has(PerfCounter::BRANCHES))
+    writeProperty("branch_miss_rate", result.getBranchMissRate(), 6);
+  if (result.has(PerfCounter::L1D_READ_MISSES) && result.has(PerfCounter::L1D_READS))
+    writeProperty("l1d_miss_rate", result.getL1DMissRate(), 6);
+  if (result.has(PerfCounter::LLC_MISSES) && result.has(PerfCounter::LLC_REFERENCES))
+    writeProperty("llc_miss_rate", result.getLLCMissRate(), 6);
+  if (result.has(PerfCounter::CONTEXT_SWITCHES))
+    writeCount("context_switches", result.get(PerfCounter::CONTEXT_SWITCHES));
+  method->counterProperties.append(ss.str());
+}
+
+void XMLOutput::flush() { output.flush(); }
+
+XMLOutput::SuiteInfo *XMLOutput::findSuite(const std::string &suiteName) {
+  // the innermost run of the suite started on this thread, or else the run started last
+  const auto thread = std::this_thread::get_id();
+  auto it = std::find_if(runningSuites.rbegin(), runningSuites.rend(),
+      [&](const SuiteInfo &suite) { return suite.suiteName == suiteName && suite.thread == thread; });
+  if (it == runningSuites.rend())
+    it = std::find_if(runningSuites.rbegin(), runningSuites.rend(),
+        [&suiteName](const SuiteInfo &suite) { return suite.suiteName == suiteName; });
+  return it == runningSuites.rend() ? nullptr : &*it;
+}
+
+XMLOutput::MethodInfo *XMLOutput::findMethod(TestId test) {
+  auto it = runningMethods.find(std::make_pair(std::this_thread::get_id(), test));
+  if (it != runningMethods.end())
+    return &it->second;
+  // reported from another thread, e.g. by a benchmark thread or the watchdog
+  for (auto &running : runningMethods) {
+    if (running.first.second == test)
+      return &running.second;
+  }
+  return nullptr;
+}
+
+void XMLOutput::writeTestCase(const std::string &suiteName, const MethodInfo &method) {
+  auto found = std::find_if(runningSuites.begin(), runningSuites.end(),
+      [&method](const SuiteInfo &suite) { return suite.id == method.suiteId; });
+  SuiteInfo *suite = found == runningSuites.end() ? nullptr : &*found;
+  std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(method.duration);
+  std::stringstream ss;
+  ss << "\t\t<testcase classname=\"" << escapeXML(suiteName) << "\" name=\"" << escapeXML(method.name) << "\" time=\""
+     << seconds.count() << '.' << std::setfill('0') << std::setw(9) << (method.duration - seconds).count() << "\">\n";
+  std::string element = ss.str();
+  if (!method.properties.empty() || !method.counterProperties.empty())
+    element.append("\t\t\t<properties>\n")
+        .append(method.properties)
+        .append(method.counterProperties)
+        .append("\t\t\t</properties>\n");
+  if (!method.exceptionMessage.empty()) {
+    element.append("\t\t\t<error message=\"").append(escapeXML(method.exceptionMessage)).append("\" type=\"\"/>\n");
+    if (suite)
+      ++suite->numErrors;
+  } else if (method.numAssertions == 0 && method.properties.empty())
+    element.append("\t\t\t<skipped message=\"Test case has no assertions\" type=\"\"/>\n");
+  else
+    element.append(method.failures);
+  element.append("\t\t</testcase>\n");
 
-  output << "\t</testsuite>\n";
+  if (suite && suite == streamingSuite)
+    output << element;
+  else if (suite)
+    suite->testCases.append(element);
 }
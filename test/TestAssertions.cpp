@@ -8,6 +8,9 @@ struct OtherComparableType {
   friend bool operator==(const OneComparableType &, const OtherComparableType &) noexcept { return true; }
   friend std::ostream &operator<<(std::ostream &os, const OtherComparableType &) { return os << "other"; }
 };
+struct StringConvertibleType {
+  operator std::string() const { return "Foo"; }
+};
 
 TestAssertions::TestAssertions() {
   TEST_ADD(TestAssertions::testAssertBoolean);
@@ -31,6 +34,8 @@ void TestAssertions::testAssertEquals() {
   TEST_ASSERT_EQUALS(1, 1);
   TEST_ASSERT_EQUALS(nullptr, nullptr);
   TEST_STRING_EQUALS("Foo", "Foo");
+  TEST_STRING_EQUALS("Foo", StringConvertibleType{});
+  TEST_STRING_EQUALS(StringConvertibleType{}, std::string("Foo"));
   TEST_ASSERT_EQUALS(1.0f, 1.0f);
 
   OneComparableType one{};
@@ -0,0 +1,609 @@
+#include "TestBenchmarkSuite.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Test;
+
+ExampleBenchmarks::ExampleBenchmarks() : Test::BenchmarkSuite("ExampleBenchmarks") {
+  BenchmarkOptions options;
+  // keep the test run short
+  options.minTime = std::chrono::milliseconds{1};
+  options.repetitions = 5;
+  setBenchmarkOptions(options);
+  TEST_BENCHMARK(ExampleBenchmarks::benchmarkAccumulate);
+  TEST_BENCHMARK(ExampleBenchmarks::benchmarkCopy);
+  TEST_BENCHMARK(ExampleBenchmarks::benchmarkKeepRunning);
+}
+
+void ExampleBenchmarks::benchmarkAccumulate(BenchmarkState &state) {
+  std::vector<int> values(256);
+  std::iota(values.begin(), values.end(), 0);
+  for (auto _ : state)
+    doNotOptimize(std::accumulate(values.begin(), values.end(), 0));
+  state.setItemsPerIteration(values.size());
+}
+
+void ExampleBenchmarks::benchmarkCopy(BenchmarkState &state) {
+  const std::string source(4096, 'x');
+  std::string destination;
+  for (auto _ : state) {
+    destination = source;
+    doNotOptimize(destination);
+  }
+  state.setBytesPerIteration(source.size());
+  TEST_ASSERT_EQUALS(source, destination);
+}
+
+void ExampleBenchmarks::benchmarkKeepRunning(BenchmarkState &state) {
+  uint64_t counter = 0;
+  while (state.keepRunning())
+    doNotOptimize(++counter);
+  TEST_ASSERT_EQUALS(state.getIterations(), counter);
+}
+
+namespace {
+  class BenchmarkRecorder : public Output {
+  public:
+    void printBenchmark(const BenchmarkResult &result) override { results.push_back(result); }
+    void printComplexity(const ComplexityResult &result) override { complexities.push_back(result); }
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override {
+      exceptions.emplace_back(ex.what());
+    }
+
+    void printFailure(const Assertion &assertion) override {
+      failures.emplace_back(assertion.method + ": " + assertion.errorMessage);
+    }
+
+    std::vector<BenchmarkResult> results;
+    std::vector<ComplexityResult> complexities;
+    std::vector<std::string> exceptions;
+    std::vector<std::string> failures;
+  };
+
+  class FailingBenchmarks : public BenchmarkSuite {
+  public:
+    FailingBenchmarks() : BenchmarkSuite("FailingBenchmarks") {
+      BenchmarkOptions options;
+      options.minTime = std::chrono::microseconds{100};
+      options.repetitions = 2;
+      setBenchmarkOptions(options);
+      TEST_BENCHMARK(FailingBenchmarks::benchmarkWithoutLoop);
+      TEST_BENCHMARK(FailingBenchmarks::benchmarkWithFailure);
+    }
+
+    void benchmarkWithoutLoop(BenchmarkState &state) { doNotOptimize(state.getIterations()); }
+
+    void benchmarkWithFailure(BenchmarkState &state) {
+      for (auto _ : state)
+        doNotOptimize(state);
+      TEST_ASSERT_EQUALS(0u, state.getIterations());
+    }
+  };
+
+  class RangeBenchmarks : public BenchmarkSuite {
+  public:
+    RangeBenchmarks() : BenchmarkSuite("RangeBenchmarks") {
+      BenchmarkOptions options;
+      options.minTime = std::chrono::microseconds{100};
+      options.repetitions = 3;
+      setBenchmarkOptions(options);
+      TEST_BENCHMARK_RANGE(RangeBenchmarks::benchmarkSum, 64, 1000, 4, Complexity::QUADRATIC);
+      TEST_BENCHMARK_RANGE(RangeBenchmarks::benchmarkPairs, 32, 512, 2, Complexity::LINEAR);
+      // too few sizes to fit the complexity
+      TEST_BENCHMARK_RANGE(RangeBenchmarks::benchmarkSize, 1, 2);
+    }
+
+    void benchmarkSum(BenchmarkState &state) {
+      std::vector<int64_t> values(static_cast<std::size_t>(state.getInputSize()));
+      std::iota(values.begin(), values.end(), 0);
+      for (auto _ : state)
+        doNotOptimize(std::accumulate(values.begin(), values.end(), int64_t{0}));
+    }
+
+    void benchmarkPairs(BenchmarkState &state) {
+      for (auto _ : state) {
+        for (int64_t i = 0; i < state.getInputSize(); ++i) {
+          for (int64_t j = 0; j < state.getInputSize(); ++j)
+            doNotOptimize(i * j);
+        }
+      }
+    }
+
+    void benchmarkSize(BenchmarkState &state) {
+      for (auto _ : state)
+        doNotOptimize(state);
+      TEST_ASSERT(state.getInputSize() == 1 || state.getInputSize() == 2);
+    }
+  };
+
+  class InvalidRangeBenchmarks : public BenchmarkSuite {
+  public:
+    InvalidRangeBenchmarks() : BenchmarkSuite("InvalidRangeBenchmarks") {
+      TEST_BENCHMARK_RANGE(InvalidRangeBenchmarks::benchmarkNothing, 16, 8);
+    }
+
+    void benchmarkNothing(BenchmarkState &state) {
+      for (auto _ : state)
+        doNotOptimize(state);
+    }
+  };
+
+  class ThreadBenchmarks : public BenchmarkSuite {
+  public:
+    explicit ThreadBenchmarks(WorkerPool &pool) : BenchmarkSuite("ThreadBenchmarks") {
+      BenchmarkOptions options;
+      options.minTime = std::chrono::microseconds{100};
+      options.repetitions = 3;
+      options.pool = &pool;
+      setBenchmarkOptions(options);
+      TEST_BENCHMARK_THREADS(ThreadBenchmarks::benchmarkCounter, 3);
+    }
+
+    void benchmarkCounter(BenchmarkState &state) {
+      uint64_t local = 0;
+      for (auto _ : state)
+        doNotOptimize(++local);
+      counter += local;
+      if (state.getThreadIndex() == 0) {
+        TEST_ASSERT_EQUALS(state.getIterations(), local);
+        TEST_ASSERT(state.getNumThreads() >= 1u && state.getNumThreads() <= 3u);
+      }
+    }
+
+    std::atomic<uint64_t> counter{0};
+  };
+
+  ComplexityResult fitMeasurements(const std::vector<int64_t> &sizes, const std::function<double(double)> &duration) {
+    ComplexityResult result;
+    for (auto size : sizes)
+      result.measurements.push_back(ComplexityResult::Measurement{size, duration(static_cast<double>(size))});
+    Private::fitComplexity(result);
+    return result;
+  }
+} // namespace
+
+TestBenchmarkSuite::TestBenchmarkSuite() : Test::Suite("TestBenchmarkSuite") {
+  TEST_ADD(TestBenchmarkSuite::testCalibration);
+  TEST_ADD(TestBenchmarkSuite::testFailures);
+  TEST_ADD(TestBenchmarkSuite::testOutputs);
+  TEST_ADD(TestBenchmarkSuite::testSignificance);
+  TEST_ADD(TestBenchmarkSuite::testBaseline);
+  TEST_ADD(TestBenchmarkSuite::testComplexityFit);
+  TEST_ADD(TestBenchmarkSuite::testRanges);
+  TEST_ADD(TestBenchmarkSuite::testThreads);
+}
+
+void TestBenchmarkSuite::testCalibration() {
+  ExampleBenchmarks benchmarks;
+  BenchmarkRecorder recorder;
+  TEST_ASSERT(benchmarks.run(recorder));
+  TEST_ASSERT(recorder.exceptions.empty());
+  TEST_ASSERT_EQUALS(3u, recorder.results.size());
+  if (recorder.results.size() != 3u)
+    return;
+  for (const auto &result : recorder.results) {
+    TEST_ASSERT_EQUALS("ExampleBenchmarks", result.suite);
+    TEST_ASSERT_EQUALS(5u, result.repetitions);
+    // a single iteration takes far less than the minimum duration of a repetition
+    TEST_ASSERT(result.iterations > 1);
+    TEST_ASSERT(result.minimum > 0.0);
+    TEST_ASSERT(result.minimum <= result.median);
+    TEST_ASSERT(result.median <= result.percentile99);
+    TEST_ASSERT(result.minimum <= result.mean);
+    TEST_ASSERT(result.standardDeviation >= 0.0);
+  }
+  TEST_ASSERT_EQUALS("ExampleBenchmarks::benchmarkAccumulate", recorder.results[0].method);
+  TEST_ASSERT_EQUALS(256u, recorder.results[0].itemsPerIteration);
+  TEST_ASSERT(recorder.results[0].getItemsPerSecond() > 0.0);
+  TEST_ASSERT_EQUALS(0.0, recorder.results[0].getBytesPerSecond());
+  TEST_ASSERT_EQUALS(4096u, recorder.results[1].bytesPerIteration);
+  TEST_ASSERT(recorder.results[1].getBytesPerSecond() > 0.0);
+}
+
+void TestBenchmarkSuite::testFailures() {
+  FailingBenchmarks benchmarks;
+  BenchmarkRecorder recorder;
+  TEST_ASSERT_FALSE(benchmarks.run(recorder));
+  // no results are reported for failed benchmarks
+  TEST_ASSERT(recorder.results.empty());
+  TEST_ASSERT_EQUALS(1u, recorder.exceptions.size());
+  TEST_ASSERT(recorder.exceptions[0].find("BenchmarkState") != std::string::npos);
+}
+
+void TestBenchmarkSuite::testOutputs() {
+  std::stringstream textStream;
+  std::stringstream jsonStream;
+  std::stringstream xmlStream;
+  std::stringstream logStream;
+  HTMLOutput htmlOutput;
+  {
+    TextOutput textOutput(TextOutput::Terse, textStream);
+    NDJSONOutput jsonOutput(jsonStream);
+    XMLOutput xmlOutput(xmlStream);
+    BinaryLogOutput logOutput(logStream);
+    TeeOutput tee(textOutput, jsonOutput);
+    tee.addOutput(xmlOutput);
+    tee.addOutput(logOutput);
+    tee.addOutput(htmlOutput);
+    TEST_ASSERT(tee.consumes(OutputEvents::BENCHMARK));
+    ExampleBenchmarks benchmarks;
+    TEST_ASSERT(benchmarks.run(tee));
+  }
+  // the results are printed even in terse mode
+  const std::string text = textStream.str();
+  TEST_ASSERT(text.find("Benchmark 'ExampleBenchmarks::benchmarkAccumulate()': ") != std::string::npos);
+  TEST_ASSERT(text.find("ns/iteration (min ") != std::string::npos);
+  TEST_ASSERT(text.find("items/s") != std::string::npos);
+  TEST_ASSERT(text.find("B/s") != std::string::npos);
+
+  const std::string json = jsonStream.str();
+  TEST_ASSERT(json.find("{\"event\":\"benchmark\",\"suite\":\"ExampleBenchmarks\",\"method\":\"benchmarkCopy\"") !=
+              std::string::npos);
+  TEST_ASSERT(json.find("\"bytes_per_iteration\":4096,\"bytes_per_second\":") != std::string::npos);
+
+  const std::string xml = xmlStream.str();
+  TEST_ASSERT(xml.find("<property name=\"benchmark.mean_ns\" value=\"") != std::string::npos);
+  // benchmarks without assertions are not skipped
+  TEST_ASSERT_EQUALS(std::string::npos, xml.find("<skipped"));
+
+  std::stringstream html;
+  htmlOutput.generate(html, true);
+  TEST_ASSERT(html.str().find("<th>Benchmark</th>") != std::string::npos);
+
+  // the results are replayed from the binary log without any loss
+  BenchmarkRecorder recorder;
+  replayBinaryLog(logStream, recorder);
+  TEST_ASSERT_EQUALS(3u, recorder.results.size());
+  if (recorder.results.size() != 3u)
+    return;
+  TEST_ASSERT_EQUALS("ExampleBenchmarks::benchmarkCopy", recorder.results[1].method);
+  TEST_ASSERT_EQUALS(4096u, recorder.results[1].bytesPerIteration);
+  TEST_ASSERT(recorder.results[1].mean > 0.0);
+  TEST_ASSERT(recorder.results[1].minimum <= recorder.results[1].mean);
+}
+
+void TestBenchmarkSuite::testSignificance() {
+  // all current samples are slower, the exact probability is 1 of all 252 orderings
+  TEST_ASSERT_DELTA(1.0 / 252.0, BenchmarkBaseline::testSlowdown({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}), 1e-9);
+  TEST_ASSERT_DELTA(1.0, BenchmarkBaseline::testSlowdown({6, 7, 8, 9, 10}, {1, 2, 3, 4, 5}), 1e-9);
+  // U = 8, the orderings with U >= 8 are 2 of 20
+  TEST_ASSERT_DELTA(0.1, BenchmarkBaseline::testSlowdown({1, 2, 3}, {2.5, 4, 5}), 1e-9);
+  // no difference at all
+  TEST_ASSERT_DELTA(1.0, BenchmarkBaseline::testSlowdown({1, 1, 1}, {1, 1, 1}), 1e-9);
+  TEST_ASSERT_DELTA(1.0, BenchmarkBaseline::testSlowdown({}, {1, 2, 3}), 1e-9);
+
+  // large samples use the normal approximation
+  std::vector<double> lower;
+  std::vector<double> higher;
+  std::vector<double> even;
+  std::vector<double> odd;
+  for (int i = 0; i < 40; ++i) {
+    lower.push_back(i);
+    higher.push_back(40 + i);
+    even.push_back(2 * i);
+    odd.push_back(2 * i + 1);
+  }
+  TEST_ASSERT(BenchmarkBaseline::testSlowdown(lower, higher) < 1e-9);
+  TEST_ASSERT(BenchmarkBaseline::testSlowdown(higher, lower) > 0.999);
+  TEST_ASSERT(BenchmarkBaseline::testSlowdown(even, odd) > 0.3);
+
+  BenchmarkBaseline baseline;
+  TEST_THROWS(baseline.setRelativeThreshold(-0.1), std::invalid_argument);
+  TEST_THROWS(baseline.setSignificanceLevel(0.0), std::invalid_argument);
+  TEST_THROWS(baseline.setSignificanceLevel(1.5), std::invalid_argument);
+  baseline.setRelativeThreshold(0.1);
+  baseline.record("Suite::a()", {10, 11, 12, 13, 14});
+  BenchmarkBaseline::Comparison comparison;
+  TEST_ASSERT_FALSE(baseline.compareAndRecord("Suite::b()", {10, 11, 12}, comparison));
+  // significant, but below the threshold of 10%
+  TEST_ASSERT(baseline.compareAndRecord("Suite::a()", {14.1, 14.2, 14.3, 14.4, 14.5}, comparison));
+  TEST_ASSERT_DELTA(12.0, comparison.baselineMedian, 1e-9);
+  TEST_ASSERT_DELTA(14.3, comparison.currentMedian, 1e-9);
+  TEST_ASSERT(comparison.pValue <= 0.01);
+  TEST_ASSERT(comparison.isRegression);
+  TEST_ASSERT(baseline.compareAndRecord("Suite::a()", {12.5, 12.6, 12.7, 12.8, 12.9}, comparison));
+  TEST_ASSERT_FALSE(comparison.isRegression);
+  // above the threshold, but not significant
+  TEST_ASSERT(baseline.compareAndRecord("Suite::a()", {9, 10, 20, 21, 22}, comparison));
+  TEST_ASSERT(comparison.relativeChange > 0.1);
+  TEST_ASSERT_FALSE(comparison.isRegression);
+}
+
+void TestBenchmarkSuite::testBaseline() {
+  BenchmarkBaseline baseline;
+  // only the artificial regression below is large enough, so noise between the runs does not fail this test
+  baseline.setRelativeThreshold(100.0);
+  BenchmarkBaseline::setActive(&baseline);
+  {
+    // the first run only records the results
+    ExampleBenchmarks benchmarks;
+    BenchmarkRecorder recorder;
+    TEST_ASSERT(benchmarks.run(recorder));
+    TEST_ASSERT(recorder.failures.empty());
+  }
+  std::vector<double> samples;
+  TEST_ASSERT(baseline.lookup("ExampleBenchmarks::benchmarkCopy()", samples));
+  TEST_ASSERT_EQUALS(5u, samples.size());
+
+  // pretend the copy was much faster and the accumulation much slower before
+  baseline.record("ExampleBenchmarks::benchmarkCopy()", {0.001, 0.002, 0.003, 0.004, 0.005});
+  baseline.record("ExampleBenchmarks::benchmarkAccumulate()", {1e9, 1e9 + 1, 1e9 + 2, 1e9 + 3, 1e9 + 4});
+  {
+    ExampleBenchmarks benchmarks;
+    BenchmarkRecorder recorder;
+    TEST_ASSERT_FALSE(benchmarks.run(recorder));
+    // the results are reported regardless
+    TEST_ASSERT_EQUALS(3u, recorder.results.size());
+    TEST_ASSERT_EQUALS(1u, recorder.failures.size());
+    if (!recorder.failures.empty()) {
+      TEST_ASSERT(recorder.failures[0].find("ExampleBenchmarks::benchmarkCopy: Benchmark is ") == 0);
+      TEST_ASSERT(recorder.failures[0].find("slower than the baseline") != std::string::npos);
+    }
+  }
+  // existing results are kept by default
+  TEST_ASSERT(baseline.lookup("ExampleBenchmarks::benchmarkCopy()", samples));
+  TEST_ASSERT_DELTA(0.005, samples.back(), 1e-9);
+
+  baseline.setUpdateExisting(true);
+  {
+    ExampleBenchmarks benchmarks;
+    BenchmarkRecorder recorder;
+    TEST_ASSERT_FALSE(benchmarks.run(recorder));
+    TEST_ASSERT_EQUALS(1u, recorder.failures.size());
+  }
+  BenchmarkBaseline::setActive(nullptr);
+  TEST_ASSERT(baseline.lookup("ExampleBenchmarks::benchmarkCopy()", samples));
+  TEST_ASSERT(samples.front() > 0.005);
+
+  const std::string fileName = "benchmark-baseline-test.bin";
+  baseline.save(fileName);
+  BenchmarkBaseline loaded;
+  TEST_ASSERT_FALSE(loaded.load("no-such-benchmark-baseline.bin"));
+  TEST_ASSERT(loaded.empty());
+  TEST_ASSERT(loaded.load(fileName));
+  std::vector<double> loadedSamples;
+  TEST_ASSERT(loaded.lookup("ExampleBenchmarks::benchmarkCopy()", loadedSamples));
+  TEST_ASSERT_EQUALS(samples, loadedSamples);
+  TEST_ASSERT(loaded.lookup("ExampleBenchmarks::benchmarkKeepRunning()", loadedSamples));
+  std::remove(fileName.c_str());
+
+  {
+    std::ofstream out(fileName);
+    out << "CPBB\x01 not a baseline" << std::endl;
+  }
+  TEST_ASSERT_FALSE(loaded.load(fileName));
+  std::remove(fileName.c_str());
+}
+
+void TestBenchmarkSuite::testComplexityFit() {
+  // not ordered, the measurements are sorted by the fit
+  const std::vector<int64_t> sizes{4096, 1024, 2048, 8192, 16384, 32768, 65536};
+  auto result = fitMeasurements(sizes, [](double n) { return 42.0; });
+  TEST_ASSERT_EQUALS(Complexity::CONSTANT, result.complexity);
+  TEST_ASSERT_DELTA(42.0, result.coefficient, 1e-6);
+  TEST_ASSERT_EQUALS(1024, result.measurements.front().size);
+  TEST_ASSERT_EQUALS(65536, result.measurements.back().size);
+
+  result = fitMeasurements(sizes, [](double n) { return 7.0 * std::log2(n); });
+  TEST_ASSERT_EQUALS(Complexity::LOGARITHMIC, result.complexity);
+  TEST_ASSERT_DELTA(7.0, result.coefficient, 1e-6);
+
+  result = fitMeasurements(sizes, [](double n) { return 3.0 * n; });
+  TEST_ASSERT_EQUALS(Complexity::LINEAR, result.complexity);
+  TEST_ASSERT_DELTA(3.0, result.coefficient, 1e-6);
+  TEST_ASSERT_DELTA(0.0, result.rms, 1e-6);
+  result.expected = Complexity::LINEARITHMIC;
+  TEST_ASSERT_EQUALS(
+      "O(n), 3 ns * n (rms 0.0%, 7 input sizes, expected O(n log n))", Private::formatComplexity(result));
+
+  result = fitMeasurements(sizes, [](double n) { return 0.5 * n * std::log2(n); });
+  TEST_ASSERT_EQUALS(Complexity::LINEARITHMIC, result.complexity);
+  TEST_ASSERT_DELTA(0.5, result.coefficient, 1e-6);
+
+  // with some noise and a constant overhead
+  result = fitMeasurements(
+      sizes, [](double n) { return 0.01 * n * n * (static_cast<int64_t>(n) % 3 == 1 ? 1.02 : 0.99) + 100.0; });
+  TEST_ASSERT_EQUALS(Complexity::QUADRATIC, result.complexity);
+  TEST_ASSERT_DELTA(0.01, result.coefficient, 0.001);
+  TEST_ASSERT(result.rms < 0.05);
+
+  result = fitMeasurements({}, [](double n) { return n; });
+  TEST_ASSERT_EQUALS(Complexity::NONE, result.complexity);
+}
+
+void TestBenchmarkSuite::testRanges() {
+  TEST_THROWS(InvalidRangeBenchmarks{}, std::invalid_argument);
+
+  RangeBenchmarks benchmarks;
+  std::vector<std::string> names;
+  for (const auto &test : benchmarks.listTests())
+    names.push_back(test.fullName);
+  const std::vector<std::string> expectedNames{"RangeBenchmarks::benchmarkSum(64)",
+      "RangeBenchmarks::benchmarkSum(256)", "RangeBenchmarks::benchmarkSum(1000)",
+      "RangeBenchmarks::benchmarkPairs(32)", "RangeBenchmarks::benchmarkPairs(64)",
+      "RangeBenchmarks::benchmarkPairs(128)", "RangeBenchmarks::benchmarkPairs(256)",
+      "RangeBenchmarks::benchmarkPairs(512)", "RangeBenchmarks::benchmarkSize(1)", "RangeBenchmarks::benchmarkSize(2)"};
+  TEST_ASSERT_EQUALS(expectedNames, names);
+
+  std::stringstream textStream;
+  std::stringstream jsonStream;
+  std::stringstream logStream;
+  BenchmarkRecorder recorder;
+  {
+    TextOutput textOutput(TextOutput::Terse, textStream);
+    NDJSONOutput jsonOutput(jsonStream);
+    BinaryLogOutput logOutput(logStream);
+    TeeOutput tee(textOutput, jsonOutput);
+    tee.addOutput(logOutput);
+    tee.addOutput(recorder);
+    // the quadratic benchmark exceeds its declared linear complexity
+    TEST_ASSERT_FALSE(benchmarks.run(tee));
+  }
+  TEST_ASSERT(recorder.exceptions.empty());
+  TEST_ASSERT_EQUALS(10u, recorder.results.size());
+  TEST_ASSERT_EQUALS(1u, recorder.failures.size());
+  if (!recorder.failures.empty())
+    TEST_ASSERT(recorder.failures[0].find("RangeBenchmarks::benchmarkPairs: Benchmark scales with O(") == 0);
+  TEST_ASSERT_EQUALS(2u, recorder.complexities.size());
+  if (recorder.complexities.size() != 2u)
+    return;
+  const ComplexityResult &sum = recorder.complexities[0];
+  TEST_ASSERT_EQUALS("RangeBenchmarks::benchmarkSum", sum.method);
+  // reported in the test-method of the last size
+  TEST_ASSERT_EQUALS("1000", sum.args);
+  TEST_ASSERT_EQUALS(3u, sum.measurements.size());
+  TEST_ASSERT_EQUALS(Complexity::QUADRATIC, sum.expected);
+  const ComplexityResult &pairs = recorder.complexities[1];
+  TEST_ASSERT_EQUALS(5u, pairs.measurements.size());
+  TEST_ASSERT(pairs.complexity > Complexity::LINEAR);
+  TEST_ASSERT(pairs.coefficient > 0.0);
+
+  const std::string text = textStream.str();
+  TEST_ASSERT(text.find("Complexity 'RangeBenchmarks::benchmarkPairs': O(n") != std::string::npos);
+  TEST_ASSERT(text.find("expected O(n))") != std::string::npos);
+  // the table of the measurements
+  TEST_ASSERT(text.find("time/iteration\n\t          32") != std::string::npos);
+
+  const std::string json = jsonStream.str();
+  TEST_ASSERT(json.find("{\"event\":\"complexity\",\"suite\":\"RangeBenchmarks\",\"method\":\"benchmarkSum\","
+                        "\"args\":\"1000\",\"complexity\":\"O(") != std::string::npos);
+  TEST_ASSERT(json.find("\"measurements\":[{\"n\":64,\"median_ns\":") != std::string::npos);
+
+  BenchmarkRecorder replayed;
+  replayBinaryLog(logStream, replayed);
+  TEST_ASSERT_EQUALS(2u, replayed.complexities.size());
+  if (replayed.complexities.size() != 2u)
+    return;
+  TEST_ASSERT_EQUALS(pairs.complexity, replayed.complexities[1].complexity);
+  TEST_ASSERT_EQUALS(pairs.coefficient, replayed.complexities[1].coefficient);
+  TEST_ASSERT_EQUALS(512, replayed.complexities[1].measurements.back().size);
+  TEST_ASSERT_EQUALS(Complexity::LINEAR, replayed.complexities[1].expected);
+}
+
+void TestBenchmarkSuite::testThreads() {
+  WorkerPool pool(3);
+  std::vector<unsigned> indices(3, 0);
+  std::atomic<unsigned> numStarted{0};
+  std::atomic<bool> allStarted{true};
+  pool.runGang(3, [&](unsigned index) {
+    ++indices.at(index);
+    ++numStarted;
+    // all invocations pass the barrier only together, so they run concurrently
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (numStarted != 3u && std::chrono::steady_clock::now() < timeout)
+      std::this_thread::yield();
+    if (numStarted != 3u)
+      allStarted = false;
+  });
+  TEST_ASSERT_EQUALS((std::vector<unsigned>{1, 1, 1}), indices);
+  TEST_ASSERT(allStarted);
+  TEST_THROWS(pool.runGang(4, [](unsigned) {}), std::invalid_argument);
+  TEST_THROWS(pool.runGang(0, [](unsigned) {}), std::invalid_argument);
+
+  // gangs which could never start are rejected instead of waiting forever
+  std::atomic<bool> nestedRejected{false};
+  pool.runGang(2, [&](unsigned index) {
+    if (index == 0) {
+      try {
+        pool.runGang(1, [](unsigned) {});
+      } catch (const std::runtime_error &) {
+        nestedRejected = true;
+      }
+    }
+  });
+  TEST_ASSERT(nestedRejected);
+  std::atomic<bool> released{false};
+  WorkerPool::TaskGroup outerGroup;
+  pool.submit(outerGroup, [&]() {
+    WorkerPool::TaskGroup innerGroup;
+    pool.submit(innerGroup, [&]() {
+      while (!released)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    });
+    pool.wait(innerGroup);
+  });
+  // the outer worker keeps waiting until released, whichever worker runs the inner task
+  while (pool.getNumWaitingWorkers() == 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  // the worker waiting for the inner group cannot take part
+  TEST_THROWS(pool.runGang(3, [](unsigned) {}), std::runtime_error);
+  released = true;
+  pool.wait(outerGroup);
+
+  // waiting for a group never runs unrelated tasks nested within the waiting task
+  std::atomic<bool> innerStarted{false};
+  std::atomic<bool> waiting{false};
+  std::atomic<bool> nestedUnrelated{false};
+  WorkerPool::TaskGroup unrelatedGroup;
+  pool.submit(outerGroup, [&]() {
+    WorkerPool::TaskGroup innerGroup;
+    pool.submit(innerGroup, [&]() {
+      innerStarted = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    });
+    while (!innerStarted)
+      std::this_thread::yield();
+    const auto waitingThread = std::this_thread::get_id();
+    pool.submit(unrelatedGroup, [&, waitingThread]() {
+      if (waiting && std::this_thread::get_id() == waitingThread)
+        nestedUnrelated = true;
+    });
+    waiting = true;
+    pool.wait(innerGroup);
+    waiting = false;
+  });
+  pool.wait(outerGroup);
+  pool.wait(unrelatedGroup);
+  TEST_ASSERT_FALSE(nestedUnrelated);
+
+  ThreadBenchmarks benchmarks(pool);
+  std::vector<std::string> names;
+  for (const auto &test : benchmarks.listTests())
+    names.push_back(test.fullName);
+  const std::vector<std::string> expectedNames{"ThreadBenchmarks::benchmarkCounter(1 thread)",
+      "ThreadBenchmarks::benchmarkCounter(2 threads)", "ThreadBenchmarks::benchmarkCounter(3 threads)"};
+  TEST_ASSERT_EQUALS(expectedNames, names);
+
+  std::stringstream textStream;
+  std::stringstream logStream;
+  BenchmarkRecorder recorder;
+  {
+    TextOutput textOutput(TextOutput::Verbose, textStream);
+    BinaryLogOutput logOutput(logStream);
+    TeeOutput tee(textOutput, logOutput);
+    tee.addOutput(recorder);
+    TEST_ASSERT(benchmarks.run(tee));
+  }
+  TEST_ASSERT(recorder.exceptions.empty());
+  TEST_ASSERT(benchmarks.counter > 0u);
+  TEST_ASSERT_EQUALS(3u, recorder.results.size());
+  if (recorder.results.size() != 3u)
+    return;
+  TEST_ASSERT_EQUALS(1u, recorder.results[0].threads);
+  TEST_ASSERT_EQUALS(0.0, recorder.results[0].scalingEfficiency);
+  const BenchmarkResult &result = recorder.results[2];
+  TEST_ASSERT_EQUALS("3 threads", result.args);
+  TEST_ASSERT_EQUALS(3u, result.threads);
+  TEST_ASSERT(result.scalingEfficiency > 0.0);
+  TEST_ASSERT_EQUALS(3.0 * 1e9 / result.mean, result.getIterationsPerSecond());
+  TEST_ASSERT(textStream.str().find(", 3 threads, ") != std::string::npos);
+  TEST_ASSERT(textStream.str().find("% scaling efficiency") != std::string::npos);
+
+  BenchmarkRecorder replayed;
+  replayBinaryLog(logStream, replayed);
+  TEST_ASSERT_EQUALS(3u, replayed.results.size());
+  if (replayed.results.size() != 3u)
+    return;
+  TEST_ASSERT_EQUALS(3u, replayed.results[2].threads);
+  TEST_ASSERT_EQUALS(result.scalingEfficiency, replayed.results[2].scalingEfficiency);
+}
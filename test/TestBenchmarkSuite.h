@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../include/cpptest.h"
+
+/*
+ * Example benchmarks, also run directly with --benchmark-examples
+ */
+class ExampleBenchmarks : public Test::BenchmarkSuite {
+public:
+  ExampleBenchmarks();
+
+  void benchmarkAccumulate(Test::BenchmarkState &state);
+  void benchmarkCopy(Test::BenchmarkState &state);
+  void benchmarkKeepRunning(Test::BenchmarkState &state);
+};
+
+class TestBenchmarkSuite : public Test::Suite {
+public:
+  TestBenchmarkSuite();
+
+  void testCalibration();
+  void testFailures();
+  void testOutputs();
+  void testSignificance();
+  void testBaseline();
+  void testComplexityFit();
+  void testRanges();
+  void testThreads();
+};
@@ -1,6 +1,13 @@
 #include "TestOutputs.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace Test;
 
@@ -13,6 +20,15 @@ TestOutputs::TestOutputs()
   TEST_ADD_WITH_POINTER(TestOutputs::testOutput, static_cast<void *>(htmlOutput.get()));
   TEST_ADD_WITH_POINTER(TestOutputs::testOutput, static_cast<void *>(consoleOutput.get()));
   TEST_ADD_WITH_POINTER(TestOutputs::testOutput, static_cast<void *>(xmlOutput.get()));
+  TEST_ADD(TestOutputs::testSuccessEvents);
+  TEST_ADD(TestOutputs::testConsumedEvents);
+  TEST_ADD(TestOutputs::testAsyncOutput);
+  TEST_ADD(TestOutputs::testOrderedOutput);
+  TEST_ADD(TestOutputs::testXMLOutput);
+  TEST_ADD(TestOutputs::testMethodDurations);
+  TEST_ADD(TestOutputs::testBinaryLog);
+  TEST_ADD(TestOutputs::testNDJSONOutput);
+  TEST_ADD(TestOutputs::testCollectorOutput);
 }
 
 TestOutputs::~TestOutputs() = default;
@@ -29,6 +45,606 @@ void TestOutputs::testOutput(void *out) {
   }
 }
 
+namespace {
+  class SuccessCountingOutput : public Output {
+  public:
+    explicit SuccessCountingOutput(bool consume) : consumeSuccess(consume), numSuccesses(0) {}
+
+    OutputEvents getConsumedEvents() const override {
+      return consumeSuccess ? OutputEvents::ALL : ~OutputEvents::SUCCESS;
+    }
+
+    void printSuccessEvent(const AssertionEvent &event) override {
+      ++numSuccesses;
+      suiteName = getTestName(event.test).suite;
+    }
+
+    void printSuccess(const Assertion &assertion) override {
+      ++numSuccesses;
+      suiteName = assertion.suite;
+    }
+
+    const bool consumeSuccess;
+    unsigned numSuccesses;
+    std::string suiteName;
+  };
+
+  class TestWithSuccesses : public Suite {
+  public:
+    TestWithSuccesses() : Suite("TestWithSuccesses") {
+      TEST_ADD(TestWithSuccesses::passingMethod);
+      TEST_ADD(TestWithSuccesses::failingMethod);
+    }
+
+    void passingMethod() {
+      for (int i = 0; i < 4; ++i)
+        TEST_ASSERT(i < 4);
+    }
+
+    void failingMethod() {
+      TEST_ASSERT_EQUALS(1, 1);
+      TEST_ASSERT(false);
+      TEST_ASSERT_MSG(true, "Passes");
+    }
+  };
+} // namespace
+
+void TestOutputs::testSuccessEvents() {
+  SuccessCountingOutput consumingOutput(true);
+  TestWithSuccesses consumingTest;
+  consumingTest.run(consumingOutput, true);
+  TEST_ASSERT_EQUALS(6u, consumingOutput.numSuccesses);
+  TEST_ASSERT_EQUALS(6u, consumingTest.getNumPassedAssertions());
+  TEST_ASSERT_EQUALS("TestWithSuccesses", consumingOutput.suiteName);
+
+  // successful assertions are still counted, but not reported
+  SuccessCountingOutput ignoringOutput(false);
+  TestWithSuccesses ignoringTest;
+  ignoringTest.run(ignoringOutput, true);
+  TEST_ASSERT_EQUALS(0u, ignoringOutput.numSuccesses);
+  TEST_ASSERT_EQUALS(6u, ignoringTest.getNumPassedAssertions());
+
+  // the asynchronous output encodes the events without creating the full assertions
+  SuccessCountingOutput writtenOutput(true);
+  {
+    AsyncOutput asyncOutput(writtenOutput);
+    TestWithSuccesses asyncTest;
+    asyncTest.run(asyncOutput, true);
+  }
+  TEST_ASSERT_EQUALS(6u, writtenOutput.numSuccesses);
+  TEST_ASSERT_EQUALS("TestWithSuccesses", writtenOutput.suiteName);
+}
+
+void TestOutputs::testConsumedEvents() {
+  std::stringstream stream;
+  TextOutput debugOutput(TextOutput::Debug, stream);
+  TextOutput terseOutput(TextOutput::Terse, stream);
+  TEST_ASSERT(debugOutput.getConsumedEvents() == OutputEvents::ALL);
+  TEST_ASSERT_FALSE(terseOutput.consumes(OutputEvents::SUCCESS | OutputEvents::INITIALIZE_TEST_METHOD));
+  TEST_ASSERT(terseOutput.consumes(OutputEvents::FAILURE));
+  TEST_ASSERT_FALSE(CompilerOutput(CompilerOutput::FORMAT_GCC, stream).consumes(OutputEvents::SUCCESS));
+
+  // the tee consumes the events of all its outputs, but only forwards them to the consuming ones
+  SuccessCountingOutput countingOutput(true);
+  TeeOutput tee(terseOutput, countingOutput);
+  TEST_ASSERT(tee.getConsumedEvents() == OutputEvents::ALL);
+  TestWithSuccesses test;
+  test.run(tee, true);
+  TEST_ASSERT_EQUALS(6u, countingOutput.numSuccesses);
+  TEST_ASSERT_EQUALS(std::string::npos, stream.str().find("successful!"));
+  TEST_ASSERT(stream.str().find("failed!") != std::string::npos);
+
+  TeeOutput emptyTee;
+  TEST_ASSERT(emptyTee.getConsumedEvents() == OutputEvents::NONE);
+}
+
+namespace {
+  // not thread-safe, relies on the AsyncOutput to only be called from the writer thread
+  class RecordingOutput : public Output {
+  public:
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override {
+      methods.push_back(methodName + '(' + argString + ')');
+    }
+
+    void printFailure(const Assertion &assertion) override {
+      throw std::runtime_error("Failure in output: " + assertion.errorMessage);
+    }
+
+    std::vector<std::string> methods;
+  };
+} // namespace
+
+void TestOutputs::testAsyncOutput() {
+  static constexpr unsigned NUM_THREADS = 4;
+  static constexpr unsigned NUM_EVENTS = 500;
+  RecordingOutput recordingOutput;
+  {
+    // small buffer to wrap around and run into backpressure
+    AsyncOutput asyncOutput(recordingOutput, 64);
+    TEST_ASSERT(asyncOutput.isThreadSafe());
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < NUM_THREADS; ++i) {
+      threads.emplace_back([&asyncOutput, i]() {
+        for (unsigned k = 0; k < NUM_EVENTS; ++k)
+          asyncOutput.finishTestMethod(
+              "AsyncSuite", "method" + std::to_string(i), std::to_string(k), true, std::chrono::nanoseconds{k});
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    asyncOutput.flush();
+    TEST_ASSERT_EQUALS(NUM_THREADS * NUM_EVENTS, recordingOutput.methods.size());
+
+    // exceptions thrown by the underlying asyncOutput are reported by the next flush
+    asyncOutput.printFailure(Assertion(__FILE__, __LINE__, "some error", ""));
+    asyncOutput.finishTestMethod("AsyncSuite", "last", "", true, std::chrono::nanoseconds::zero());
+    TEST_THROWS(asyncOutput.flush(), std::runtime_error);
+    TEST_THROWS_NOTHING(asyncOutput.flush());
+  }
+  TEST_ASSERT_EQUALS(NUM_THREADS * NUM_EVENTS + 1, recordingOutput.methods.size());
+  TEST_ASSERT_EQUALS("last()", recordingOutput.methods.back());
+
+  // the events of every thread are written in order
+  std::vector<unsigned> nextEvents(NUM_THREADS, 0);
+  for (std::size_t n = 0; n + 1 < recordingOutput.methods.size(); ++n) {
+    const auto &method = recordingOutput.methods[n];
+    auto thread = static_cast<unsigned>(std::stoul(method.substr(6, method.find('(') - 6)));
+    auto event = static_cast<unsigned>(std::stoul(method.substr(method.find('(') + 1)));
+    TEST_ASSERT_EQUALS(nextEvents.at(thread), event);
+    nextEvents.at(thread) = event + 1;
+  }
+}
+
+namespace {
+  class EventLogOutput : public Output {
+  public:
+    void initializeSuite(const std::string &suiteName, unsigned int numTests) override {
+      events.push_back("start " + suiteName);
+    }
+
+    void finishSuite(const std::string &suiteName, unsigned int numTests, unsigned int numPositiveTests,
+        std::chrono::microseconds totalDuration) override {
+      events.push_back("finish " + suiteName);
+    }
+
+    void initializeTestMethod(
+        const std::string &suiteName, const std::string &methodName, const std::string &argString) override {
+      events.push_back("start " + methodName + '(' + argString + ')');
+    }
+
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override {
+      events.push_back("finish " + methodName + '(' + argString + ')');
+    }
+
+    void printFailure(const Assertion &assertion) override {
+      events.push_back("failure " + assertion.method + '(' + assertion.args + ')');
+    }
+
+    std::vector<std::string> events;
+  };
+
+  Assertion makeFailure(const std::string &suiteName, const std::string &methodName, const std::string &argString) {
+    Assertion assertion(__FILE__, __LINE__, "failed");
+    assertion.suite = suiteName;
+    assertion.method = methodName;
+    assertion.args = argString;
+    return assertion;
+  }
+} // namespace
+
+void TestOutputs::testOrderedOutput() {
+  {
+    // the events of every test-method are written as one block once it finished
+    EventLogOutput log;
+    OrderedOutput orderedOutput(log);
+    TEST_ASSERT(orderedOutput.isThreadSafe());
+    orderedOutput.initializeTestMethod("Suite", "first", "");
+    orderedOutput.initializeTestMethod("Suite", "second", "1");
+    orderedOutput.printFailure(makeFailure("Suite", "second", "1"));
+    TEST_ASSERT(log.events.empty());
+    orderedOutput.finishTestMethod("Suite", "second", "1", false, std::chrono::nanoseconds::zero());
+    orderedOutput.printFailure(makeFailure("Suite", "first", ""));
+    orderedOutput.finishTestMethod("Suite", "first", "", false, std::chrono::nanoseconds::zero());
+    std::vector<std::string> expected{"start second(1)", "failure second(1)", "finish second(1)", "start first()",
+        "failure first()", "finish first()"};
+    TEST_ASSERT(expected == log.events);
+  }
+  // the test-methods are written in the order of registration, regardless of the order they finish in, also if the
+  // finished test-methods waiting for the first one are moved to the temporary file
+  for (std::size_t memoryBudget : {std::size_t{0}, std::size_t{1}}) {
+    EventLogOutput log;
+    OrderedOutput orderedOutput(log, OrderedOutput::Order::CANONICAL, memoryBudget);
+    TestWithOutput suite;
+    auto tests = suite.listTests();
+    orderedOutput.expectSuite(suite, tests);
+    orderedOutput.initializeSuite(suite.getName(), static_cast<unsigned>(tests.size()));
+    std::vector<std::string> expected{"start " + suite.getName()};
+    for (auto it = tests.rbegin(); it != tests.rend(); ++it) {
+      const auto separator = it->fullName.find('(');
+      const auto methodName = it->fullName.substr(0, separator);
+      const auto argString = it->fullName.substr(separator + 1, it->fullName.size() - separator - 2);
+      orderedOutput.initializeTestMethod(suite.getName(), methodName, argString);
+      orderedOutput.finishTestMethod(suite.getName(), methodName, argString, true, std::chrono::nanoseconds::zero());
+      expected.insert(expected.begin() + 1, {"start " + it->fullName, "finish " + it->fullName});
+    }
+    // all test-methods wait for the first one to finish
+    TEST_ASSERT_EQUALS(expected.size(), log.events.size());
+    orderedOutput.finishSuite(
+        suite.getName(), static_cast<unsigned>(tests.size()), 0, std::chrono::microseconds::zero());
+    expected.push_back("finish " + suite.getName());
+    TEST_ASSERT(expected == log.events);
+  }
+}
+
+namespace {
+  // a stream which cannot be seeked, like a pipe
+  class UnseekableBuffer : public std::streambuf {
+  public:
+    std::string data;
+
+  protected:
+    int_type overflow(int_type c) override {
+      if (!traits_type::eq_int_type(c, traits_type::eof()))
+        data.push_back(traits_type::to_char_type(c));
+      return traits_type::not_eof(c);
+    }
+  };
+} // namespace
+
+void TestOutputs::testXMLOutput() {
+  const std::string fileName = "xml-output-test.xml";
+  std::stringstream givenStream;
+  UnseekableBuffer unseekableBuffer;
+  {
+    std::ostream unseekableStream(&unseekableBuffer);
+    XMLOutput fileOutput(fileName);
+    XMLOutput streamOutput(givenStream);
+    XMLOutput unseekableOutput(unseekableStream);
+    TeeOutput tee(fileOutput, streamOutput);
+    tee.addOutput(unseekableOutput);
+    TestWithOutput runTest;
+    runTest.run(tee, true);
+  }
+  // a given stream is never seeked, since it might be shared or opened in append mode
+  TEST_STRING_EQUALS(unseekableBuffer.data, givenStream.str());
+
+  // the attributes are patched into the header written before the test-cases of the file opened by the output
+  std::stringstream fileContent;
+  fileContent << std::ifstream(fileName).rdbuf();
+  std::remove(fileName.c_str());
+  const std::string seekableXML = fileContent.str();
+  TEST_ASSERT(seekableXML.find("<testsuite name=\"TestWithOutput\" tests=\"5\" failures=\"3\" errors=\"0\"") !=
+              std::string::npos);
+  TEST_ASSERT(seekableXML.find("<skipped message=\"Test case has no assertions\"") != std::string::npos);
+  TEST_ASSERT(seekableXML.find("</testsuites>") != std::string::npos);
+
+  // same content without the whitespace reserved for the attributes
+  std::string strippedXML = seekableXML;
+  const auto paddingEnd = strippedXML.find(" >\n");
+  TEST_ASSERT(paddingEnd != std::string::npos);
+  const auto paddingStart = strippedXML.find_last_not_of(' ', paddingEnd) + 1;
+  strippedXML.erase(paddingStart, paddingEnd + 1 - paddingStart);
+  TEST_STRING_EQUALS(unseekableBuffer.data, strippedXML);
+
+  // the same suite running twice concurrently is written twice with its own test-cases
+  std::atomic<unsigned> numStarted{0};
+  std::stringstream duplicateStream;
+  {
+    XMLOutput xml(duplicateStream);
+    ParallelSuite parallel("Parallel");
+    parallel.add(std::make_shared<SlowSuite>(numStarted));
+    parallel.add(std::make_shared<SlowSuite>(numStarted));
+    TEST_ASSERT(parallel.run(xml, parallel.listTests(), true));
+  }
+  const std::string duplicateXML = duplicateStream.str();
+  std::size_t numSuites = 0;
+  std::size_t numTestCases = 0;
+  const std::string suiteHeader = "<testsuite name=\"Slow\" tests=\"2\" failures=\"0\" errors=\"0\"";
+  for (auto pos = duplicateXML.find(suiteHeader); pos != std::string::npos;
+       pos = duplicateXML.find(suiteHeader, pos + 1)) {
+    const auto end = duplicateXML.find("</testsuite>", pos);
+    const std::string element = duplicateXML.substr(pos, end - pos);
+    TEST_ASSERT(element.find("name=\"first\"") != std::string::npos);
+    TEST_ASSERT(element.find("name=\"second\"") != std::string::npos);
+    ++numSuites;
+  }
+  for (auto pos = duplicateXML.find("<testcase"); pos != std::string::npos;
+       pos = duplicateXML.find("<testcase", pos + 1))
+    ++numTestCases;
+  TEST_ASSERT_EQUALS(2u, numSuites);
+  TEST_ASSERT_EQUALS(4u, numTestCases);
+}
+
+namespace {
+  class DurationOutput : public Output {
+  public:
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess, std::chrono::nanoseconds duration) override {
+      durations.push_back(duration);
+    }
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex, std::chrono::nanoseconds duration) override {
+      durations.push_back(duration);
+    }
+
+    std::vector<std::chrono::nanoseconds> durations;
+  };
+
+  // an output written before the durations were passed
+  class LegacyOutput : public Output {
+  public:
+    void finishTestMethod(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        bool withSuccess) override {
+      ++numFinished;
+    }
+
+    void printException(const std::string &suiteName, const std::string &methodName, const std::string &argString,
+        const std::exception &ex) override {
+      ++numExceptions;
+    }
+
+    unsigned numFinished = 0;
+    unsigned numExceptions = 0;
+  };
+} // namespace
+
+void TestOutputs::testMethodDurations() {
+  {
+    // the durations are measured per test-method and survive the encoding of the asynchronous output
+    DurationOutput durationOutput;
+    {
+      AsyncOutput asyncOutput(durationOutput);
+      TestWithOutput runTest;
+      runTest.run(asyncOutput, true);
+      asyncOutput.printException(
+          "Suite", "method", "", std::runtime_error("error"), std::chrono::nanoseconds{1234567890123});
+    }
+    TEST_ASSERT_EQUALS(6u, durationOutput.durations.size());
+    TEST_ASSERT_EQUALS(1234567890123, durationOutput.durations.back().count());
+    for (const auto &duration : durationOutput.durations)
+      TEST_ASSERT(duration.count() >= 0);
+  }
+  {
+    std::stringstream stream;
+    TextOutput text(TextOutput::Debug, stream);
+    text.finishTestMethod("Suite", "method", "", true, std::chrono::nanoseconds{1234567});
+    text.printException("Suite", "method", "", std::runtime_error("error"), std::chrono::nanoseconds{850});
+    TEST_ASSERT(stream.str().find("finished with success in 1.235 ms!") != std::string::npos);
+    TEST_ASSERT(stream.str().find("Duration: 850 ns") != std::string::npos);
+  }
+  {
+    std::stringstream stream;
+    {
+      XMLOutput xml(stream);
+      xml.initializeSuite("Suite", 2);
+      xml.initializeTestMethod("Suite", "method", "");
+      xml.finishTestMethod("Suite", "method", "", true, std::chrono::nanoseconds{2000001234});
+      xml.initializeTestMethod("Suite", "throwing", "");
+      xml.printException("Suite", "throwing", "", std::runtime_error("error"), std::chrono::nanoseconds{42});
+      xml.finishSuite("Suite", 2, 1, std::chrono::microseconds{2000002});
+    }
+    TEST_ASSERT(stream.str().find("name=\"method\" time=\"2.000001234\"") != std::string::npos);
+    TEST_ASSERT(stream.str().find("name=\"throwing\" time=\"0.000000042\"") != std::string::npos);
+    TEST_ASSERT(stream.str().find("<error message=\"error\"") != std::string::npos);
+  }
+  {
+    // the overloads without the duration are still called
+    LegacyOutput legacy;
+    Output &base = legacy;
+    base.finishTestMethod("Suite", "method", "", true, std::chrono::nanoseconds{1});
+    base.printException("Suite", "method", "", std::runtime_error("error"), std::chrono::nanoseconds{1});
+    TEST_ASSERT_EQUALS(1u, legacy.numFinished);
+    TEST_ASSERT_EQUALS(1u, legacy.numExceptions);
+  }
+}
+
+void TestOutputs::testBinaryLog() {
+  std::stringstream directText;
+  std::stringstream log;
+  {
+    TextOutput text(TextOutput::Debug, directText);
+    BinaryLogOutput binaryLog(log);
+    TeeOutput tee(text, binaryLog);
+    TestWithOutput runTest;
+    runTest.run(tee, true);
+  }
+  // replaying the log produces the same output as writing it directly
+  std::stringstream replayedText;
+  {
+    TextOutput text(TextOutput::Debug, replayedText);
+    replayBinaryLog(log, text);
+  }
+  TEST_STRING_EQUALS(directText.str(), replayedText.str());
+
+  // repeated names are only written once
+  const std::string longName(200, 'x');
+  std::stringstream repeatedLog;
+  {
+    BinaryLogOutput binaryLog(repeatedLog);
+    for (unsigned i = 0; i < 100; ++i) {
+      binaryLog.initializeTestMethod(longName, longName, "");
+      binaryLog.finishTestMethod(longName, longName, "", true, std::chrono::nanoseconds{i});
+    }
+  }
+  TEST_ASSERT(repeatedLog.str().size() < 2 * longName.size() + 100 * 16);
+
+  // truncated logs and other files are rejected
+  std::stringstream truncatedLog(log.str().substr(0, log.str().size() - 1));
+  std::stringstream truncatedText;
+  TextOutput text(TextOutput::Debug, truncatedText);
+  TEST_THROWS(replayBinaryLog(truncatedLog, text), std::runtime_error);
+  std::stringstream invalidLog("<?xml version=\"1.0\" ?>");
+  TEST_THROWS(replayBinaryLog(invalidLog, text), std::runtime_error);
+}
+
+void TestOutputs::testNDJSONOutput() {
+  std::stringstream stream;
+  {
+    NDJSONOutput json(stream);
+    TestWithOutput runTest;
+    runTest.run(json, true);
+  }
+  // one object per event
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(stream, line))
+    lines.push_back(line);
+  // suite start and finish, start and finish per test-method and the failed assertions
+  std::size_t numFailures = 0;
+  for (const auto &entry : lines) {
+    TEST_ASSERT_EQUALS('{', entry.front());
+    TEST_ASSERT_EQUALS('}', entry.back());
+    if (entry.find("{\"event\":\"failure\"") == 0)
+      ++numFailures;
+  }
+  TEST_ASSERT(numFailures >= 3u);
+  TEST_ASSERT_EQUALS(2u + 5u * 2u + numFailures, lines.size());
+  TEST_STRING_EQUALS("{\"event\":\"suite_start\",\"suite\":\"TestWithOutput\",\"tests\":5}", lines.front());
+  TEST_ASSERT(
+      lines[1].find("{\"event\":\"test_start\",\"suite\":\"TestWithOutput\",\"method\":\"someTestMethod\"") == 0);
+  TEST_ASSERT(lines.back().find("\"passed\":2,\"duration_us\":") != std::string::npos);
+
+  std::string escaped;
+  const std::string text("a\"b\\c\nd\x01\xc3\xa4");
+  Private::appendJSONString(escaped, text.data(), text.size());
+  TEST_STRING_EQUALS("\"a\\\"b\\\\c\\nd\\u0001\xc3\xa4\"", escaped);
+}
+
+namespace {
+  class InspectableCollector : public CollectorOutput {
+  public:
+    explicit InspectableCollector(bool keepPassedAssertions = true, std::size_t memoryBudget = 0)
+        : CollectorOutput(keepPassedAssertions, memoryBudget) {}
+
+    struct CollectedSuite {
+      std::string suiteName;
+      std::chrono::microseconds suiteDuration;
+      std::vector<TestMethodInfo> methods;
+    };
+
+    std::vector<CollectedSuite> collectSuites() const {
+      std::vector<CollectedSuite> suites;
+      visitSuites([&suites](const SuiteInfo &suite) {
+        suites.emplace_back(CollectedSuite{suite.suiteName, suite.suiteDuration, suite.methods});
+      });
+      return suites;
+    }
+
+    using CollectorOutput::getNumSpilledSuites;
+  };
+} // namespace
+
+void TestOutputs::testCollectorOutput() {
+  static constexpr unsigned NUM_THREADS = 4;
+  static constexpr unsigned NUM_METHODS = 50;
+  // without and with moving all completed suites to the temporary file
+  for (std::size_t memoryBudget : {0u, 1u}) {
+    InspectableCollector collector(true, memoryBudget);
+    TEST_ASSERT(collector.isThreadSafe());
+    collector.initializeSuite("Outer", NUM_THREADS * NUM_METHODS);
+    {
+      // suites of the same name and the test-methods of the outer suite run concurrently
+      std::vector<std::thread> threads;
+      for (unsigned i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back([&collector, i]() {
+          collector.initializeSuite("Inner", NUM_METHODS);
+          for (unsigned k = 0; k < NUM_METHODS; ++k) {
+            const std::string args = std::to_string(i) + "/" + std::to_string(k);
+            collector.initializeTestMethod("Inner", "method", args);
+            collector.printFailure(makeFailure("Inner", "method", args));
+            collector.finishTestMethod("Inner", "method", args, false, std::chrono::nanoseconds{k});
+            collector.initializeTestMethod("Outer", "method", args);
+            collector.finishTestMethod("Outer", "method", args, true, std::chrono::nanoseconds{k});
+          }
+          collector.finishSuite("Inner", NUM_METHODS, 0, std::chrono::microseconds{i});
+        });
+      }
+      for (auto &thread : threads)
+        thread.join();
+    }
+    collector.finishSuite(
+        "Outer", NUM_THREADS * NUM_METHODS, NUM_THREADS * NUM_METHODS, std::chrono::microseconds{42});
+
+    const auto suites = collector.collectSuites();
+    TEST_ASSERT_EQUALS(NUM_THREADS + 1, suites.size());
+    TEST_ASSERT_EQUALS("Outer", suites.front().suiteName);
+    TEST_ASSERT_EQUALS(NUM_THREADS * NUM_METHODS, suites.front().methods.size());
+    TEST_ASSERT_EQUALS(42, suites.front().suiteDuration.count());
+    for (std::size_t i = 1; i < suites.size(); ++i) {
+      TEST_ASSERT_EQUALS("Inner", suites[i].suiteName);
+      TEST_ASSERT_EQUALS(NUM_METHODS, suites[i].methods.size());
+      if (suites[i].methods.size() != NUM_METHODS)
+        continue;
+      // every inner suite only contains the test-methods of its thread, in the order they ran
+      const std::string thread = suites[i].methods.front().argString.substr(0, 2);
+      for (unsigned k = 0; k < NUM_METHODS; ++k) {
+        TEST_ASSERT_EQUALS(thread + std::to_string(k), suites[i].methods[k].argString);
+        TEST_ASSERT_EQUALS(1u, suites[i].methods[k].failedAssertions.size());
+      }
+    }
+    TEST_ASSERT_EQUALS(memoryBudget == 0 ? 0u : NUM_THREADS + 1, collector.getNumSpilledSuites());
+    TEST_THROWS(collector.finishSuite("Outer", 0, 0, std::chrono::microseconds::zero()), std::runtime_error);
+  }
+
+  // the successful assertions are only counted, the failed ones are kept
+  for (bool keepPassed : {true, false}) {
+    InspectableCollector counter(keepPassed);
+    TestWithSuccesses runTest;
+    runTest.run(counter, true);
+    const auto results = counter.collectSuites();
+    TEST_ASSERT_EQUALS(1u, results.size());
+    TEST_ASSERT_EQUALS(2u, results.front().methods.size());
+    const auto &failingMethod = results.front().methods.back();
+    TEST_ASSERT_EQUALS(2u, failingMethod.numPassedAssertions);
+    TEST_ASSERT_EQUALS(keepPassed ? 2u : 0u, failingMethod.passedAssertions.size());
+    TEST_ASSERT_EQUALS(1u, failingMethod.failedAssertions.size());
+    TEST_ASSERT_EQUALS(4u, results.front().methods.front().numPassedAssertions);
+  }
+
+  // the report does not depend on whether the suites were moved to the temporary file
+  HTMLOutput inMemory;
+  HTMLOutput spilled(1);
+  {
+    TeeOutput tee(inMemory, spilled);
+    TestWithOutput runTest;
+    runTest.run(tee, true);
+    TestWithSuccesses runOther;
+    runOther.run(tee, true);
+    runTest.run(tee, true);
+  }
+  std::stringstream inMemoryHTML;
+  inMemory.generate(inMemoryHTML);
+  std::stringstream spilledHTML;
+  spilled.generate(spilledHTML);
+  TEST_STRING_EQUALS(inMemoryHTML.str(), spilledHTML.str());
+  TEST_ASSERT(inMemoryHTML.str().find("Failed test") != std::string::npos);
+
+  // the collected results are moved along with the output
+  HTMLOutput moved(std::move(spilled));
+  std::stringstream movedHTML;
+  moved.generate(movedHTML);
+  TEST_STRING_EQUALS(spilledHTML.str(), movedHTML.str());
+}
+
+SlowSuite::SlowSuite(std::atomic<unsigned> &started) : Test::Suite("Slow"), numStarted(started) {
+  TEST_ADD(SlowSuite::first);
+  TEST_ADD(SlowSuite::second);
+}
+
+void SlowSuite::first() {
+  // waits (for a bounded time) for the other run, so both runs of the suite overlap
+  ++numStarted;
+  const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+  while (numStarted < 2 && std::chrono::steady_clock::now() < timeout)
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  TEST_ASSERT(true);
+}
+
+void SlowSuite::second() { TEST_ASSERT(true); }
+
 TestWithOutput::TestWithOutput() : Suite("TestWithOutput") {
   // test Output-format
   TEST_ADD(TestWithOutput::someTestMethod);
@@ -2,6 +2,7 @@
 
 #include "cpptest.h"
 
+#include <atomic>
 #include <memory>
 
 class TestOutputs : public Test::Suite {
@@ -10,6 +11,15 @@ public:
   ~TestOutputs() override;
 
   void testOutput(void *out);
+  void testSuccessEvents();
+  void testConsumedEvents();
+  void testAsyncOutput();
+  void testOrderedOutput();
+  void testXMLOutput();
+  void testMethodDurations();
+  void testBinaryLog();
+  void testNDJSONOutput();
+  void testCollectorOutput();
 
 private:
   std::unique_ptr<Test::Output> textOutput;
@@ -19,6 +29,17 @@ private:
   std::unique_ptr<Test::Output> xmlOutput;
 };
 
+class SlowSuite : public Test::Suite {
+public:
+  explicit SlowSuite(std::atomic<unsigned> &started);
+
+  void first();
+  void second();
+
+private:
+  std::atomic<unsigned> &numStarted;
+};
+
 class TestWithOutput : public Test::Suite {
 public:
   TestWithOutput();
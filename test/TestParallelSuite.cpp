@@ -1,8 +1,36 @@
 #include "TestParallelSuite.h"
 
+#include "TestAssertions.h"
+
 TestParallelSuite::TestParallelSuite() : Test::ParallelSuite("TestParallel") {
   add(std::shared_ptr<Test::Suite>(new FailTestSuite()));
   add(std::shared_ptr<Test::Suite>(new CompareTestSuite()));
   add(std::shared_ptr<Test::Suite>(new ThrowTestSuite()));
   add(std::shared_ptr<Test::Suite>(new TestMacros()));
+  // nested parallel suites are scheduled on the same worker pool
+  std::shared_ptr<Test::Suite> nested(new Test::ParallelSuite("NestedParallel"));
+  nested->add(std::shared_ptr<Test::Suite>(new TestAssertions()));
+  nested->add(std::shared_ptr<Test::Suite>(new TestAssertions()));
+  add(nested);
+}
+
+TestParallelMethods::TestParallelMethods() : Test::Suite("TestParallelMethods"), numSetups(0) {
+  for (int i = 0; i < 64; ++i) {
+    TEST_ADD_WITH_INTEGER(TestParallelMethods::testWorkerInstance, i);
+  }
+}
+
+void TestParallelMethods::testWorkerInstance(int index) {
+  // setup() was run exactly once for this instance and the instance is only used by a single thread
+  TEST_ASSERT_EQUALS(1, numSetups);
+  TEST_ASSERT(workerThread == std::this_thread::get_id());
+  TEST_ASSERT(index >= 0 && index < 64);
+}
+
+bool TestParallelMethods::setup() {
+  workerThread = std::this_thread::get_id();
+  ++numSetups;
+  return true;
 }
+
+void TestParallelMethods::tear_down() { workerThread = std::thread::id{}; }
@@ -3,7 +3,27 @@
 #include "TestMacros.h"
 #include "TestSuites.h"
 
+#include <thread>
+
 class TestParallelSuite : public Test::ParallelSuite {
 public:
   TestParallelSuite();
 };
+
+/*
+ * Suite registered to run its test-methods in parallel, each worker on an own instance
+ */
+class TestParallelMethods : public Test::Suite {
+public:
+  TestParallelMethods();
+
+  void testWorkerInstance(int index);
+
+protected:
+  bool setup() override;
+  void tear_down() override;
+
+private:
+  std::thread::id workerThread;
+  int numSetups;
+};
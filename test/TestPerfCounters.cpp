@@ -0,0 +1,217 @@
+#include "TestPerfCounters.h"
+
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+using namespace Test;
+
+namespace {
+  class CounterRecorder : public Output {
+  public:
+    explicit CounterRecorder(bool consumeCounters = true) : consumesCounters(consumeCounters) {}
+
+    OutputEvents getConsumedEvents() const override {
+      return consumesCounters ? OutputEvents::ALL : ~OutputEvents::PERF_COUNTERS;
+    }
+
+    void printPerfCounters(const PerfCounterResult &result) override { results.push_back(result); }
+
+    std::vector<PerfCounterResult> results;
+
+  private:
+    bool consumesCounters;
+  };
+
+  class CountedSuite : public Suite {
+  public:
+    CountedSuite() : Suite("CountedSuite") { TEST_ADD(CountedSuite::testSum); }
+
+    void testSum() {
+      std::vector<uint64_t> values(4096);
+      std::iota(values.begin(), values.end(), 0);
+      TEST_ASSERT_EQUALS(4095u * 4096u / 2u, std::accumulate(values.begin(), values.end(), uint64_t{0}));
+    }
+  };
+
+  PerfCounterResult createResult() {
+    PerfCounterResult result;
+    result.suite = "Suite";
+    result.method = "Suite::method";
+    result.args = "42";
+    result.set(PerfCounter::CYCLES, 1000000);
+    result.set(PerfCounter::INSTRUCTIONS, 2500000);
+    result.set(PerfCounter::BRANCHES, 400000);
+    result.set(PerfCounter::BRANCH_MISSES, 2000);
+    result.set(PerfCounter::L1D_READS, 800000);
+    result.set(PerfCounter::L1D_READ_MISSES, 24000);
+    result.set(PerfCounter::LLC_REFERENCES, 10000);
+    result.set(PerfCounter::LLC_MISSES, 1250);
+    result.set(PerfCounter::CONTEXT_SWITCHES, 3);
+    return result;
+  }
+
+  // reports the counters within a single test-method, as a suite would
+  void reportCounters(Output &output, const PerfCounterResult &result) {
+    output.initializeSuite(result.suite, 1);
+    output.initializeTestMethod(result.suite, result.method, result.args);
+    output.printPerfCounters(result);
+    output.finishTestMethod(result.suite, result.method, result.args, true, std::chrono::nanoseconds{1000});
+    output.finishSuite(result.suite, 1, 1, std::chrono::microseconds{1});
+  }
+
+  // restores whether the counters are enabled, which is process-wide
+  class EnabledGuard {
+  public:
+    EnabledGuard() : previous(PerfCounters::isEnabled()) {}
+    ~EnabledGuard() { PerfCounters::setEnabled(previous); }
+
+  private:
+    bool previous;
+  };
+} // namespace
+
+TestPerfCounters::TestPerfCounters() : Test::Suite("TestPerfCounters") {
+  TEST_ADD(TestPerfCounters::testFormat);
+  TEST_ADD(TestPerfCounters::testMeasure);
+  TEST_ADD(TestPerfCounters::testSuite);
+  TEST_ADD(TestPerfCounters::testOutputs);
+}
+
+void TestPerfCounters::testFormat() {
+  PerfCounterResult result = createResult();
+  TEST_ASSERT_EQUALS(0x1FFu, result.available);
+  TEST_ASSERT_DELTA(2.5, result.getInstructionsPerCycle(), 1e-9);
+  TEST_ASSERT_DELTA(0.005, result.getBranchMissRate(), 1e-9);
+  TEST_ASSERT_DELTA(0.03, result.getL1DMissRate(), 1e-9);
+  TEST_ASSERT_DELTA(0.125, result.getLLCMissRate(), 1e-9);
+  TEST_ASSERT_EQUALS("IPC 2.50 (2.500 M instructions), 0.50% branch misses, 3.00% L1D misses, 12.50% LLC misses, 3 "
+                     "context switches",
+      Private::formatPerfCounters(result));
+
+  // e.g. no hardware counters available in a virtual machine
+  PerfCounterResult partial;
+  TEST_ASSERT_EQUALS("", Private::formatPerfCounters(partial));
+  TEST_ASSERT_EQUALS(0.0, partial.getInstructionsPerCycle());
+  partial.set(PerfCounter::CONTEXT_SWITCHES, 1);
+  TEST_ASSERT_EQUALS("1 context switch", Private::formatPerfCounters(partial));
+  // a ratio needs both counters
+  partial.set(PerfCounter::BRANCH_MISSES, 10);
+  TEST_ASSERT_EQUALS(0.0, partial.getBranchMissRate());
+  TEST_ASSERT_EQUALS("1 context switch", Private::formatPerfCounters(partial));
+}
+
+void TestPerfCounters::testMeasure() {
+  PerfCounters &counters = PerfCounters::getCurrentThread();
+  TEST_ASSERT_EQUALS(&counters, &PerfCounters::getCurrentThread());
+  if (!PerfCounters::isSupported())
+    TEST_ASSERT_EQUALS(0u, counters.getAvailable());
+
+  PerfCounterResult result;
+  counters.start();
+  std::vector<uint64_t> values(1 << 16);
+  std::iota(values.begin(), values.end(), 0);
+  doNotOptimize(std::accumulate(values.begin(), values.end(), uint64_t{0}));
+  counters.stop(result);
+  // only the available counters are set, but a group might not have been scheduled
+  TEST_ASSERT_EQUALS(0u, result.available & ~counters.getAvailable());
+  if (result.has(PerfCounter::CYCLES))
+    TEST_ASSERT(result.get(PerfCounter::CYCLES) > 0u);
+  if (result.has(PerfCounter::INSTRUCTIONS))
+    TEST_ASSERT(result.get(PerfCounter::INSTRUCTIONS) > values.size());
+}
+
+void TestPerfCounters::testSuite() {
+  EnabledGuard guard;
+  const bool available = PerfCounters::getCurrentThread().getAvailable() != 0;
+  {
+    PerfCounters::setEnabled(false);
+    CountedSuite suite;
+    CounterRecorder recorder;
+    TEST_ASSERT(suite.run(recorder));
+    TEST_ASSERT(recorder.results.empty());
+  }
+  {
+    PerfCounters::setEnabled(true);
+    CountedSuite suite;
+    CounterRecorder recorder;
+    TEST_ASSERT(suite.run(recorder));
+    // without any available counter, the test-methods run as usual
+    TEST_ASSERT_EQUALS(available ? 1u : 0u, recorder.results.size());
+    if (!recorder.results.empty()) {
+      TEST_ASSERT_EQUALS("CountedSuite", recorder.results[0].suite);
+      TEST_ASSERT_EQUALS("CountedSuite::testSum", recorder.results[0].method);
+      TEST_ASSERT(recorder.results[0].available != 0u);
+    }
+  }
+  {
+    // outputs not consuming the counters do not cause any measurement
+    CountedSuite suite;
+    CounterRecorder recorder(false);
+    TEST_ASSERT(suite.run(recorder));
+    TEST_ASSERT(recorder.results.empty());
+  }
+}
+
+void TestPerfCounters::testOutputs() {
+  const PerfCounterResult result = createResult();
+  std::stringstream textStream;
+  std::stringstream jsonStream;
+  std::stringstream xmlStream;
+  std::stringstream logStream;
+  HTMLOutput htmlOutput;
+  {
+    TextOutput textOutput(TextOutput::Terse, textStream);
+    NDJSONOutput jsonOutput(jsonStream);
+    XMLOutput xmlOutput(xmlStream);
+    BinaryLogOutput logOutput(logStream);
+    TeeOutput tee(textOutput, jsonOutput);
+    tee.addOutput(xmlOutput);
+    tee.addOutput(logOutput);
+    tee.addOutput(htmlOutput);
+    TEST_ASSERT(tee.consumes(OutputEvents::PERF_COUNTERS));
+    reportCounters(tee, result);
+  }
+  // the explicitly enabled counters are printed even in terse mode
+  TEST_ASSERT(textStream.str().find("Counters 'Suite::method(42)': IPC 2.50 (") != std::string::npos);
+
+  const std::string json = jsonStream.str();
+  TEST_ASSERT(json.find("{\"event\":\"perf_counters\",\"suite\":\"Suite\",\"method\":\"method\",\"args\":\"42\","
+                        "\"cycles\":1000000,\"instructions\":2500000,") != std::string::npos);
+  TEST_ASSERT(json.find("\"context_switches\":3,\"ipc\":2.500,\"branch_miss_rate\":0.005000,"
+                        "\"l1d_miss_rate\":0.030000,\"llc_miss_rate\":0.125000}") != std::string::npos);
+
+  const std::string xml = xmlStream.str();
+  TEST_ASSERT(xml.find("<property name=\"perf.ipc\" value=\"2.500\"/>") != std::string::npos);
+  TEST_ASSERT(xml.find("<property name=\"perf.context_switches\" value=\"3\"/>") != std::string::npos);
+  // the counters do not make a test-method without assertions a benchmark
+  TEST_ASSERT(xml.find("<skipped") != std::string::npos);
+
+  std::stringstream html;
+  htmlOutput.generate(html, true);
+  TEST_ASSERT(html.str().find("<th>Performance Counters</th>") != std::string::npos);
+  TEST_ASSERT(html.str().find("12.50% LLC misses") != std::string::npos);
+
+  // only the available counters are written to the binary log
+  CounterRecorder recorder;
+  PerfCounterResult partial;
+  partial.suite = "Suite";
+  partial.method = "Suite::other";
+  partial.set(PerfCounter::CONTEXT_SWITCHES, 7);
+  std::stringstream partialLogStream;
+  {
+    BinaryLogOutput logOutput(partialLogStream);
+    reportCounters(logOutput, partial);
+  }
+  replayBinaryLog(logStream, recorder);
+  replayBinaryLog(partialLogStream, recorder);
+  TEST_ASSERT_EQUALS(2u, recorder.results.size());
+  if (recorder.results.size() != 2u)
+    return;
+  TEST_ASSERT_EQUALS("Suite::method", recorder.results[0].method);
+  TEST_ASSERT_EQUALS("42", recorder.results[0].args);
+  TEST_ASSERT_EQUALS(result.available, recorder.results[0].available);
+  TEST_ASSERT(result.values == recorder.results[0].values);
+  TEST_ASSERT_EQUALS(1u << static_cast<unsigned>(PerfCounter::CONTEXT_SWITCHES), recorder.results[1].available);
+  TEST_ASSERT_EQUALS(7u, recorder.results[1].get(PerfCounter::CONTEXT_SWITCHES));
+}
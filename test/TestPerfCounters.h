@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../include/cpptest.h"
+
+class TestPerfCounters : public Test::Suite {
+public:
+  TestPerfCounters();
+
+  void testFormat();
+  void testMeasure();
+  void testSuite();
+  void testOutputs();
+};
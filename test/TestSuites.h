@@ -2,6 +2,10 @@
 
 #include "../include/cpptest.h"
 
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+
 // Tests unconditional fail asserts
 
 class FailTestSuite : public Test::Suite {
@@ -88,3 +92,91 @@ private:
   void func_no_throw() noexcept {}
   void func_throw_int() { throw 13; }
 };
+
+// Tests crashing test-methods, only to be run with --isolate=process
+
+class CrashTestSuite : public Test::Suite {
+public:
+  CrashTestSuite() : Test::Suite("CrashTestSuite") {
+    TEST_ADD(CrashTestSuite::success);
+    TEST_ADD(CrashTestSuite::crash);
+    TEST_ADD(CrashTestSuite::exit_early);
+    TEST_ADD(CrashTestSuite::hang);
+    TEST_TIMEOUT(200);
+    TEST_ADD(CrashTestSuite::success_after_crash);
+  }
+
+private:
+  void success() { TEST_ASSERT(true); }
+
+  void crash() {
+    // Will kill the worker process, which is reported as exception
+    std::raise(SIGSEGV);
+  }
+
+  void exit_early() {
+    // Will terminate the worker process without reporting a result
+    std::_Exit(3);
+  }
+
+  void hang() {
+    // Will be killed by the watchdog after the timeout
+    std::this_thread::sleep_for(std::chrono::seconds{60});
+  }
+
+  void success_after_crash() { TEST_ASSERT(true); }
+};
+
+// Tests the timeout of test-methods
+
+class TimeoutTestSuite : public Test::Suite {
+public:
+  TimeoutTestSuite() : Test::Suite("TimeoutTestSuite") {
+    setSuiteTimeout(std::chrono::milliseconds{300});
+    TEST_ADD(TimeoutTestSuite::success);
+    TEST_TIMEOUT(5000);
+    TEST_ADD(TimeoutTestSuite::cancelled);
+    TEST_ADD(TimeoutTestSuite::returns_late);
+  }
+
+private:
+  void success() {
+    // Will succeed, since the explicit timeout overrides the timeout of the suite
+    std::this_thread::sleep_for(std::chrono::milliseconds{400});
+    TEST_ASSERT(true);
+  }
+
+  void cancelled() {
+    // Will be cancelled by the first assertion after the timeout
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (std::chrono::steady_clock::now() < end) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      TEST_ASSERT(true);
+    }
+  }
+
+  void returns_late() {
+    // Will fail, since the test-method returns after the timeout, but within the grace period
+    std::this_thread::sleep_for(std::chrono::milliseconds{450});
+  }
+};
+
+// Tests only a single suite instance is alive at a time when run via runSuites
+
+class LifetimeTestSuite : public Test::Suite {
+public:
+  LifetimeTestSuite() : Test::Suite("LifetimeTestSuite") {
+    ++numInstances();
+    TEST_ADD(LifetimeTestSuite::single_instance);
+  }
+
+  ~LifetimeTestSuite() noexcept override { --numInstances(); }
+
+private:
+  void single_instance() { TEST_ASSERT_EQUALS(1, numInstances()); }
+
+  static int &numInstances() {
+    static int instances = 0;
+    return instances;
+  }
+};
@@ -0,0 +1,137 @@
+#include "TestTimingHistory.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace Test;
+
+TestTimingHistory::TestTimingHistory() : Test::Suite("TestTimingHistory") {
+  TEST_ADD(TestTimingHistory::testHashedShards);
+  TEST_ADD(TestTimingHistory::testBalancedShards);
+  TEST_ADD(TestTimingHistory::testUnknownDurations);
+  TEST_ADD(TestTimingHistory::testSaveAndLoad);
+  TEST_ADD(TestTimingHistory::testMovingAverage);
+  TEST_ADD(TestTimingHistory::testLongestFirst);
+  TEST_ADD(TestTimingHistory::testInvalidFile);
+}
+
+void TestTimingHistory::testHashedShards() {
+  TimingHistory history;
+  std::vector<std::string> names{"Suite::a()", "Suite::b()", "Suite::c()", "Suite::d()", "Suite::e()"};
+  auto shards = history.assignShards(names, 3);
+  TEST_ASSERT_EQUALS(names.size(), shards.size());
+  for (auto shard : shards)
+    TEST_ASSERT(shard < 3);
+
+  // the shard of a test-method does not depend on the other test-methods
+  std::vector<std::string> subset{names[3], names[1]};
+  auto subsetShards = history.assignShards(subset, 3);
+  TEST_ASSERT_EQUALS(shards[3], subsetShards[0]);
+  TEST_ASSERT_EQUALS(shards[1], subsetShards[1]);
+
+  TEST_THROWS(history.assignShards(names, 0), std::invalid_argument);
+}
+
+void TestTimingHistory::testBalancedShards() {
+  TimingHistory history;
+  history.record("Suite::a()", std::chrono::microseconds{8});
+  history.record("Suite::b()", std::chrono::microseconds{7});
+  history.record("Suite::c()", std::chrono::microseconds{6});
+  history.record("Suite::d()", std::chrono::microseconds{5});
+  history.record("Suite::e()", std::chrono::microseconds{4});
+  auto shards = history.assignShards({"Suite::e()", "Suite::d()", "Suite::c()", "Suite::b()", "Suite::a()"}, 2);
+  // longest first: a -> 0, b -> 1, c -> 1 (13), d -> 0 (13), e -> 0 (17)
+  std::vector<unsigned> expected{0, 0, 1, 1, 0};
+  TEST_ASSERT_EQUALS(expected, shards);
+}
+
+void TestTimingHistory::testUnknownDurations() {
+  TimingHistory history;
+  history.record("Suite::a()", std::chrono::microseconds{100});
+  history.record("Suite::b()", std::chrono::microseconds{50});
+  // the unknown test-methods are estimated with the mean of 75 us
+  auto shards = history.assignShards({"Suite::a()", "Suite::b()", "Suite::x()", "Suite::y()"}, 2);
+  // a -> 0, x -> 1, y -> 1 (150), b -> 0 (150)
+  std::vector<unsigned> expected{0, 0, 1, 1};
+  TEST_ASSERT_EQUALS(expected, shards);
+}
+
+void TestTimingHistory::testSaveAndLoad() {
+  const std::string fileName = "timing-history-test.txt";
+  {
+    TimingHistory history;
+    TEST_ASSERT_FALSE(history.load("no-such-timing-history.txt"));
+    TEST_ASSERT(history.empty());
+    history.record("Suite::simple()", std::chrono::microseconds{42});
+    history.record("Suite::withArgs(with spaces\nand newlines)", std::chrono::microseconds{17});
+    history.save(fileName);
+  }
+  TimingHistory history;
+  TEST_ASSERT(history.load(fileName));
+  std::chrono::microseconds duration{};
+  TEST_ASSERT(history.lookup("Suite::simple()", duration));
+  TEST_ASSERT_EQUALS(42, duration.count());
+  TEST_ASSERT(history.lookup("Suite::withArgs(with spaces\nand newlines)", duration));
+  TEST_ASSERT_EQUALS(17, duration.count());
+  TEST_ASSERT_FALSE(history.lookup("Suite::other()", duration));
+  std::remove(fileName.c_str());
+}
+
+void TestTimingHistory::testMovingAverage() {
+  TimingHistory history;
+  history.record("Suite::a()", std::chrono::microseconds{100});
+  TimingHistory::Statistics statistics;
+  TEST_ASSERT(history.lookup("Suite::a()", statistics));
+  TEST_ASSERT_EQUALS(1U, statistics.numRuns);
+  TEST_ASSERT_DELTA(100.0, statistics.mean, 0.001);
+  TEST_ASSERT_DELTA(0.0, statistics.variance, 0.001);
+
+  history.record("Suite::a()", std::chrono::microseconds{200});
+  TEST_ASSERT(history.lookup("Suite::a()", statistics));
+  TEST_ASSERT_EQUALS(2U, statistics.numRuns);
+  // 100 + 0.25 * (200 - 100)
+  TEST_ASSERT_DELTA(125.0, statistics.mean, 0.001);
+  // (1 - 0.25) * (0 + 100 * 25)
+  TEST_ASSERT_DELTA(1875.0, statistics.variance, 0.001);
+
+  // variances below one square microsecond survive saving and loading
+  history.record("Suite::b()", std::chrono::microseconds{100});
+  history.record("Suite::b()", std::chrono::microseconds{101});
+
+  const std::string fileName = "timing-history-average.txt";
+  history.save(fileName);
+  TimingHistory loaded;
+  TEST_ASSERT(loaded.load(fileName));
+  TEST_ASSERT(loaded.lookup("Suite::a()", statistics));
+  TEST_ASSERT_EQUALS(2U, statistics.numRuns);
+  TEST_ASSERT_EQUALS(125.0, statistics.mean);
+  TEST_ASSERT_EQUALS(1875.0, statistics.variance);
+  TEST_ASSERT(loaded.lookup("Suite::b()", statistics));
+  TEST_ASSERT_EQUALS(100.25, statistics.mean);
+  // (1 - 0.25) * (0 + 1 * 0.25)
+  TEST_ASSERT_EQUALS(0.1875, statistics.variance);
+  std::remove(fileName.c_str());
+}
+
+void TestTimingHistory::testLongestFirst() {
+  TimingHistory history;
+  history.record("Suite::a()", std::chrono::microseconds{10});
+  history.record("Suite::b()", std::chrono::microseconds{30});
+  history.record("Suite::c()", std::chrono::microseconds{20});
+  // the unknown test-methods are estimated with the mean of 20 us and stay in order with c
+  auto order = history.orderLongestFirst({"Suite::a()", "Suite::x()", "Suite::b()", "Suite::c()", "Suite::y()"});
+  std::vector<std::size_t> expected{2, 1, 3, 4, 0};
+  TEST_ASSERT_EQUALS(expected, order);
+}
+
+void TestTimingHistory::testInvalidFile() {
+  const std::string fileName = "timing-history-invalid.txt";
+  {
+    std::ofstream out(fileName);
+    out << "100 3 foo" << std::endl;
+  }
+  TimingHistory history;
+  TEST_ASSERT_FALSE(history.load(fileName));
+  TEST_ASSERT(history.empty());
+  std::remove(fileName.c_str());
+}
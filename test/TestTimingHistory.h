@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../include/cpptest.h"
+
+class TestTimingHistory : public Test::Suite {
+public:
+  TestTimingHistory();
+
+  void testHashedShards();
+  void testBalancedShards();
+  void testUnknownDurations();
+  void testSaveAndLoad();
+  void testMovingAverage();
+  void testLongestFirst();
+  void testInvalidFile();
+};
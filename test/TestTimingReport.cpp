@@ -0,0 +1,150 @@
+#include "TestTimingReport.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace Test;
+
+namespace {
+  class SlowFixtureSuite : public Suite {
+  public:
+    SlowFixtureSuite() : Suite("SlowFixtureSuite") { TEST_ADD(SlowFixtureSuite::testMethod); }
+
+    void testMethod() { TEST_ASSERT(true); }
+
+  protected:
+    bool setup() override {
+      std::this_thread::sleep_for(std::chrono::milliseconds{2});
+      return true;
+    }
+
+    bool before(const std::string &methodName) override {
+      (void)methodName;
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      return true;
+    }
+  };
+
+  // activates the report for its lifetime and restores the report used to run this suite, if any
+  class ActiveReport {
+  public:
+    explicit ActiveReport(TimingReport &report) : previous(TimingReport::getActive()) {
+      TimingReport::setActive(&report);
+    }
+    ~ActiveReport() { TimingReport::setActive(previous); }
+
+  private:
+    TimingReport *previous;
+  };
+} // namespace
+
+TestTimingReport::TestTimingReport() : Test::Suite("TestTimingReport") {
+  TEST_ADD(TestTimingReport::testSlowest);
+  TEST_ADD(TestTimingReport::testPhases);
+  TEST_ADD(TestTimingReport::testFixtures);
+  TEST_ADD(TestTimingReport::testParallelEfficiency);
+  TEST_ADD(TestTimingReport::testPrint);
+}
+
+void TestTimingReport::testSlowest() {
+  TimingReport report(2);
+  report.recordTestMethod("Suite::a()", std::chrono::nanoseconds{30});
+  report.recordTestMethod("Suite::b()", std::chrono::nanoseconds{10});
+  report.recordTestMethod("Suite::c()", std::chrono::nanoseconds{50});
+  report.recordTestMethod("Suite::d()", std::chrono::nanoseconds{20});
+  auto slowest = report.getSlowestTestMethods();
+  TEST_ASSERT_EQUALS(2u, slowest.size());
+  TEST_ASSERT_EQUALS("Suite::c()", slowest[0].name);
+  TEST_ASSERT_EQUALS(50, slowest[0].duration.count());
+  TEST_ASSERT_EQUALS("Suite::a()", slowest[1].name);
+
+  report.recordSuite("Fast", std::chrono::nanoseconds{1});
+  report.recordSuite("Slow", std::chrono::nanoseconds{100});
+  report.recordSuite("Medium", std::chrono::nanoseconds{10});
+  slowest = report.getSlowestSuites();
+  TEST_ASSERT_EQUALS(2u, slowest.size());
+  TEST_ASSERT_EQUALS("Slow", slowest[0].name);
+  TEST_ASSERT_EQUALS("Medium", slowest[1].name);
+
+  TimingReport empty(0);
+  empty.recordTestMethod("Suite::a()", std::chrono::nanoseconds{30});
+  TEST_ASSERT(empty.getSlowestTestMethods().empty());
+}
+
+void TestTimingReport::testPhases() {
+  TimingReport report(1);
+  report.recordTestMethod("Suite::a()", std::chrono::nanoseconds{30});
+  // not kept as slowest, but still accounted
+  report.recordTestMethod("Suite::b()", std::chrono::nanoseconds{10});
+  report.recordPhase(TimingReport::Phase::SUITE_FIXTURE, std::chrono::nanoseconds{5});
+  report.recordPhase(TimingReport::Phase::METHOD_FIXTURE, std::chrono::nanoseconds{7});
+  report.recordPhase(TimingReport::Phase::METHOD_FIXTURE, std::chrono::nanoseconds{3});
+  TEST_ASSERT_EQUALS(40, report.getPhaseDuration(TimingReport::Phase::TEST_METHOD).count());
+  TEST_ASSERT_EQUALS(5, report.getPhaseDuration(TimingReport::Phase::SUITE_FIXTURE).count());
+  TEST_ASSERT_EQUALS(10, report.getPhaseDuration(TimingReport::Phase::METHOD_FIXTURE).count());
+}
+
+void TestTimingReport::testFixtures() {
+  TimingReport report(5);
+  {
+    ActiveReport active(report);
+    SlowFixtureSuite suite;
+    std::stringstream stream;
+    TextOutput textOutput(TextOutput::Terse, stream);
+    TEST_ASSERT(suite.run(textOutput));
+  }
+  TEST_ASSERT(report.getPhaseDuration(TimingReport::Phase::SUITE_FIXTURE) >= std::chrono::milliseconds{2});
+  TEST_ASSERT(report.getPhaseDuration(TimingReport::Phase::METHOD_FIXTURE) >= std::chrono::milliseconds{1});
+  auto methods = report.getSlowestTestMethods();
+  TEST_ASSERT_EQUALS(1u, methods.size());
+  // the name of the suite precedes the full name of the test-method, which contains the declaring class
+  TEST_ASSERT_EQUALS("SlowFixtureSuite::SlowFixtureSuite::testMethod()", methods[0].name);
+  auto suites = report.getSlowestSuites();
+  TEST_ASSERT_EQUALS(1u, suites.size());
+  TEST_ASSERT_EQUALS("SlowFixtureSuite", suites[0].name);
+  // includes the fixtures
+  TEST_ASSERT(suites[0].duration >= std::chrono::milliseconds{3});
+}
+
+void TestTimingReport::testParallelEfficiency() {
+  TimingReport::ParallelRun run{"Suite", std::chrono::milliseconds{30}, std::chrono::milliseconds{10}, 4};
+  TEST_ASSERT_DELTA(0.75, run.getEfficiency(), 0.0001);
+  run.wallTime = std::chrono::nanoseconds::zero();
+  TEST_ASSERT_DELTA(0.0, run.getEfficiency(), 0.0001);
+
+  TimingReport report(5);
+  {
+    ActiveReport active(report);
+    ParallelSuite suite("ParallelFixtures");
+    suite.add(std::make_shared<SlowFixtureSuite>());
+    suite.add(std::make_shared<SlowFixtureSuite>());
+    std::stringstream stream;
+    TextOutput textOutput(TextOutput::Terse, stream);
+    TEST_ASSERT(suite.run(textOutput, suite.listTests(), true));
+  }
+  auto runs = report.getParallelRuns();
+  TEST_ASSERT_EQUALS(1u, runs.size());
+  TEST_ASSERT_EQUALS("ParallelFixtures", runs[0].suiteName);
+  TEST_ASSERT(runs[0].numWorkers >= 1u);
+  // both sub-suites sleep for at least 3 ms
+  TEST_ASSERT(runs[0].busyTime >= std::chrono::milliseconds{6});
+  TEST_ASSERT(runs[0].getEfficiency() > 0.0);
+  TEST_ASSERT_EQUALS(2u, report.getSlowestSuites().size());
+}
+
+void TestTimingReport::testPrint() {
+  TimingReport report(3);
+  report.recordTestMethod("Suite::slow()", std::chrono::microseconds{1500});
+  report.recordSuite("Suite", std::chrono::milliseconds{2});
+  report.recordPhase(TimingReport::Phase::SUITE_FIXTURE, std::chrono::microseconds{500});
+  report.recordParallelRun("Parallel", std::chrono::milliseconds{3}, std::chrono::milliseconds{2}, 2);
+  std::stringstream stream;
+  report.print(stream);
+  const std::string text = stream.str();
+  TEST_ASSERT(text.find("Slowest 1 test-methods:") != std::string::npos);
+  TEST_ASSERT(text.find("1.500 ms  Suite::slow()") != std::string::npos);
+  TEST_ASSERT(text.find("2.000 ms  Suite\n") != std::string::npos);
+  TEST_ASSERT(text.find("setup()/tear_down()   500.000 us (25.00%)") != std::string::npos);
+  TEST_ASSERT(text.find("test-methods            1.500 ms (75.00%)") != std::string::npos);
+  TEST_ASSERT(text.find("Parallel: 75.00% (busy 3.000 ms, wall 2.000 ms, 2 workers)") != std::string::npos);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../include/cpptest.h"
+
+class TestTimingReport : public Test::Suite {
+public:
+  TestTimingReport();
+
+  void testSlowest();
+  void testPhases();
+  void testFixtures();
+  void testParallelEfficiency();
+  void testPrint();
+};
@@ -0,0 +1,128 @@
+/*
+ * Micro-benchmark for the success path of the assertion macros.
+ *
+ * Runs every assertion macro in a tight loop with an output not reporting successful assertions and counts the heap
+ * allocations made in the meantime. Exits with a non-zero code if any passing assertion allocates memory.
+ */
+#include "cpptest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<uint64_t> numAllocations{0};
+static std::atomic<uint64_t> numAllocatedBytes{0};
+
+void *operator new(std::size_t size) {
+  ++numAllocations;
+  numAllocatedBytes += size;
+  if (void *ptr = std::malloc(size != 0 ? size : 1))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+static constexpr unsigned NUM_ITERATIONS = 1000000;
+
+class BenchAssertions : public Test::Suite {
+public:
+  struct Result {
+    std::string name;
+    std::chrono::nanoseconds duration;
+    uint64_t allocations;
+    uint64_t bytes;
+  };
+
+  BenchAssertions() : Test::Suite("BenchAssertions"), text("Some text long enough to not fit into the SSO buffer") {
+    TEST_ADD(BenchAssertions::benchAssert);
+    TEST_ADD(BenchAssertions::benchAssertMsg);
+    TEST_ADD(BenchAssertions::benchAssertFalse);
+    TEST_ADD(BenchAssertions::benchAssertEquals);
+    TEST_ADD(BenchAssertions::benchAssertNotEquals);
+    TEST_ADD(BenchAssertions::benchAssertDelta);
+    TEST_ADD(BenchAssertions::benchStringEquals);
+    TEST_ADD(BenchAssertions::benchThrowsNothing);
+  }
+
+  void benchAssert() {
+    measure("TEST_ASSERT", [this](unsigned i) { TEST_ASSERT(i < NUM_ITERATIONS); });
+  }
+
+  void benchAssertMsg() {
+    measure("TEST_ASSERT_MSG", [this](unsigned i) {
+      TEST_ASSERT_MSG(i < NUM_ITERATIONS, "A user message long enough to not fit into the SSO buffer");
+    });
+  }
+
+  void benchAssertFalse() {
+    measure("TEST_ASSERT_FALSE", [this](unsigned i) { TEST_ASSERT_FALSE(i >= NUM_ITERATIONS); });
+  }
+
+  void benchAssertEquals() {
+    measure("TEST_ASSERT_EQUALS", [this](unsigned i) { TEST_ASSERT_EQUALS(i, i); });
+  }
+
+  void benchAssertNotEquals() {
+    measure("TEST_ASSERT_NOT_EQUALS", [this](unsigned i) { TEST_ASSERT_NOT_EQUALS(i, i + 1); });
+  }
+
+  void benchAssertDelta() {
+    measure("TEST_ASSERT_DELTA", [this](unsigned i) { TEST_ASSERT_DELTA(1.0 * i, 1.0 * i + 0.5, 1.0); });
+  }
+
+  void benchStringEquals() {
+    measure("TEST_STRING_EQUALS", [this](unsigned) {
+      TEST_STRING_EQUALS("Some text long enough to not fit into the SSO buffer", text);
+    });
+  }
+
+  void benchThrowsNothing() {
+    measure("TEST_THROWS_NOTHING", [this](unsigned i) { TEST_THROWS_NOTHING(static_cast<void>(i)); });
+  }
+
+  std::vector<Result> results;
+
+private:
+  const std::string text;
+
+  template <typename Func>
+  void measure(const char *name, Func &&func) {
+    const uint64_t allocationsBefore = numAllocations;
+    const uint64_t bytesBefore = numAllocatedBytes;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < NUM_ITERATIONS; ++i)
+      func(i);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    const uint64_t allocations = numAllocations - allocationsBefore;
+    const uint64_t bytes = numAllocatedBytes - bytesBefore;
+    results.push_back(Result{name, std::chrono::duration_cast<std::chrono::nanoseconds>(duration), allocations, bytes});
+  }
+};
+
+int main() {
+  // the terse text output does not report successful assertions
+  Test::TextOutput output(Test::TextOutput::Terse);
+  BenchAssertions bench;
+  bool success = bench.run(output, false);
+
+  std::cout << std::left << std::setw(24) << "Assertion" << std::right << std::setw(14) << "ns/assertion"
+            << std::setw(14) << "allocations" << std::setw(14) << "bytes" << std::endl;
+  for (const auto &result : bench.results) {
+    std::cout << std::left << std::setw(24) << result.name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(2) << (static_cast<double>(result.duration.count()) / NUM_ITERATIONS)
+              << std::setw(14) << result.allocations << std::setw(14) << result.bytes << std::endl;
+    success = success && result.allocations == 0;
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+/*
+ * Micro-benchmark comparing the contention of the thread-safe outputs.
+ *
+ * Multiple threads report test-method results concurrently to a SynchronizedOutput (one lock per event) and to an
+ * AsyncOutput (per-thread buffers drained by a writer thread), both writing to a text output discarding the text.
+ * Reports the time the reporting threads are blocked and the total time until all events are written.
+ *
+ * Usage: benchOutputs [<events per thread>] [<number of threads>]
+ */
+#include "cpptest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  // formats all text, but does not write it anywhere
+  class NullBuffer : public std::streambuf {
+  protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+  };
+
+  struct Result {
+    std::chrono::nanoseconds reportDuration;
+    std::chrono::nanoseconds totalDuration;
+  };
+
+  Result runBenchmark(Test::Output &output, unsigned numThreads, unsigned numEvents) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < numThreads; ++i) {
+      threads.emplace_back([&output, i, numEvents]() {
+        const std::string methodName = "BenchSuite::method" + std::to_string(i);
+        for (unsigned k = 0; k < numEvents; ++k)
+          // failed test-methods are printed in verbose mode
+          output.finishTestMethod(
+              "BenchSuite", methodName, std::to_string(k), false, std::chrono::nanoseconds{k});
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    const auto reported = std::chrono::steady_clock::now();
+    output.flush();
+    const auto end = std::chrono::steady_clock::now();
+    return Result{std::chrono::duration_cast<std::chrono::nanoseconds>(reported - start),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)};
+  }
+
+  void printResult(const std::string &name, const Result &result, uint64_t numEvents) {
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(20) << (static_cast<double>(result.reportDuration.count()) / static_cast<double>(numEvents))
+              << std::setw(20) << (static_cast<double>(result.totalDuration.count()) / static_cast<double>(numEvents))
+              << std::endl;
+  }
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const unsigned numEvents = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : 20000;
+  const unsigned numThreads =
+      argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : std::max(2U, std::thread::hardware_concurrency());
+  const uint64_t totalEvents = static_cast<uint64_t>(numEvents) * numThreads;
+
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  std::cout << numThreads << " threads reporting " << numEvents << " events each" << std::endl;
+  std::cout << std::left << std::setw(20) << "Output" << std::right << std::setw(20) << "ns/event (report)"
+            << std::setw(20) << "ns/event (total)" << std::endl;
+  {
+    Test::TextOutput textOutput(Test::TextOutput::Verbose, stream);
+    Test::SynchronizedOutput output(textOutput);
+    printResult("SynchronizedOutput", runBenchmark(output, numThreads, numEvents), totalEvents);
+  }
+  {
+    Test::TextOutput textOutput(Test::TextOutput::Verbose, stream);
+    Test::AsyncOutput output(textOutput);
+    printResult("AsyncOutput", runBenchmark(output, numThreads, numEvents), totalEvents);
+  }
+  return EXIT_SUCCESS;
+}
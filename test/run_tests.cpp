@@ -3,10 +3,14 @@
 #include "../include/cpptest-main.h"
 #include "TestAssertions.h"
 #include "TestBDD.h"
+#include "TestBenchmarkSuite.h"
 #include "TestFormat.h"
 #include "TestMacros.h"
 #include "TestOutputs.h"
 #include "TestParallelSuite.h"
+#include "TestPerfCounters.h"
+#include "TestTimingHistory.h"
+#include "TestTimingReport.h"
 
 using namespace std;
 
@@ -27,7 +31,29 @@ int main(int argc, char *argv[]) {
   Test::registerSuite(Test::newInstance<TestOutputs>, "test-outputs", "Tests the various output types",
       Test::RegistrationFlags::OMIT_LIST_TESTS);
   Test::registerSuite(Test::newInstance<TestParallelSuite>, "test-parallel", "Tests the parallel test suite");
+  Test::registerSuite(Test::newInstance<TestParallelMethods>, "test-parallel-methods",
+      "Tests running the test-methods of a suite in parallel", Test::RegistrationFlags::PARALLEL_METHODS);
+  Test::registerSuite(Test::newInstance<CrashTestSuite>, "crash-tests",
+      "Tests the handling of crashing tests, requires --isolate=process",
+      Test::RegistrationFlags::OMIT_FROM_DEFAULT | Test::RegistrationFlags::OMIT_LIST_TESTS);
+  Test::registerSuite(Test::newInstance<TimeoutTestSuite>, "timeout-tests", "Tests the handling of timed out tests",
+      Test::RegistrationFlags::OMIT_FROM_DEFAULT | Test::RegistrationFlags::OMIT_LIST_TESTS);
+  Test::registerSuite(Test::newInstance<LifetimeTestSuite>, "lifetime-tests", "Tests the lifetime of the suites",
+      Test::RegistrationFlags::OMIT_FROM_DEFAULT | Test::RegistrationFlags::OMIT_LIST_TESTS);
+  Test::registerSuite(Test::newInstance<LifetimeTestSuite>, "lifetime-tests-again",
+      "Tests the lifetime of the suites (second instance)",
+      Test::RegistrationFlags::OMIT_FROM_DEFAULT | Test::RegistrationFlags::OMIT_LIST_TESTS);
+  Test::registerSuite(Test::newInstance<TestTimingHistory>, "test-timing-history",
+      "Tests the timing history and the sharding of test-methods");
+  Test::registerSuite(Test::newInstance<TestTimingReport>, "test-timing-report",
+      "Tests the summary of the durations of test-methods, suites and fixtures");
   Test::registerSuite(Test::newInstance<TestAssertions>, "test-assertions", "Tests the available TEST_XXX assertions");
+  Test::registerSuite(Test::newInstance<TestBenchmarkSuite>, "test-benchmarks",
+      "Tests the calibration and reporting of benchmarks");
+  Test::registerSuite(Test::newInstance<TestPerfCounters>, "test-perf-counters",
+      "Tests the measurement and reporting of performance counters");
+  Test::registerSuite(Test::newInstance<ExampleBenchmarks>, "benchmark-examples", "Runs the example benchmarks",
+      Test::RegistrationFlags::OMIT_FROM_DEFAULT);
   Test::registerSuite(
       Test::newInstance<Story1>, "story1", "Runs the first BDD story", Test::RegistrationFlags::OMIT_FROM_DEFAULT);
   Test::registerSuite(Test::newInstance<Story2>, "story2", "Runs the second BDD story");
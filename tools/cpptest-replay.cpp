@@ -0,0 +1,125 @@
+/*
+ * Replays the binary event logs written with --output=binary into any other output, e.g. to render the JUnit or HTML
+ * report of multiple shards offline.
+ */
+#include "cpptest.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static void printHelp(const std::string &progName) {
+  static const int paramWidth = 30;
+  static const int gapWidth = 4;
+  std::cout << "Replays the binary event logs written by a test run with '--output=binary' into the given output. "
+               "Multiple logs are replayed in the given order."
+            << std::endl;
+  std::cout << "Usage: " << progName << " [options] <log-file>..." << std::endl;
+  std::cout << std::setw(paramWidth) << "--output=val" << std::setw(gapWidth) << " "
+            << "Sets the output to replay into. Available options are: plain, colored, gcc, msvc, generic, junit, "
+               "ndjson, html. Defaults to 'plain'"
+            << std::endl;
+  std::cout << std::setw(paramWidth) << "--mode=val" << std::setw(gapWidth) << " "
+            << "Sets the output mode to one of 'debug', 'verbose', 'terse' in order of the amount of information "
+               "printed. Defaults to 'terse'"
+            << std::endl;
+  std::cout << std::setw(paramWidth) << "--output-file=file" << std::setw(gapWidth) << " "
+            << "Sets the optional output file to write to, defaults to 'stdout'" << std::endl;
+  std::cout << std::setw(paramWidth) << "--memory-limit=<MiB>" << std::setw(gapWidth) << " "
+            << "Moves the completed suites collected for the 'html' output to a temporary file once the limit is "
+               "exceeded"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::string outputMode = "plain";
+  std::string outputFile;
+  unsigned int mode = Test::TextOutput::Terse;
+  std::size_t memoryLimit = 0;
+  std::vector<std::string> logFiles;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--help" || arg == "-h") {
+      printHelp(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (arg.find("--output=") == 0) {
+      outputMode = arg.substr(arg.find('=') + 1);
+    } else if (arg.find("--output-file=") == 0) {
+      outputFile = arg.substr(arg.find('=') + 1);
+    } else if (arg.find("--memory-limit=") == 0) {
+      try {
+        memoryLimit = static_cast<std::size_t>(std::stoul(arg.substr(arg.find('=') + 1))) * 1024 * 1024;
+      } catch (const std::exception &) {
+        std::cerr << "Invalid memory limit: " << arg << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (arg.find("--mode=") == 0) {
+      if (arg == "--mode=debug")
+        mode = Test::TextOutput::Debug;
+      else if (arg == "--mode=verbose")
+        mode = Test::TextOutput::Verbose;
+      else if (arg == "--mode=terse")
+        mode = Test::TextOutput::Terse;
+      else {
+        std::cerr << "Unrecognized output mode: " << arg << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (arg.find("--") == 0) {
+      std::cerr << "Unrecognized argument: " << arg << std::endl;
+      return EXIT_FAILURE;
+    } else
+      logFiles.push_back(arg);
+  }
+  if (logFiles.empty()) {
+    printHelp(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream f;
+  if (!outputFile.empty())
+    f.open(outputFile, std::ios_base::out | std::ios_base::trunc);
+  std::ostream &stream = outputFile.empty() ? std::cout : f;
+
+  std::unique_ptr<Test::Output> output;
+  Test::HTMLOutput *htmlOutput = nullptr;
+  if (outputMode == "plain")
+    output.reset(new Test::TextOutput(mode, stream));
+  else if (outputMode == "colored")
+    output.reset(new Test::ConsoleOutput(mode));
+  else if (outputMode == "gcc")
+    output.reset(new Test::CompilerOutput(Test::CompilerOutput::FORMAT_GCC, stream));
+  else if (outputMode == "msvc")
+    output.reset(new Test::CompilerOutput(Test::CompilerOutput::FORMAT_MSVC, stream));
+  else if (outputMode == "generic")
+    output.reset(new Test::CompilerOutput(Test::CompilerOutput::FORMAT_GENERIC, stream));
+  else if (outputMode == "junit") {
+    // only a file opened by the output itself is seeked to patch in the attributes of the suites
+    f.close();
+    output.reset(outputFile.empty() ? new Test::XMLOutput(std::cout) : new Test::XMLOutput(outputFile));
+  }
+  else if (outputMode == "ndjson")
+    output.reset(new Test::NDJSONOutput(stream));
+  else if (outputMode == "html") {
+    htmlOutput = new Test::HTMLOutput(memoryLimit);
+    output.reset(htmlOutput);
+  } else {
+    std::cerr << "Unrecognized output: " << outputMode << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (const auto &logFile : logFiles) {
+    try {
+      Test::replayBinaryLog(logFile, *output);
+    } catch (const std::exception &ex) {
+      std::cerr << logFile << ": " << ex.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (htmlOutput)
+    htmlOutput->generate(stream, true);
+  output->flush();
+  return EXIT_SUCCESS;
+}